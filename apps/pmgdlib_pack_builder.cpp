@@ -0,0 +1,51 @@
+#include <cxxopts.hpp>
+#include <filesystem>
+
+#include <pmgdlib_msg.h>
+#include <pmgdlib_pack.h>
+
+using namespace std;
+using namespace pmgd;
+
+int main(int argc, char** argv){
+  cxxopts::Options options("pmPackBuilder", "pack asset files into one archive");
+  options.add_options()
+    ("v,verbose", "verbose level; 0=SILENCE,5=VERBOSE", cxxopts::value<int>()->default_value(to_string(pmgd::verbose::INFO)))
+    ("o,output", "path to the output pack", cxxopts::value<std::string>())
+    ("c,compress", "compress entries with LZ, entries which don't compress are stored as is")
+    ("r,root", "entries are stored relative to this directory", cxxopts::value<std::string>()->default_value(""))
+    ("inputs", "files & directories to pack, directories are added recursively", cxxopts::value<std::vector<std::string>>())
+    ("h,help", "Print usage")
+  ;
+  options.parse_positional({"inputs"});
+
+  auto result = options.parse(argc, argv);
+  if(result.count("help") or not result.count("output") or not result.count("inputs")){
+    std::cout << options.help() << std::endl;
+    exit(0);
+  }
+
+  msg_verbose_lvl() = result["verbose"].as<int>();
+  std::string root = result["root"].as<std::string>();
+  int codec = result.count("compress") ? pack_codec::LZ : pack_codec::RAW;
+
+  /// stored path is the path used in configs, e.g. "data/t1.png"
+  PackBuilder builder;
+  auto add = [&](const std::filesystem::path & path){
+    std::string stored = root.size() ? std::filesystem::relative(path, root).string() : path.string();
+    return builder.AddFile(stored, path.string(), codec);
+  };
+
+  int ret = PM_SUCCESS;
+  for(auto & input : result["inputs"].as<std::vector<std::string>>()){
+    if(std::filesystem::is_directory(input)){
+      for(auto & it : std::filesystem::recursive_directory_iterator(input))
+        if(it.is_regular_file() and add(it.path()) != PM_SUCCESS) ret = PM_ERROR_IO;
+    } else if(add(input) != PM_SUCCESS) ret = PM_ERROR_IO;
+  }
+  if(ret != PM_SUCCESS) return ret;
+
+  ret = builder.Write(result["output"].as<std::string>());
+  msg("packed", builder.Size(), "files into", quote(result["output"].as<std::string>()));
+  return ret;
+}
@@ -0,0 +1,60 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef BENCH_BLEND_HH
+#define BENCH_BLEND_HH 1
+
+#include "pmgdlib_blend.h"
+
+/// 1 MP row of random pixels composited into another, argument is the simd level
+template<typename F> static void bench_blend_kernel(benchmark::State& state, F kernel){
+  if(not bench_pixel_level(state)) return;
+  std::vector<uint8_t> src = bench_pixel_bytes(BENCH_PIXELS * 4), dst(src.rbegin(), src.rend()), back(dst);
+  for (auto _ : state) {
+    kernel(src.data(), dst.data(), BENCH_PIXELS);
+    benchmark::DoNotOptimize(dst.data());
+    benchmark::ClobberMemory();
+    state.PauseTiming();
+    dst = back;
+    state.ResumeTiming();
+  }
+  state.counters["MP/s"] = benchmark::Counter(state.iterations() * BENCH_PIXELS / 1e6, benchmark::Counter::kIsRate);
+  simd_set_level(simd_detect());
+}
+
+static void BM_blend_over(benchmark::State& state){ bench_blend_kernel(state, blend_row_over); }
+static void BM_blend_over_premul(benchmark::State& state){ bench_blend_kernel(state, blend_row_over_premul); }
+static void BM_blend_add(benchmark::State& state){ bench_blend_kernel(state, blend_row_add); }
+static void BM_blend_tint(benchmark::State& state){
+  const uint8_t color[4] = {230, 77, 153, 179};
+  bench_blend_kernel(state, [&](const uint8_t * src, uint8_t * dst, size_t n){ blend_row_tint(src, dst, n, color); });
+}
+
+BENCHMARK(BM_blend_over)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_blend_over_premul)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_blend_add)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_blend_tint)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+
+/// 1024 x 1024 sprite sheet scaled over a 720p frame, rows are blitted on the pool threads, so the rates are per wall time
+static void bench_blit(benchmark::State& state, int filter){
+  if(not bench_pixel_level(state)) return;
+  std::vector<uint8_t> bytes = bench_pixel_bytes(BENCH_PIXELS * 4);
+  auto src = std::make_shared<Image>(1024, 1024);
+  memcpy(src->data, bytes.data(), bytes.size());
+  auto dst = std::make_shared<Image>(1280, 720);
+  memset(dst->data, 0, dst->Bytes());
+  for (auto _ : state) {
+    blit_scaled(ImageView(src), ImageView(dst), 0, 0, 1280, 720, filter, blend_mode::OVER);
+    benchmark::DoNotOptimize(dst->data);
+    benchmark::ClobberMemory();
+  }
+  state.counters["MP/s"] = benchmark::Counter(state.iterations() * 1280 * 720 / 1e6, benchmark::Counter::kIsRate);
+  simd_set_level(simd_detect());
+}
+
+static void BM_blit_nearest(benchmark::State& state){ bench_blit(state, blit_filter::NEAREST); }
+static void BM_blit_bilinear(benchmark::State& state){ bench_blit(state, blit_filter::BILINEAR); }
+
+BENCHMARK(BM_blit_nearest)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_blit_bilinear)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+#endif
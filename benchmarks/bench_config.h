@@ -0,0 +1,70 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef BENCH_CONFIG_HH
+#define BENCH_CONFIG_HH 1
+
+#include "pmgdlib_config.h"
+
+//! the same machine-generated content as xml & json: n textures, n scenes with 8 layers each
+static std::string bench_cfg_content(int n, bool json){
+  std::string raw = json ? "{\n  \"texture\": [\n" : "";
+  for(int i = 0; i < n; ++i){
+    std::string id = "texture_" + std::to_string(i);
+    if(json) raw += std::string(i ? ",\n" : "") + "    {\"id\": \"" + id + "\", \"path\": \"data/textures/" + id + ".png\", \"width\": 256, \"height\": 256}";
+    else raw += "<texture id=\"" + id + "\" path=\"data/textures/" + id + ".png\" width=\"256\" height=\"256\"/>\n";
+  }
+  if(json) raw += "\n  ],\n  \"scene\": [\n";
+  for(int i = 0; i < n; ++i){
+    std::string id = "scene_" + std::to_string(i);
+    if(json) raw += std::string(i ? ",\n" : "") + "    {\"id\": \"" + id + "\", \"layer\": [";
+    else raw += "<scene id=\"" + id + "\">\n";
+    for(int l = 0; l < 8; ++l){
+      std::string layer = id + "_layer_" + std::to_string(l);
+      if(json) raw += std::string(l ? ", " : "") + "{\"id\": \"" + layer + "\", \"texture\": \"texture_" + std::to_string(i) + "\", \"z\": " + std::to_string(l) + "}";
+      else raw += "  <layer id=\"" + layer + "\" texture=\"texture_" + std::to_string(i) + "\" z=\"" + std::to_string(l) + "\"/>\n";
+    }
+    raw += json ? "]}" : "</scene>\n";
+  }
+  if(json) raw += "\n  ]\n}\n";
+  return raw;
+}
+
+//! ConfigItem does not own nested items
+static void bench_cfg_free(ConfigItem* item){
+  for(auto & it : item->nested)
+    for(ConfigItem* nested : it.second){
+      bench_cfg_free(nested);
+      delete nested;
+    }
+  item->nested.clear();
+}
+
+static void bench_cfg_json(benchmark::State & state){
+  std::string raw = bench_cfg_content(state.range(0), true);
+  for(auto _ : state){
+    auto cfg = load_cfg(raw, "bench");
+    benchmark::DoNotOptimize(cfg);
+    state.PauseTiming();
+    bench_cfg_free(cfg.get());
+    state.ResumeTiming();
+  }
+  state.SetBytesProcessed(state.iterations() * raw.size());
+}
+BENCHMARK(bench_cfg_json)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+#ifdef USE_TINYXML2
+  static void bench_cfg_xml(benchmark::State & state){
+    std::string raw = bench_cfg_content(state.range(0), false);
+    for(auto _ : state){
+      auto cfg = load_cfg(raw, "bench");
+      benchmark::DoNotOptimize(cfg);
+      state.PauseTiming();
+      bench_cfg_free(cfg.get());
+      state.ResumeTiming();
+    }
+    state.SetBytesProcessed(state.iterations() * raw.size());
+  }
+  BENCHMARK(bench_cfg_xml)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+#endif
+
+#endif
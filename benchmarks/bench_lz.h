@@ -0,0 +1,71 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef BENCH_LZ_HH
+#define BENCH_LZ_HH 1
+
+#include "pmgdlib_lz.h"
+#include "pmgdlib_image.h"
+
+//! RGBA8 sprite-like content: flat areas, gradients and noisy details
+static std::string bench_lz_pixels(int w, int h){
+  std::string answer(size_t(w) * h * 4, '\0');
+  uint32_t seed = 1;
+  for(int y = 0; y < h; ++y)
+    for(int x = 0; x < w; ++x){
+      unsigned char * p = (unsigned char*)answer.data() + (size_t(y) * w + x) * 4;
+      bool flat = ((x / 64) + (y / 64)) % 2;
+      seed = seed * 1103515245 + 12345;
+      p[0] = flat ? 40 : x;
+      p[1] = flat ? 80 : y;
+      p[2] = flat ? 120 : ((x ^ y) & 0xF0) | ((seed >> 16) & 0x3);
+      p[3] = 255;
+    }
+  return answer;
+}
+
+//! bytes read from storage and decode time of the same pixels: LZ stream vs PNG
+static void BM_lz_decompress(benchmark::State& state) {
+  std::string raw = bench_lz_pixels(1024, 1024);
+  std::string packed = lz_compress(raw);
+  std::string out;
+  bool parallel = state.range(0);
+  for (auto _ : state) {
+    lz_decompress(packed, out, parallel);
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetBytesProcessed(state.iterations() * raw.size());
+  state.counters["bytes_read"] = packed.size();
+}
+BENCHMARK(BM_lz_decompress)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+static void BM_lz_compress(benchmark::State& state) {
+  std::string raw = bench_lz_pixels(1024, 1024);
+  bool parallel = state.range(0);
+  size_t size = 0;
+  for (auto _ : state) {
+    std::string packed = lz_compress(raw, LZ_BLOCK_SIZE, parallel);
+    size = packed.size();
+    benchmark::DoNotOptimize(packed.data());
+  }
+  state.SetBytesProcessed(state.iterations() * raw.size());
+  state.counters["bytes_out"] = size;
+}
+BENCHMARK(BM_lz_compress)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+#ifdef USE_STB
+static void BM_png_decode(benchmark::State& state) {
+  std::string raw = bench_lz_pixels(1024, 1024);
+  std::string png;
+  stbi_write_png_to_func([](void * context, void * data, int size){ ((std::string*)context)->append((const char*)data, size); },
+                         &png, 1024, 1024, 4, raw.data(), 0);
+  for (auto _ : state) {
+    std::shared_ptr<Image> img = decode_image_stb(png.data(), png.size());
+    benchmark::DoNotOptimize(img.get());
+  }
+  state.SetBytesProcessed(state.iterations() * raw.size());
+  state.counters["bytes_read"] = png.size();
+}
+BENCHMARK(BM_png_decode)->Unit(benchmark::kMillisecond);
+#endif
+
+#endif
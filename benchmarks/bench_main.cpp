@@ -0,0 +1,14 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <benchmark/benchmark.h>
+
+#include "pmgdlib_std.h"
+using namespace pmgd;
+
+#include "bench_config.h"
+#include "bench_lz.h"
+#include "bench_pixel.h"
+#include "bench_soft.h"
+#include "bench_blend.h"
+
+BENCHMARK_MAIN();
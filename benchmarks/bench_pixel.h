@@ -0,0 +1,103 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef BENCH_PIXEL_HH
+#define BENCH_PIXEL_HH 1
+
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_mip.h"
+#include "pmgdlib_resample.h"
+
+#include <random>
+
+/// 1 MP image, argument is the simd level
+static const size_t BENCH_PIXELS = 1024 * 1024;
+
+static bool bench_pixel_level(benchmark::State& state, int arg = 0){
+  int level = state.range(arg);
+  if(level > simd_detect()){
+    state.SkipWithError("simd level is not supported by the CPU");
+    return false;
+  }
+  simd_set_level(level);
+  state.SetLabel(simd_level_name(level));
+  return true;
+}
+
+static std::vector<uint8_t> bench_pixel_bytes(size_t n){
+  std::mt19937 rng(7);
+  std::vector<uint8_t> answer(n);
+  for(auto & v : answer) v = rng();
+  return answer;
+}
+
+template<typename S, typename D, typename F> static void bench_pixel_kernel(benchmark::State& state, size_t src_channels, F kernel){
+  if(not bench_pixel_level(state)) return;
+  std::vector<uint8_t> bytes = bench_pixel_bytes(BENCH_PIXELS * src_channels);
+  std::vector<S> src(bytes.begin(), bytes.end());
+  if constexpr(std::is_same_v<S, float>) for(auto & v : src) v /= 255.f;
+  std::vector<D> dst(BENCH_PIXELS * 4);
+  for (auto _ : state) {
+    kernel(src.data(), dst.data(), BENCH_PIXELS);
+    benchmark::DoNotOptimize(dst.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * BENCH_PIXELS);
+  state.SetBytesProcessed(state.iterations() * BENCH_PIXELS * (src_channels * sizeof(S) + 4 * sizeof(D)));
+  simd_set_level(simd_detect());
+}
+
+static void BM_pixel_rgba8_to_rgba32f(benchmark::State& state){ bench_pixel_kernel<uint8_t, float>(state, 4, pixel_rgba8_to_rgba32f); }
+static void BM_pixel_rgba32f_to_rgba8(benchmark::State& state){ bench_pixel_kernel<float, uint8_t>(state, 4, pixel_rgba32f_to_rgba8); }
+static void BM_pixel_rgb8_to_rgba8(benchmark::State& state){ bench_pixel_kernel<uint8_t, uint8_t>(state, 3, pixel_rgb8_to_rgba8); }
+static void BM_pixel_swap_rb8(benchmark::State& state){ bench_pixel_kernel<uint8_t, uint8_t>(state, 4, pixel_swap_rb8); }
+static void BM_pixel_premultiply8(benchmark::State& state){ bench_pixel_kernel<uint8_t, uint8_t>(state, 4, pixel_premultiply8); }
+static void BM_pixel_srgb8_to_linear32f(benchmark::State& state){ bench_pixel_kernel<uint8_t, float>(state, 4, pixel_srgb8_to_linear32f); }
+static void BM_pixel_linear32f_to_srgb8(benchmark::State& state){ bench_pixel_kernel<float, uint8_t>(state, 4, pixel_linear32f_to_srgb8); }
+
+BENCHMARK(BM_pixel_rgba8_to_rgba32f)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pixel_rgba32f_to_rgba8)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pixel_rgb8_to_rgba8)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pixel_swap_rb8)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pixel_premultiply8)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pixel_srgb8_to_linear32f)->Arg(simd_level::SCALAR)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_pixel_linear32f_to_srgb8)->Arg(simd_level::SCALAR)->Unit(benchmark::kMicrosecond);
+
+/// full chain of 1 MP sRGB image, argument is the filter
+static void BM_make_mips(benchmark::State& state){
+  std::vector<uint8_t> bytes = bench_pixel_bytes(BENCH_PIXELS * 4);
+  auto img = std::make_shared<Image>(1024, 1024);
+  memcpy(img->data, bytes.data(), bytes.size());
+  for (auto _ : state) {
+    make_mips(img, state.range(0));
+    benchmark::DoNotOptimize(img.get());
+  }
+  state.SetLabel(state.range(0) == mip_filter::BOX ? "BOX" : "KAISER");
+  state.SetItemsProcessed(state.iterations() * BENCH_PIXELS);
+}
+BENCHMARK(BM_make_mips)->Arg(mip_filter::BOX)->Arg(mip_filter::KAISER)->Unit(benchmark::kMillisecond);
+
+/// 1 MP RGBA8 image to a 256 x 256 thumbnail and to 1600 x 1600, arguments are the filter & the simd level,
+/// rows are filtered on the pool threads, so the rates of source pixels are per wall time
+static void bench_resample(benchmark::State& state, int w, int h){
+  int filter = state.range(0);
+  if(not bench_pixel_level(state, 1)) return;
+  std::vector<uint8_t> bytes = bench_pixel_bytes(BENCH_PIXELS * 4);
+  auto src = std::make_shared<Image>(1024, 1024);
+  memcpy(src->data, bytes.data(), bytes.size());
+  auto dst = std::make_shared<Image>(w, h);
+  for (auto _ : state) {
+    resample_image(ImageView(src), ImageView(dst), filter);
+    benchmark::DoNotOptimize(dst->data);
+  }
+  const char * names[] = {"BOX", "BILINEAR", "LANCZOS3"};
+  state.SetLabel(std::string(names[filter]) + " " + simd_level_name(state.range(1)));
+  state.counters["MP/s"] = benchmark::Counter(state.iterations() * BENCH_PIXELS / 1e6, benchmark::Counter::kIsRate);
+  simd_set_level(simd_detect());
+}
+static void BM_resample_down(benchmark::State& state){ bench_resample(state, 256, 256); }
+static void BM_resample_up(benchmark::State& state){ bench_resample(state, 1600, 1600); }
+
+BENCHMARK(BM_resample_down)->ArgsProduct({{resample_filter::BOX, resample_filter::BILINEAR, resample_filter::LANCZOS3}, {simd_level::SCALAR, simd_level::SSE2, simd_level::AVX2}})->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_resample_up)->ArgsProduct({{resample_filter::BOX, resample_filter::BILINEAR, resample_filter::LANCZOS3}, {simd_level::SCALAR, simd_level::SSE2, simd_level::AVX2}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+#endif
\ No newline at end of file
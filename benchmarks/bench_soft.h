@@ -0,0 +1,42 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef BENCH_SOFT_HH
+#define BENCH_SOFT_HH 1
+
+#include "pmgdlib_soft.h"
+
+#include <random>
+
+/// 720p frame of 2000 sprites 32 x 32 pixels, a third of them rotated, argument is the simd level
+/// tiles are drawn on the pool threads, so the rates are per wall time
+static void BM_soft_draw(benchmark::State& state){
+  if(not bench_pixel_level(state)) return;
+  std::vector<uint8_t> bytes = bench_pixel_bytes(256 * 256 * 4);
+  auto tex = std::make_shared<Image>(256, 256);
+  memcpy(tex->data, bytes.data(), bytes.size());
+  auto target = std::make_shared<Image>(1280, 720);
+
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uni(-1, 1);
+  std::vector<SoftQuad> quads;
+  for(int i = 0; i < 2000; ++i){
+    TextureDrawData data(v2(uni(rng), uni(rng)), v2(16.f / 640, 16.f / 360));
+    data.tpos = v2(std::fabs(uni(rng)) * 0.875f, std::fabs(uni(rng)) * 0.875f);
+    data.tsize = v2(0.125f, 0.125f);
+    if(i % 3 == 0) data.angle = 180 * uni(rng);
+    quads.push_back(soft_quad(data));
+  }
+
+  for (auto _ : state) {
+    soft_clear(ImageView(target), rgb(0.f, 0.f, 0.f, 1.f));
+    soft_draw_quads(ImageView(target), ImageView(tex), quads);
+    benchmark::DoNotOptimize(target.get());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * quads.size());
+  state.counters["fps"] = benchmark::Counter(state.iterations(), benchmark::Counter::kIsRate);
+  simd_set_level(simd_detect());
+}
+BENCHMARK(BM_soft_draw)->DenseRange(simd_level::SCALAR, simd_level::AVX2)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+#endif
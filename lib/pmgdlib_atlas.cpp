@@ -0,0 +1,370 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cstring>
+#include <atomic>
+#include <climits>
+#include <algorithm>
+
+#include "pmgdlib_atlas.h"
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= MaxRectsBin ====================================================================
+  bool MaxRectsBin::Insert(int rw, int rh, AtlasRect & out){
+    int best_short = INT_MAX, best_long = INT_MAX;
+    for(auto & f : free_rects){
+      if(f.w < rw or f.h < rh) continue;
+      int dw = f.w - rw, dh = f.h - rh;
+      int s = std::min(dw, dh), l = std::max(dw, dh);
+      if(s > best_short or (s == best_short and l >= best_long)) continue;
+      best_short = s;
+      best_long = l;
+      out = AtlasRect{f.x, f.y, rw, rh};
+    }
+    if(best_short == INT_MAX) return false;
+
+    Split(out);
+    Prune();
+    used_area += size_t(rw) * rh;
+    return true;
+  }
+
+  void MaxRectsBin::Split(const AtlasRect & u){
+    /// every free rectangle overlapped by u is replaced by its maximal parts around u
+    std::vector<AtlasRect> answer;
+    for(auto & f : free_rects){
+      if(not f.Intersects(u)){
+        answer.push_back(f);
+        continue;
+      }
+      if(u.x > f.x) answer.push_back(AtlasRect{f.x, f.y, u.x - f.x, f.h});
+      if(u.x + u.w < f.x + f.w) answer.push_back(AtlasRect{u.x + u.w, f.y, f.x + f.w - u.x - u.w, f.h});
+      if(u.y > f.y) answer.push_back(AtlasRect{f.x, f.y, f.w, u.y - f.y});
+      if(u.y + u.h < f.y + f.h) answer.push_back(AtlasRect{f.x, u.y + u.h, f.w, f.y + f.h - u.y - u.h});
+    }
+    free_rects.swap(answer);
+  }
+
+  void MaxRectsBin::Prune(){
+    std::vector<bool> removed(free_rects.size(), false);
+    for(size_t i = 0; i < free_rects.size(); ++i){
+      if(removed[i]) continue;
+      for(size_t j = 0; j < free_rects.size(); ++j){
+        if(i == j or removed[j] or not free_rects[j].Contains(free_rects[i])) continue;
+        removed[i] = true;
+        break;
+      }
+    }
+    std::vector<AtlasRect> answer;
+    for(size_t i = 0; i < free_rects.size(); ++i)
+      if(not removed[i]) answer.push_back(free_rects[i]);
+    free_rects.swap(answer);
+  }
+
+  void MaxRectsBin::Free(const AtlasRect & r){
+    used_area -= size_t(r.w) * r.h;
+    free_rects.push_back(r);
+    /// grow rectangles over neighbours of the same span, so freed space is not split in slivers
+    for(bool merged = true; merged;){
+      merged = false;
+      for(size_t i = 0; i < free_rects.size() and not merged; ++i){
+        for(size_t j = i + 1; j < free_rects.size() and not merged; ++j){
+          AtlasRect & a = free_rects[i], & b = free_rects[j];
+          if(a.x == b.x and a.w == b.w and a.y <= b.y + b.h and b.y <= a.y + a.h){
+            int y = std::min(a.y, b.y);
+            a.h = std::max(a.y + a.h, b.y + b.h) - y;
+            a.y = y;
+            merged = true;
+          } else if(a.y == b.y and a.h == b.h and a.x <= b.x + b.w and b.x <= a.x + a.w){
+            int x = std::min(a.x, b.x);
+            a.w = std::max(a.x + a.w, b.x + b.w) - x;
+            a.x = x;
+            merged = true;
+          }
+          if(merged) free_rects.erase(free_rects.begin() + j);
+        }
+      }
+    }
+    Prune();
+  }
+
+  // ======= AtlasBuilder ====================================================================
+  int AtlasBuilder::Add(const std::string & name, const ImageView & image){
+    if(index.count(name)){
+      msg_warning("sprite", quote(name), "is already in the atlas");
+      return PM_ERROR_DUPLICATE;
+    }
+    if(not image.Valid()){
+      msg_warning("sprite", quote(name), "has no pixels");
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    }
+    index[name] = sprites.size();
+    sprites.push_back(Sprite{name, image});
+    return PM_SUCCESS;
+  }
+
+  /// copy edge pixels of the sprite rect outwards
+  static void atlas_bleed(const ImageView & page, const AtlasRect & r, int bleed){
+    size_t px = page.PixelBytes();
+    int x0 = std::max(0, r.x - bleed), x1 = std::min(page.w, r.x + r.w + bleed);
+    for(int y = r.y; y < r.y + r.h; ++y){
+      for(int x = x0; x < r.x; ++x) memcpy(page.Pixel(x, y), page.Pixel(r.x, y), px);
+      for(int x = r.x + r.w; x < x1; ++x) memcpy(page.Pixel(x, y), page.Pixel(r.x + r.w - 1, y), px);
+    }
+    size_t row = size_t(x1 - x0) * px;
+    for(int y = std::max(0, r.y - bleed); y < r.y; ++y) memcpy(page.Pixel(x0, y), page.Pixel(x0, r.y), row);
+    for(int y = r.y + r.h; y < std::min(page.h, r.y + r.h + bleed); ++y) memcpy(page.Pixel(x0, y), page.Pixel(x0, r.y + r.h - 1), row);
+  }
+
+  int AtlasBuilder::Build(){
+    std::vector<int> order;
+    for(int i = 0; i < sprites.size(); ++i)
+      if(sprites[i].page < 0) order.push_back(i);
+    std::sort(order.begin(), order.end(), [this](int a, int b){
+      const ImageView & ia = sprites[a].image, & ib = sprites[b].image;
+      int ma = std::max(ia.w, ia.h), mb = std::max(ib.w, ib.h);
+      return ma != mb ? ma > mb : ia.w * ia.h > ib.w * ib.h;
+    });
+
+    /// bins are larger by padding, so sprites at the right & bottom edges don't waste it
+    int first_page = pages.size();
+    std::vector<MaxRectsBin> bins;
+    std::vector<int> placed;
+    std::atomic<int> answer = 0;
+    for(int i : order){
+      Sprite & sprite = sprites[i];
+      int rw = sprite.image.w + 2 * bleed + padding, rh = sprite.image.h + 2 * bleed + padding;
+      if(rw > page_w + padding or rh > page_h + padding){
+        msg_warning("sprite", quote(sprite.name), sprite.image.w, "x", sprite.image.h, "does not fit into atlas page");
+        answer++;
+        continue;
+      }
+
+      AtlasRect r;
+      int bin = 0;
+      for(; bin < bins.size(); ++bin)
+        if(bins[bin].Insert(rw, rh, r)) break;
+      if(bin == bins.size()){
+        bins.emplace_back(page_w + padding, page_h + padding);
+        bins.back().Insert(rw, rh, r);
+      }
+      sprite.page = first_page + bin;
+      sprite.rect = AtlasRect{r.x + bleed, r.y + bleed, sprite.image.w, sprite.image.h};
+      placed.push_back(i);
+    }
+
+    for(int bin = 0; bin < bins.size(); ++bin){
+      Page page;
+      page.image = std::make_shared<Image>(page_w, page_h, image_format::RGBA, type);
+      memset(page.image->data, 0, page.image->Bytes());
+      pages.push_back(page);
+    }
+
+    /// sprites cover separate pixels of pages
+    parallel_for(thread_pool(), 0, placed.size(), [&](int i_start, int i_end){
+      for(int i = i_start; i < i_end; ++i){
+        Sprite & sprite = sprites[placed[i]];
+        ImageView page(*pages[sprite.page].image);
+        const AtlasRect & r = sprite.rect;
+        if(convert_pixels(sprite.image, page.Sub(r.x, r.y, r.w, r.h)) != PM_SUCCESS){
+          msg_warning("can't copy sprite", quote(sprite.name), "to atlas page, unsupported format");
+          answer++;
+          continue;
+        }
+        atlas_bleed(page, r, bleed);
+      }
+    });
+
+    for(int i : placed){
+      Sprite & sprite = sprites[i];
+      const AtlasRect & r = sprite.rect;
+      v2 tpos(float(r.x) / page_w, float(r.y) / page_h);
+      v2 tsize(float(r.w) / page_w, float(r.h) / page_h);
+      pages[sprite.page].atlas.Add(sprite.name, tpos, tsize);
+      sprite.image = ImageView(); /// pixels are on the page now
+    }
+    for(int bin = 0; bin < bins.size(); ++bin) msg_debug("atlas page", first_page + bin, "occupancy", bins[bin].Occupancy());
+    return answer;
+  }
+
+  int AtlasBuilder::PageOf(const std::string & name) const {
+    auto it = index.find(name);
+    return it == index.end() ? -1 : sprites[it->second].page;
+  }
+
+  const AtlasRect * AtlasBuilder::Rect(const std::string & name) const {
+    auto it = index.find(name);
+    if(it == index.end() or sprites[it->second].page < 0) return nullptr;
+    return &sprites[it->second].rect;
+  }
+
+  // ======= DynamicAtlas ====================================================================
+  int DynamicAtlas::SlotOf(int handle) const {
+    if(handle < 0) return -1;
+    int slot = handle & ((1 << 20) - 1);
+    if(slot >= slots.size() or slots[slot].page < 0 or MakeHandle(slot) != handle) return -1;
+    return slot;
+  }
+
+  int DynamicAtlas::NewPage(){
+    auto image = std::make_shared<Image>(page_w, page_h, image_format::RGBA, type);
+    memset(image->data, 0, image->Bytes());
+    std::shared_ptr<Texture> texture = accel ? accel->MakeTexture(image) : nullptr;
+    if(accel and not texture) msg_warning("can't make texture for atlas page", pages.size());
+    pages.push_back(Page{image, texture, MaxRectsBin(page_w + padding, page_h + padding)});
+    msg_debug("new atlas page", pages.size() - 1, page_w, "x", page_h);
+    return pages.size() - 1;
+  }
+
+  void DynamicAtlas::Evict(int slot){
+    Slot & s = slots[slot];
+    Page & page = pages[s.page];
+    AtlasRect r{s.rect.x - bleed, s.rect.y - bleed, s.rect.w + 2 * bleed, s.rect.h + 2 * bleed};
+    /// stale pixels must not be sampled through the padding of new neighbours
+    ImageView region = ImageView(*page.image).Sub(r.x, r.y, r.w, r.h);
+    for(int y = 0; y < region.h; ++y) memset(region.Row(y), 0, size_t(region.w) * region.PixelBytes());
+    page.dirty.push_back(r);
+
+    if(--page.n_items == 0) page.bin.Reset();
+    else page.bin.Free(AtlasRect{r.x, r.y, r.w + padding, r.h + padding});
+
+    index.erase(s.key);
+    lru.erase(s.lru);
+    s.key.clear();
+    s.page = -1;
+    s.generation = (s.generation + 1) & ((1 << 11) - 1);
+    free_slots.push_back(slot);
+  }
+
+  int DynamicAtlas::Insert(const std::string & key, const ImageView & image){
+    int handle = Find(key);
+    if(handle >= 0) return handle;
+    if(not image.Valid()){
+      msg_warning("item", quote(key), "has no pixels");
+      return -1;
+    }
+    int rw = image.w + 2 * bleed + padding, rh = image.h + 2 * bleed + padding;
+    if(rw > page_w + padding or rh > page_h + padding){
+      msg_warning("item", quote(key), image.w, "x", image.h, "does not fit into atlas page");
+      return -1;
+    }
+
+    AtlasRect r;
+    int page = 0;
+    for(; page < pages.size(); ++page)
+      if(pages[page].bin.Insert(rw, rh, r)) break;
+    if(page == pages.size() and pages.size() < max_pages){
+      page = NewPage();
+      pages[page].bin.Insert(rw, rh, r);
+    }
+    /// evict from the least recently used, retry in the page which got free space
+    while(page == pages.size()){
+      int victim = lru.size() ? lru.front() : -1;
+      if(victim < 0 or slots[victim].last_use == frame){
+        msg_warning("atlas is full with items used in this frame, can't insert", quote(key));
+        return -1;
+      }
+      int victim_page = slots[victim].page;
+      Evict(victim);
+      n_evicted++;
+      if(pages[victim_page].bin.Insert(rw, rh, r)) page = victim_page;
+    }
+
+    int slot;
+    if(free_slots.size()){
+      slot = free_slots.back();
+      free_slots.pop_back();
+    } else {
+      if(slots.size() == (1 << 20)){
+        msg_warning("too many atlas items");
+        pages[page].bin.Free(r);
+        return -1;
+      }
+      slot = slots.size();
+      slots.emplace_back();
+    }
+
+    Page & p = pages[page];
+    Slot & s = slots[slot];
+    s.key = key;
+    s.page = page;
+    s.rect = AtlasRect{r.x + bleed, r.y + bleed, image.w, image.h};
+    s.tile = TexTile(v2(float(s.rect.x) / page_w, float(s.rect.y) / page_h), v2(float(image.w) / page_w, float(image.h) / page_h));
+    s.last_use = frame;
+    s.lru = lru.insert(lru.end(), slot);
+    index[key] = slot;
+    p.n_items++;
+
+    ImageView view(*p.image);
+    if(convert_pixels(image, view.Sub(s.rect.x, s.rect.y, s.rect.w, s.rect.h)) != PM_SUCCESS)
+      msg_warning("can't copy item", quote(key), "to atlas page, unsupported format");
+    atlas_bleed(view, s.rect, bleed);
+    p.dirty.push_back(AtlasRect{r.x, r.y, r.w - padding, r.h - padding});
+    return MakeHandle(slot);
+  }
+
+  int DynamicAtlas::Find(const std::string & key){
+    auto it = index.find(key);
+    if(it == index.end()) return -1;
+    int handle = MakeHandle(it->second);
+    Touch(handle);
+    return handle;
+  }
+
+  bool DynamicAtlas::Touch(int handle){
+    int slot = SlotOf(handle);
+    if(slot < 0) return false;
+    Slot & s = slots[slot];
+    s.last_use = frame;
+    lru.splice(lru.end(), lru, s.lru);
+    return true;
+  }
+
+  const TexTile * DynamicAtlas::Get(int handle) const {
+    int slot = SlotOf(handle);
+    return slot < 0 ? nullptr : &slots[slot].tile;
+  }
+
+  int DynamicAtlas::PageOf(int handle) const {
+    int slot = SlotOf(handle);
+    return slot < 0 ? -1 : slots[slot].page;
+  }
+
+  int DynamicAtlas::Remove(int handle){
+    int slot = SlotOf(handle);
+    if(slot < 0) return PM_ERROR_INCORRECT_ARGUMENTS;
+    Evict(slot);
+    return PM_SUCCESS;
+  }
+
+  int DynamicAtlas::Flush(){
+    int answer = PM_SUCCESS;
+    for(auto & page : pages){
+      if(page.dirty.empty()) continue;
+      if(not page.texture){
+        page.dirty.clear();
+        continue;
+      }
+      if(page.dirty.size() > max_dirty){
+        AtlasRect u = page.dirty[0];
+        for(auto & r : page.dirty){
+          int x1 = std::max(u.x + u.w, r.x + r.w), y1 = std::max(u.y + u.h, r.y + r.h);
+          u.x = std::min(u.x, r.x);
+          u.y = std::min(u.y, r.y);
+          u.w = x1 - u.x;
+          u.h = y1 - u.y;
+        }
+        page.dirty = {u};
+      }
+      ImageView view(*page.image);
+      for(auto & r : page.dirty){
+        if(page.texture->Upload(view.Sub(r.x, r.y, r.w, r.h), r.x, r.y) == PM_SUCCESS) continue;
+        msg_warning("failed to upload atlas region");
+        answer = PM_ERROR;
+      }
+      page.dirty.clear();
+    }
+    return answer;
+  }
+};
@@ -0,0 +1,165 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_ATLAS_HH
+#define PMGDLIB_ATLAS_HH 1
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <list>
+#include <cstdint>
+#include <unordered_map>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_image.h"
+#include "pmgdlib_core_render.h"
+
+namespace pmgd {
+  // ======= MaxRectsBin ====================================================================
+  struct AtlasRect {
+    int x = 0, y = 0, w = 0, h = 0;
+    bool Contains(const AtlasRect & r) const { return r.x >= x and r.y >= y and r.x + r.w <= x + w and r.y + r.h <= y + h; }
+    bool Intersects(const AtlasRect & r) const { return r.x < x + w and x < r.x + r.w and r.y < y + h and y < r.y + r.h; }
+  };
+
+  //! MaxRects bin packing with the best short side fit rule, no rotations
+  class MaxRectsBin {
+    int w, h;
+    size_t used_area = 0;
+    std::vector<AtlasRect> free_rects;
+
+    void Split(const AtlasRect & used);
+    void Prune();
+
+    public:
+    MaxRectsBin(int w_, int h_) : w(w_), h(h_), free_rects({AtlasRect{0, 0, w_, h_}}) {}
+    //! place w x h rectangle, false if it does not fit
+    bool Insert(int rw, int rh, AtlasRect & out);
+    //! return placed rectangle to the bin, touching free rectangles are merged
+    void Free(const AtlasRect & r);
+    //! whole bin is free again
+    void Reset(){ free_rects = {AtlasRect{0, 0, w, h}}; used_area = 0; }
+    //! used fraction of the bin area
+    float Occupancy() const { return float(used_area) / (float(w) * h); }
+  };
+
+  // ======= AtlasBuilder ====================================================================
+  //! packs many images into atlas pages at load time, so sprites share few textures:
+  //!   every sprite is surrounded by bleed pixels copied from its edges, so filtering does not pick neighbours,
+  //!   sprites are padding transparent pixels apart,
+  //!   pages are RGBA images of page_w x page_h with TexAtlas of normalized tpos/tsize of sprite pixels without bleed
+  class AtlasBuilder : public BaseMsg {
+    struct Sprite {
+      std::string name;
+      ImageView image;
+      int page = -1;
+      AtlasRect rect; /// sprite pixels on the page
+    };
+    std::vector<Sprite> sprites;
+    std::unordered_map<std::string, int> index;
+
+    public:
+    struct Page {
+      std::shared_ptr<Image> image;
+      TexAtlas atlas;
+    };
+    std::vector<Page> pages;
+
+    int page_w = 2048, page_h = 2048;
+    int padding = 2;
+    int bleed = 1;
+    int type = image_type::UNSIGNED_CHAR; /// of page pixels, sprites are converted with convert_pixels()
+
+    AtlasBuilder(){}
+    AtlasBuilder(int page_w_, int page_h_, int padding_ = 2, int bleed_ = 1) : page_w(page_w_), page_h(page_h_), padding(padding_), bleed(bleed_) {}
+
+    //! view keeps the pixels alive until Build(), PM_ERROR_DUPLICATE for known names
+    int Add(const std::string & name, const ImageView & image);
+    //! pack added sprites into new pages, large sprites first, return number of sprites which don't fit into a page
+    int Build();
+
+    int Size() const { return sprites.size(); }
+    //! page of the sprite or -1
+    int PageOf(const std::string & name) const;
+    //! sprite pixels on its page
+    const AtlasRect * Rect(const std::string & name) const;
+  };
+
+  // ======= DynamicAtlas ====================================================================
+  //! atlas for content appearing at runtime (glyphs, avatars, streamed sprites):
+  //!   rectangles are allocated on demand in up to max_pages fixed pages, so items don't create a texture each,
+  //!   pixels are written to the page image on Insert and only the dirty regions are uploaded by Flush,
+  //!   when all pages are full the least recently used items are evicted, except the ones used in the current frame,
+  //!   handles include a generation, so handles of evicted items are rejected by Get
+  class DynamicAtlas : public BaseMsg {
+    struct Slot {
+      std::string key;
+      int page = -1;
+      int generation = 0;
+      AtlasRect rect;   /// item pixels on the page
+      TexTile tile;
+      uint64_t last_use = 0;
+      std::list<int>::iterator lru;
+    };
+    struct Page {
+      std::shared_ptr<Image> image;
+      std::shared_ptr<Texture> texture;
+      MaxRectsBin bin;
+      int n_items = 0;
+      std::vector<AtlasRect> dirty;
+    };
+
+    std::shared_ptr<AccelFactory> accel;
+    std::vector<Page> pages;
+    std::vector<Slot> slots;
+    std::vector<int> free_slots;
+    std::unordered_map<std::string, int> index;
+    std::list<int> lru;   /// slots from the least recently used
+    uint64_t frame = 1;
+    size_t n_evicted = 0;
+
+    int MakeHandle(int slot) const { return (slots[slot].generation << 20) | slot; }
+    int SlotOf(int handle) const;
+    int NewPage();
+    void Evict(int slot);
+
+    public:
+    int page_w = 1024, page_h = 1024;
+    int max_pages = 4;
+    int padding = 1;
+    int bleed = 0;
+    int type = image_type::UNSIGNED_CHAR;
+    //! dirty regions of a page are uploaded as their bounding box if there are more of them
+    int max_dirty = 16;
+
+    //! accel makes page textures, without it pages are CPU images only
+    DynamicAtlas(std::shared_ptr<AccelFactory> accel_ = nullptr, int page_w_ = 1024, int page_h_ = 1024, int max_pages_ = 4) :
+      accel(accel_), page_w(page_w_), page_h(page_h_), max_pages(max_pages_) {}
+
+    //! handle of the item, the pixels are copied to a page with convert_pixels(),
+    //! a known key is only marked as used, -1 if the item can't fit even after eviction
+    int Insert(const std::string & key, const ImageView & image);
+    //! handle of the item or -1, also marks it as used
+    int Find(const std::string & key);
+    //! mark item as used in the current frame, false for stale handles
+    bool Touch(int handle);
+    //! tile of the item on its page, nullptr for stale handles
+    const TexTile * Get(int handle) const;
+    int PageOf(int handle) const;
+    //! drop the item, its pixels are cleared
+    int Remove(int handle);
+
+    //! upload dirty regions of pages to their textures
+    int Flush();
+    //! items used before this call may be evicted again
+    void NextFrame(){ ++frame; }
+
+    int Pages() const { return pages.size(); }
+    std::shared_ptr<Image> PageImage(int page) const { return pages.at(page).image; }
+    std::shared_ptr<Texture> PageTexture(int page) const { return pages.at(page).texture; }
+    int Size() const { return index.size(); }
+    size_t Evicted() const { return n_evicted; }
+  };
+};
+
+#endif
@@ -0,0 +1,440 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+#include "pmgdlib_blend.h"
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= scalar kernels ====================================================================
+  /// round to nearest even for x in [0, 2^22] like cvtps2dq does
+  static inline int blend_round(float x){
+    const float magic = 12582912.f; /// 1.5 * 2^23
+    return int((x + magic) - magic);
+  }
+
+  /// round(x / 255) for x in [0, 255 * 255]
+  static inline uint32_t blend_div255(uint32_t x){
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+  }
+
+  /// SIMD kernels evaluate the same float expressions in the same order, so all levels give the same bytes
+  static void over8_scalar(const uint8_t * src, uint8_t * dst, size_t n){
+    const float k = 1.f / 255.f;
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      float sa = src[3] * k, da = dst[3] * k;
+      float dw = da * (1.f - sa), oa = sa + dw;
+      float inv = oa > 0.f ? 1.f / oa : 0.f;
+      for(int c = 0; c < 3; ++c) dst[c] = blend_round((src[c] * sa + dst[c] * dw) * inv);
+      dst[3] = blend_round(oa * 255.f);
+    }
+  }
+
+  static void over_premul8_scalar(const uint8_t * src, uint8_t * dst, size_t n){
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      uint32_t ia = 255 - src[3];
+      for(int c = 0; c < 4; ++c) dst[c] = std::min<uint32_t>(255, src[c] + blend_div255(dst[c] * ia));
+    }
+  }
+
+  static void add8_scalar(const uint8_t * src, uint8_t * dst, size_t n){
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      uint32_t a = src[3];
+      for(int c = 0; c < 4; ++c) dst[c] = std::min<uint32_t>(255, dst[c] + blend_div255(src[c] * a));
+    }
+  }
+
+  static void tint8_scalar(const uint8_t * src, uint8_t * dst, size_t n, const uint8_t * color){
+    for(size_t i = 0; i < n * 4; ++i) dst[i] = blend_div255(src[i] * color[i % 4]);
+  }
+
+  static void nearest8_scalar(const uint8_t * row, uint8_t * dst, const int32_t * xs, size_t n){
+    for(size_t i = 0; i < n; ++i) memcpy(dst + i * 4, row + xs[i] * 4, 4);
+  }
+
+  /// dst = (a * (256 - w) + b * w + 128) >> 8 for n bytes
+  static void lerp8_scalar(const uint8_t * a, const uint8_t * b, uint8_t * dst, size_t n, int w){
+    for(size_t i = 0; i < n; ++i) dst[i] = (a[i] * (256 - w) + b[i] * w + 128) >> 8;
+  }
+
+  static void bilinear8_scalar(const uint8_t * row, uint8_t * dst, const int32_t * xa, const int32_t * xb, const int32_t * ws, size_t n){
+    for(size_t i = 0; i < n; ++i){
+      const uint8_t * a = row + xa[i] * 4, * b = row + xb[i] * 4;
+      int w = ws[i];
+      for(int c = 0; c < 4; ++c) dst[i * 4 + c] = (a[c] * (256 - w) + b[c] * w + 128) >> 8;
+    }
+  }
+
+  #ifdef PMGD_SIMD_X86
+    // ======= SSE2 kernels ====================================================================
+    /// one pixel per register, channels are floats in [0, 255]
+    PMGD_TARGET_SSE2 static inline __m128 over_px_sse2(__m128 s, __m128 d){
+      const __m128 k = _mm_set1_ps(1.f / 255.f), one = _mm_set1_ps(1.f), c255 = _mm_set1_ps(255.f), zero = _mm_setzero_ps();
+      const __m128 amask = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+      __m128 sa = _mm_mul_ps(_mm_shuffle_ps(s, s, 0xFF), k), da = _mm_mul_ps(_mm_shuffle_ps(d, d, 0xFF), k);
+      __m128 dw = _mm_mul_ps(da, _mm_sub_ps(one, sa)), oa = _mm_add_ps(sa, dw);
+      __m128 inv = _mm_and_ps(_mm_cmpgt_ps(oa, zero), _mm_div_ps(one, oa));
+      __m128 c = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(s, sa), _mm_mul_ps(d, dw)), inv);
+      return _mm_or_ps(_mm_andnot_ps(amask, c), _mm_and_ps(amask, _mm_mul_ps(oa, c255)));
+    }
+
+    PMGD_TARGET_SSE2 static void over8_sse2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m128i zero = _mm_setzero_si128();
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4)), d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i s16[2] = {_mm_unpacklo_epi8(s, zero), _mm_unpackhi_epi8(s, zero)};
+        __m128i d16[2] = {_mm_unpacklo_epi8(d, zero), _mm_unpackhi_epi8(d, zero)};
+        __m128i out[4];
+        for(int p = 0; p < 4; ++p){
+          __m128i s32 = p % 2 ? _mm_unpackhi_epi16(s16[p / 2], zero) : _mm_unpacklo_epi16(s16[p / 2], zero);
+          __m128i d32 = p % 2 ? _mm_unpackhi_epi16(d16[p / 2], zero) : _mm_unpacklo_epi16(d16[p / 2], zero);
+          out[p] = _mm_cvtps_epi32(over_px_sse2(_mm_cvtepi32_ps(s32), _mm_cvtepi32_ps(d32)));
+        }
+        __m128i packed = _mm_packus_epi16(_mm_packs_epi32(out[0], out[1]), _mm_packs_epi32(out[2], out[3]));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), packed);
+      }
+      over8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    /// 16 bit channels of two pixels, alpha of every pixel in all its channels
+    PMGD_TARGET_SSE2 static inline __m128i alpha16_sse2(__m128i v){
+      return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xFF), 0xFF);
+    }
+
+    PMGD_TARGET_SSE2 static inline __m128i div255_sse2(__m128i x){
+      x = _mm_add_epi16(x, _mm_set1_epi16(128));
+      return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    }
+
+    PMGD_TARGET_SSE2 static void over_premul8_sse2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m128i zero = _mm_setzero_si128(), c255 = _mm_set1_epi16(255);
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4)), d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i slo = _mm_unpacklo_epi8(s, zero), shi = _mm_unpackhi_epi8(s, zero);
+        __m128i lo = div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(c255, alpha16_sse2(slo))));
+        __m128i hi = div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(c255, alpha16_sse2(shi))));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+      }
+      over_premul8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_SSE2 static void add8_sse2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m128i zero = _mm_setzero_si128();
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4)), d = _mm_loadu_si128((const __m128i*)(dst + i * 4));
+        __m128i slo = _mm_unpacklo_epi8(s, zero), shi = _mm_unpackhi_epi8(s, zero);
+        __m128i lo = div255_sse2(_mm_mullo_epi16(slo, alpha16_sse2(slo)));
+        __m128i hi = div255_sse2(_mm_mullo_epi16(shi, alpha16_sse2(shi)));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_adds_epu8(d, _mm_packus_epi16(lo, hi)));
+      }
+      add8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_SSE2 static void tint8_sse2(const uint8_t * src, uint8_t * dst, size_t n, const uint8_t * color){
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i c = _mm_setr_epi16(color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3]);
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        __m128i lo = div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), c));
+        __m128i hi = div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), c));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+      }
+      tint8_scalar(src + i * 4, dst + i * 4, n - i, color);
+    }
+
+    PMGD_TARGET_SSE2 static void lerp8_sse2(const uint8_t * a, const uint8_t * b, uint8_t * dst, size_t n, int w){
+      const __m128i zero = _mm_setzero_si128(), c128 = _mm_set1_epi16(128);
+      const __m128i wb = _mm_set1_epi16(w), wa = _mm_set1_epi16(256 - w);
+      size_t i = 0;
+      for(; i + 16 <= n; i += 16){
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i)), vb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa), _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb)), c128);
+        __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa), _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb)), c128);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+      }
+      lerp8_scalar(a + i, b + i, dst + i, n - i, w);
+    }
+
+    /// left & right pixels, weights as w | w << 16 per pixel
+    PMGD_TARGET_SSE2 static inline __m128i bilinear4_sse2(__m128i l, __m128i r, __m128i w){
+      const __m128i zero = _mm_setzero_si128(), c128 = _mm_set1_epi16(128), c256 = _mm_set1_epi16(256);
+      __m128i wlo = _mm_unpacklo_epi32(w, w), whi = _mm_unpackhi_epi32(w, w);
+      __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(l, zero), _mm_sub_epi16(c256, wlo)), _mm_mullo_epi16(_mm_unpacklo_epi8(r, zero), wlo));
+      __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(l, zero), _mm_sub_epi16(c256, whi)), _mm_mullo_epi16(_mm_unpackhi_epi8(r, zero), whi));
+      return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, c128), 8), _mm_srli_epi16(_mm_add_epi16(hi, c128), 8));
+    }
+
+    PMGD_TARGET_SSE2 static void bilinear8_sse2(const uint8_t * row, uint8_t * dst, const int32_t * xa, const int32_t * xb, const int32_t * ws, size_t n){
+      alignas(16) uint32_t l[4], r[4];
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        for(int p = 0; p < 4; ++p){
+          memcpy(l + p, row + xa[i + p] * 4, 4);
+          memcpy(r + p, row + xb[i + p] * 4, 4);
+        }
+        __m128i w = _mm_loadu_si128((const __m128i*)(ws + i));
+        w = _mm_or_si128(w, _mm_slli_epi32(w, 16));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), bilinear4_sse2(_mm_load_si128((const __m128i*)l), _mm_load_si128((const __m128i*)r), w));
+      }
+      bilinear8_scalar(row, dst + i * 4, xa + i, xb + i, ws + i, n - i);
+    }
+
+    // ======= AVX2 kernels ====================================================================
+    /// two pixels per register, one in every 128 bit lane
+    PMGD_TARGET_AVX2 static inline __m256 over_px_avx2(__m256 s, __m256 d){
+      const __m256 k = _mm256_set1_ps(1.f / 255.f), one = _mm256_set1_ps(1.f), c255 = _mm256_set1_ps(255.f), zero = _mm256_setzero_ps();
+      const __m256 amask = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+      __m256 sa = _mm256_mul_ps(_mm256_shuffle_ps(s, s, 0xFF), k), da = _mm256_mul_ps(_mm256_shuffle_ps(d, d, 0xFF), k);
+      __m256 dw = _mm256_mul_ps(da, _mm256_sub_ps(one, sa)), oa = _mm256_add_ps(sa, dw);
+      __m256 inv = _mm256_and_ps(_mm256_cmp_ps(oa, zero, _CMP_GT_OQ), _mm256_div_ps(one, oa));
+      __m256 c = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(s, sa), _mm256_mul_ps(d, dw)), inv);
+      return _mm256_blendv_ps(c, _mm256_mul_ps(oa, c255), amask);
+    }
+
+    PMGD_TARGET_AVX2 static void over8_avx2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m256i zero = _mm256_setzero_si256();
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4)), d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i s16[2] = {_mm256_unpacklo_epi8(s, zero), _mm256_unpackhi_epi8(s, zero)};
+        __m256i d16[2] = {_mm256_unpacklo_epi8(d, zero), _mm256_unpackhi_epi8(d, zero)};
+        __m256i out[4];
+        for(int p = 0; p < 4; ++p){
+          __m256i s32 = p % 2 ? _mm256_unpackhi_epi16(s16[p / 2], zero) : _mm256_unpacklo_epi16(s16[p / 2], zero);
+          __m256i d32 = p % 2 ? _mm256_unpackhi_epi16(d16[p / 2], zero) : _mm256_unpacklo_epi16(d16[p / 2], zero);
+          out[p] = _mm256_cvtps_epi32(over_px_avx2(_mm256_cvtepi32_ps(s32), _mm256_cvtepi32_ps(d32)));
+        }
+        __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(out[0], out[1]), _mm256_packs_epi32(out[2], out[3]));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), packed);
+      }
+      over8_sse2(src + i * 4, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_AVX2 static inline __m256i alpha16_avx2(__m256i v){
+      return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, 0xFF), 0xFF);
+    }
+
+    PMGD_TARGET_AVX2 static inline __m256i div255_avx2(__m256i x){
+      x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+      return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    }
+
+    PMGD_TARGET_AVX2 static void over_premul8_avx2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m256i zero = _mm256_setzero_si256(), c255 = _mm256_set1_epi16(255);
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4)), d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i slo = _mm256_unpacklo_epi8(s, zero), shi = _mm256_unpackhi_epi8(s, zero);
+        __m256i lo = div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(c255, alpha16_avx2(slo))));
+        __m256i hi = div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(c255, alpha16_avx2(shi))));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_adds_epu8(s, _mm256_packus_epi16(lo, hi)));
+      }
+      over_premul8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_AVX2 static void add8_avx2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m256i zero = _mm256_setzero_si256();
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4)), d = _mm256_loadu_si256((const __m256i*)(dst + i * 4));
+        __m256i slo = _mm256_unpacklo_epi8(s, zero), shi = _mm256_unpackhi_epi8(s, zero);
+        __m256i lo = div255_avx2(_mm256_mullo_epi16(slo, alpha16_avx2(slo)));
+        __m256i hi = div255_avx2(_mm256_mullo_epi16(shi, alpha16_avx2(shi)));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_adds_epu8(d, _mm256_packus_epi16(lo, hi)));
+      }
+      add8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_AVX2 static void tint8_avx2(const uint8_t * src, uint8_t * dst, size_t n, const uint8_t * color){
+      const __m256i zero = _mm256_setzero_si256();
+      const __m256i c = _mm256_setr_epi16(color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3],
+                                          color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3]);
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+        __m256i lo = div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(s, zero), c));
+        __m256i hi = div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(s, zero), c));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+      }
+      tint8_scalar(src + i * 4, dst + i * 4, n - i, color);
+    }
+
+    PMGD_TARGET_AVX2 static void nearest8_avx2(const uint8_t * row, uint8_t * dst, const int32_t * xs, size_t n){
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(xs + i));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_i32gather_epi32((const int*)row, idx, 4));
+      }
+      nearest8_scalar(row, dst + i * 4, xs + i, n - i);
+    }
+
+    PMGD_TARGET_AVX2 static void lerp8_avx2(const uint8_t * a, const uint8_t * b, uint8_t * dst, size_t n, int w){
+      const __m256i zero = _mm256_setzero_si256(), c128 = _mm256_set1_epi16(128);
+      const __m256i wb = _mm256_set1_epi16(w), wa = _mm256_set1_epi16(256 - w);
+      size_t i = 0;
+      for(; i + 32 <= n; i += 32){
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i)), vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(va, zero), wa), _mm256_mullo_epi16(_mm256_unpacklo_epi8(vb, zero), wb)), c128);
+        __m256i hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(va, zero), wa), _mm256_mullo_epi16(_mm256_unpackhi_epi8(vb, zero), wb)), c128);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+      }
+      lerp8_sse2(a + i, b + i, dst + i, n - i, w);
+    }
+
+    PMGD_TARGET_AVX2 static void bilinear8_avx2(const uint8_t * row, uint8_t * dst, const int32_t * xa, const int32_t * xb, const int32_t * ws, size_t n){
+      const __m256i zero = _mm256_setzero_si256(), c128 = _mm256_set1_epi16(128), c256 = _mm256_set1_epi16(256);
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i l = _mm256_i32gather_epi32((const int*)row, _mm256_loadu_si256((const __m256i*)(xa + i)), 4);
+        __m256i r = _mm256_i32gather_epi32((const int*)row, _mm256_loadu_si256((const __m256i*)(xb + i)), 4);
+        __m256i w = _mm256_loadu_si256((const __m256i*)(ws + i));
+        w = _mm256_or_si256(w, _mm256_slli_epi32(w, 16));
+        __m256i wlo = _mm256_unpacklo_epi32(w, w), whi = _mm256_unpackhi_epi32(w, w);
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(l, zero), _mm256_sub_epi16(c256, wlo)), _mm256_mullo_epi16(_mm256_unpacklo_epi8(r, zero), wlo));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(l, zero), _mm256_sub_epi16(c256, whi)), _mm256_mullo_epi16(_mm256_unpackhi_epi8(r, zero), whi));
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, c128), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, c128), 8);
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+      }
+      bilinear8_sse2(row, dst + i * 4, xa + i, xb + i, ws + i, n - i);
+    }
+  #endif
+
+  // ======= CPU dispatch ====================================================================
+  struct BlendKernels {
+    void (*over8)(const uint8_t*, uint8_t*, size_t);
+    void (*over_premul8)(const uint8_t*, uint8_t*, size_t);
+    void (*add8)(const uint8_t*, uint8_t*, size_t);
+    void (*tint8)(const uint8_t*, uint8_t*, size_t, const uint8_t*);
+    void (*nearest8)(const uint8_t*, uint8_t*, const int32_t*, size_t);
+    void (*lerp8)(const uint8_t*, const uint8_t*, uint8_t*, size_t, int);
+    void (*bilinear8)(const uint8_t*, uint8_t*, const int32_t*, const int32_t*, const int32_t*, size_t);
+  };
+
+  /// SSE2 has no gathers, nearest sampling stays scalar there
+  static const BlendKernels blend_kernels[] = {
+    {over8_scalar, over_premul8_scalar, add8_scalar, tint8_scalar, nearest8_scalar, lerp8_scalar, bilinear8_scalar},
+    #ifdef PMGD_SIMD_X86
+    {over8_sse2, over_premul8_sse2, add8_sse2, tint8_sse2, nearest8_scalar, lerp8_sse2, bilinear8_sse2},
+    {over8_avx2, over_premul8_avx2, add8_avx2, tint8_avx2, nearest8_avx2, lerp8_avx2, bilinear8_avx2},
+    #endif
+  };
+
+  static inline const BlendKernels & kernels(){
+    return blend_kernels[simd_get_level()];
+  }
+
+  // ======= row kernels ====================================================================
+  void blend_row_over(const uint8_t * src, uint8_t * dst, size_t n){ kernels().over8(src, dst, n); }
+  void blend_row_over_premul(const uint8_t * src, uint8_t * dst, size_t n){ kernels().over_premul8(src, dst, n); }
+  void blend_row_add(const uint8_t * src, uint8_t * dst, size_t n){ kernels().add8(src, dst, n); }
+  void blend_row_tint(const uint8_t * src, uint8_t * dst, size_t n, const uint8_t * color){ kernels().tint8(src, dst, n, color); }
+
+  static void blend_row(int mode, const uint8_t * src, uint8_t * dst, size_t n){
+    if(mode == blend_mode::OVER) blend_row_over(src, dst, n);
+    else if(mode == blend_mode::OVER_PREMUL) blend_row_over_premul(src, dst, n);
+    else if(mode == blend_mode::ADD) blend_row_add(src, dst, n);
+    else memcpy(dst, src, n * 4);
+  }
+
+  // ======= image operations ====================================================================
+  static bool blend_view(const ImageView & view){
+    bool rgba = view.format == image_format::RGBA or view.format == image_format::BGRA;
+    return view.Valid() and rgba and view.type == image_type::UNSIGNED_CHAR and view.Packed();
+  }
+
+  int blend_image(const ImageView & src, const ImageView & dst, int mode){
+    if(not blend_view(src) or not blend_view(dst) or src.format != dst.format or src.w != dst.w or src.h != dst.h) return PM_ERROR_INCORRECT_ARGUMENTS;
+    if(mode < blend_mode::COPY or mode > blend_mode::ADD) return PM_ERROR_INCORRECT_ARGUMENTS;
+    parallel_rows(0, src.h, src.w, [&](int y0, int y1){
+      for(int y = y0; y < y1; ++y) blend_row(mode, src.Row(y), dst.Row(y), src.w);
+    });
+    return PM_SUCCESS;
+  }
+
+  int tint_image(const ImageView & src, const ImageView & dst, const rgb & color){
+    if(not blend_view(src) or not blend_view(dst) or src.format != dst.format or src.w != dst.w or src.h != dst.h) return PM_ERROR_INCORRECT_ARGUMENTS;
+    uint8_t c[4];
+    float channels[4] = {color.r, color.g, color.b, color.a};
+    for(int i = 0; i < 4; ++i) c[i] = blend_round(std::clamp(channels[i], 0.f, 1.f) * 255.f);
+    if(src.format == image_format::BGRA) std::swap(c[0], c[2]);
+    parallel_rows(0, src.h, src.w, [&](int y0, int y1){
+      for(int y = y0; y < y1; ++y) blend_row_tint(src.Row(y), dst.Row(y), src.w, c);
+    });
+    return PM_SUCCESS;
+  }
+
+  /// source pixel & weight of every destination pixel of the axis, position of pixel center i is (i + 0.5) * k
+  static void blit_axis(int i0, int n, float k, int size, int filter, int32_t * a, int32_t * b, int32_t * w){
+    for(int i = 0; i < n; ++i){
+      float f = (i0 + i + 0.5f) * k;
+      if(filter == blit_filter::NEAREST){
+        a[i] = std::clamp(int(f), 0, size - 1);
+        continue;
+      }
+      f -= 0.5f;
+      float fl = std::floor(f);
+      a[i] = std::clamp(int(fl), 0, size - 1);
+      b[i] = std::clamp(int(fl) + 1, 0, size - 1);
+      w[i] = blend_round((f - fl) * 256.f);
+    }
+  }
+
+  int blit_scaled(const ImageView & src, const ImageView & dst, int x, int y, int w, int h, int filter, int mode){
+    /// mirrored source is sampled through the packed view with mirrored columns
+    bool mirror = src.step < 0;
+    ImageView source = mirror ? src.FlipX() : src;
+    if(not blend_view(source) or not blend_view(dst) or src.format != dst.format or w <= 0 or h <= 0) return PM_ERROR_INCORRECT_ARGUMENTS;
+    if(mode < blend_mode::COPY or mode > blend_mode::ADD or filter < blit_filter::NEAREST or filter > blit_filter::BILINEAR) return PM_ERROR_INCORRECT_ARGUMENTS;
+    int x0 = std::max(0, x), x1 = std::min(dst.w, x + w);
+    int y0 = std::max(0, y), y1 = std::min(dst.h, y + h);
+    if(x0 >= x1 or y0 >= y1) return PM_SUCCESS;
+
+    int n = x1 - x0, m = y1 - y0;
+    std::vector<int32_t> xa(n), xb(n), wx(n), ya(m), yb(m), wy(m);
+    blit_axis(x0 - x, n, float(src.w) / w, src.w, filter, xa.data(), xb.data(), wx.data());
+    blit_axis(y0 - y, m, float(src.h) / h, src.h, filter, ya.data(), yb.data(), wy.data());
+    if(mirror){
+      for(int i = 0; i < n; ++i){
+        xa[i] = src.w - 1 - xa[i];
+        xb[i] = src.w - 1 - xb[i];
+      }
+    }
+
+    /// bilinear rows are interpolated vertically only over the used source columns
+    int c0 = 0, c1 = 0;
+    if(filter == blit_filter::BILINEAR){
+      c0 = std::min(std::min(xa[0], xa[n - 1]), std::min(xb[0], xb[n - 1]));
+      c1 = std::max(std::max(xa[0], xa[n - 1]), std::max(xb[0], xb[n - 1])) + 1;
+      for(int i = 0; i < n; ++i){
+        xa[i] -= c0;
+        xb[i] -= c0;
+      }
+    }
+
+    const BlendKernels & k = kernels();
+    parallel_rows(y0, y1, n, [&](int r0, int r1){
+      std::vector<uint8_t> line(n * 4), column((c1 - c0) * 4);
+      for(int Y = r0; Y < r1; ++Y){
+        int j = Y - y0;
+        uint8_t * out = mode == blend_mode::COPY ? dst.Pixel(x0, Y) : line.data();
+        if(filter == blit_filter::NEAREST) k.nearest8(source.Row(ya[j]), out, xa.data(), n);
+        else {
+          k.lerp8(source.Pixel(c0, ya[j]), source.Pixel(c0, yb[j]), column.data(), column.size(), wy[j]);
+          k.bilinear8(column.data(), out, xa.data(), xb.data(), wx.data(), n);
+        }
+        if(mode != blend_mode::COPY) blend_row(mode, line.data(), dst.Pixel(x0, Y), n);
+      }
+    });
+    return PM_SUCCESS;
+  }
+};
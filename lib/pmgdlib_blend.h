@@ -0,0 +1,54 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_BLEND_HH
+#define PMGDLIB_BLEND_HH 1
+
+#include <cstdint>
+#include <cstddef>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_math.h"
+#include "pmgdlib_image.h"
+
+namespace pmgd {
+  // ======= compositing ====================================================================
+  namespace blend_mode {
+    enum {
+      COPY = 0,
+      OVER,          /// source-over of straight alpha colors
+      OVER_PREMUL,   /// source-over of premultiplied colors
+      ADD            /// GL_SRC_ALPHA, GL_ONE
+    };
+  };
+
+  namespace blit_filter {
+    enum {
+      NEAREST = 0,
+      BILINEAR
+    };
+  };
+
+  // ======= row kernels ====================================================================
+  //! n RGBA8 pixels of src are composited into dst, kernels are selected with simd_get_level() as in pmgdlib_pixel.h
+  //! out.a = sa + da * (1 - sa), out.c = (sc * sa + dc * da * (1 - sa)) / out.a
+  void blend_row_over(const uint8_t * src, uint8_t * dst, size_t n);
+  //! out = src + dst * (1 - sa)
+  void blend_row_over_premul(const uint8_t * src, uint8_t * dst, size_t n);
+  //! out = dst + src * sa, saturated
+  void blend_row_add(const uint8_t * src, uint8_t * dst, size_t n);
+  //! dst = src * color, color is RGBA8, src == dst is allowed
+  void blend_row_tint(const uint8_t * src, uint8_t * dst, size_t n, const uint8_t * color);
+
+  // ======= image operations ====================================================================
+  //! views are RGBA8 or BGRA8 of the same format with packed pixels, rows are processed in parallel on thread_pool()
+
+  //! composite src into dst of the same size
+  int blend_image(const ImageView & src, const ImageView & dst, int mode = blend_mode::OVER);
+  //! dst = src * color, color alpha multiplies alpha
+  int tint_image(const ImageView & src, const ImageView & dst, const rgb & color);
+  //! scale src to the x, y, w, h rectangle of dst and composite it with mode, the rectangle is clipped by dst,
+  //! use flipped views of src to mirror it, pixel centers are aligned as in GL texture sampling
+  int blit_scaled(const ImageView & src, const ImageView & dst, int x, int y, int w, int h,
+                  int filter = blit_filter::BILINEAR, int mode = blend_mode::OVER);
+};
+
+#endif
@@ -5,16 +5,22 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <cstring>
 
 #include "pmgdlib_std.h"
 #include "pmgdlib_msg.h"
 #include "pmgdlib_core.h"
 #include "pmgdlib_config.h"
+#include "pmgdlib_thread.h"
 
 namespace pmgd {
   // ======= ConfigItem ====================================================================
   void ConfigItem::AddAttribute(const std::string & name, const std::string & value)  { attributes[name] = value; }
-  void ConfigItem::AddAttribute(std::string && name, std::string && value){ attributes[name] = value; }
+  void ConfigItem::AddAttribute(std::string && name, std::string && value){ attributes[std::move(name)] = std::move(value); }
 
   void ConfigItem::Add(std::string name, ConfigItem* value){
     value->father = this;
@@ -26,9 +32,23 @@ namespace pmgd {
     for(auto iter = other->attributes.begin(); iter != other->attributes.end(); ++iter)
     AddAttribute(iter->first, iter->second);
     
+    /// nested item with the same type & id replaces the existing one in place, so diff_cfg() and NdMap see one item
     for(auto iter = other->nested.begin(); iter != other->nested.end(); ++iter){
-      for(auto data_iter = iter->second.begin(); data_iter != iter->second.begin(); ++data_iter)
-        Add(iter->first, *data_iter);
+      std::vector<ConfigItem*> & group = nested[iter->first];
+      for(auto data_iter = iter->second.begin(); data_iter != iter->second.end(); ++data_iter){
+        ConfigItem* item = *data_iter;
+        item->father = this;
+        auto id = item->attributes.find("id");
+        auto same = group.end();
+        if(id != item->attributes.end()){
+          same = std::find_if(group.begin(), group.end(), [&id](const ConfigItem* c){
+            auto it = c->attributes.find("id");
+            return it != c->attributes.end() and it->second == id->second;
+          });
+        }
+        if(same != group.end()) *same = item;
+        else group.push_back(item);
+      }
     }
     return PM_SUCCESS;
   }
@@ -104,8 +124,102 @@ namespace pmgd {
     return hr;
   }
 
+  // ======= CompiledConfigSchema ====================================================================
+  int CompiledConfigSchema::Intern(std::unordered_map<std::string, int> & ids, std::vector<std::string> & names, const std::string & name){
+    auto it = ids.find(name);
+    if(it != ids.end()) return it->second;
+    int id = names.size();
+    names.push_back(name);
+    ids[name] = id;
+    return id;
+  }
+
+  void CompiledConfigSchema::Compile(const std::map<std::string, ConfigProcessingRule> & rules){
+    attr_names.clear(); attr_ids.clear();
+    type_names.clear(); type_ids.clear();
+    tables.clear();
+
+    for(auto & it : rules){
+      int type = Intern(type_ids, type_names, it.first);
+      if(tables.size() <= type) tables.resize(type + 1);
+
+      std::vector<int> mandatory;
+      for(const std::string & name : it.second.schema.mandatory) mandatory.push_back(Intern(attr_ids, attr_names, name));
+      std::sort(mandatory.begin(), mandatory.end(), [this](int a, int b){ return attr_names[a] < attr_names[b]; });
+      mandatory.erase(std::unique(mandatory.begin(), mandatory.end()), mandatory.end());
+
+      std::vector<int> fathers;
+      for(const std::string & name : it.second.schema.fathers) fathers.push_back(Intern(type_ids, type_names, name));
+
+      tables[type].mandatory = std::move(mandatory);
+      tables[type].fathers = std::move(fathers);
+    }
+    tables.resize(type_names.size());
+  }
+
+  int CompiledConfigSchema::TypeId(const std::string & type) const {
+    auto it = type_ids.find(type);
+    return it == type_ids.end() ? -1 : it->second;
+  }
+
+  void CompiledConfigSchema::ValidateItem(const ConfigItem* item, int type, const std::vector<int> & father_types, std::vector<ConfigViolation> & violations) const {
+    if(type < 0) return;
+    const TypeTable & table = tables[type];
+
+    /// both mandatory and item attributes are sorted by name
+    auto attr = item->attributes.begin(), attr_end = item->attributes.end();
+    for(int id : table.mandatory){
+      const std::string & name = attr_names[id];
+      while(attr != attr_end and attr->first < name) ++attr;
+      if(attr == attr_end or attr->first != name or attr->second.empty())
+        violations.push_back({item, cfg_violation::MANDATORY, name});
+    }
+
+    if(father_types.size() < table.fathers.size()){
+      violations.push_back({item, cfg_violation::DEPTH, ""});
+      return;
+    }
+
+    for(int depth = 0, depth_max = table.fathers.size(); depth < depth_max; ++depth){
+      if(father_types[depth_max - 1 - depth] == table.fathers[depth]) continue;
+      violations.push_back({item, cfg_violation::FATHER, type_names[table.fathers[depth]]});
+    }
+  }
+
+  void CompiledConfigSchema::ValidateNestedItems(const ConfigItem* item, std::vector<int> & father_types, std::vector<ConfigViolation> & violations) const {
+    for(auto & it : item->nested){
+      int type = TypeId(it.first);
+      for(const ConfigItem* nested : it.second){
+        ValidateItem(nested, type, father_types, violations);
+        if(not nested->nested.size()) continue;
+        father_types.push_back(TypeId(nested->type));
+        ValidateNestedItems(nested, father_types, violations);
+        father_types.pop_back();
+      }
+    }
+  }
+
+  int CompiledConfigSchema::Validate(const ConfigItem* item, const std::vector<const ConfigItem*> & processed_stack, std::vector<ConfigViolation> & violations) const {
+    size_t n_violations = violations.size();
+    std::vector<int> father_types;
+    for(const ConfigItem* father : processed_stack) father_types.push_back(TypeId(father->type));
+    ValidateItem(item, TypeId(item->type), father_types, violations);
+    father_types.push_back(TypeId(item->type));
+    ValidateNestedItems(item, father_types, violations);
+    return violations.size() == n_violations ? PM_SUCCESS : PM_ERROR_SCHEMA;
+  }
+
+  int CompiledConfigSchema::ValidateNested(const ConfigItem* item, const std::vector<const ConfigItem*> & processed_stack, std::vector<ConfigViolation> & violations) const {
+    size_t n_violations = violations.size();
+    std::vector<int> father_types;
+    for(const ConfigItem* father : processed_stack) father_types.push_back(TypeId(father->type));
+    ValidateNestedItems(item, father_types, violations);
+    return violations.size() == n_violations ? PM_SUCCESS : PM_ERROR_SCHEMA;
+  }
+
   // ======= Config ====================================================================
-  int Config::ProcessNestedItems(const std::map<std::string, std::vector<ConfigItem*>> & nested, std::vector<const ConfigItem*> & processed_stack) const {
+  int Config::ProcessNestedItems(const std::map<std::string, std::vector<ConfigItem*>> & nested, std::vector<const ConfigItem*> & processed_stack, 
+    const std::unordered_set<const ConfigItem*> & invalid) const {
     /// call ProcessItem to every provided nested item
     int tot_ret = PM_SUCCESS;
     for(auto iter = nested.begin(); iter != nested.end(); ++iter){
@@ -113,10 +227,10 @@ namespace pmgd {
       const std::vector<ConfigItem*> & group = iter->second;
 
       /// nested items form groups, every group has specific processing rule
-      auto rule = map_get(processing_rules, key, default_processing_rule);
-      // int ret = ProcessNestedGroup(group, rule, processed_stack);
+      const ConfigProcessingRule * rule = map_get_ptr(processing_rules, key);
+      if(rule == nullptr) rule = &default_processing_rule;
       for(int i = 0, i_max = group.size(); i < i_max; ++i){
-        int ret = ProcessItem(group[i], rule, processed_stack);
+        int ret = ProcessItem(group[i], *rule, processed_stack, invalid);
         tot_ret = (ret == PM_SUCCESS ? tot_ret : ret);
 
         if(ret == PM_ERROR_SCHEMA){msg_warning("item = ", i, "invalid schema = ", ret);}
@@ -126,65 +240,83 @@ namespace pmgd {
     return tot_ret;
   }
 
-  int Config::ProcessItem(const ConfigItem* item, const ConfigProcessingRule & rule, std::vector<const ConfigItem*> & processed_stack) const {
-    int valid = Validate(rule.schema, item, processed_stack);
-    if(valid != PM_SUCCESS) return valid;
+  int Config::ProcessItem(const ConfigItem* item, const ConfigProcessingRule & rule, std::vector<const ConfigItem*> & processed_stack, 
+    const std::unordered_set<const ConfigItem*> & invalid) const {
+    /// items are validated in advance by the compiled schema
+    if(invalid.size() and invalid.count(item)) return PM_ERROR_SCHEMA;
     int status = rule.proccessor(item);
     if(status != PM_SUCCESS) return status;
 
     processed_stack.push_back(item);
-    int ret = ProcessNestedItems(item->nested, processed_stack);
+    int ret = ProcessNestedItems(item->nested, processed_stack, invalid);
     processed_stack.pop_back();
     return ret;
   }
 
-  int Config::Validate(const ConfigSchema & schema, const ConfigItem* item, std::vector<const ConfigItem*> & processed_stack) const {
-    for(auto mand : schema.mandatory){
-      std::string val = item->Attribute(mand);
-      if(val.size() == 0){
-        std::string str = item->AsString();
-        msg_warning("item", quote(str), "has no mandatory attribute \"" + mand + "\"" );
-        return PM_ERROR_SCHEMA;
-      }
-    }
-
-    if(processed_stack.size() < schema.fathers.size()){
-      std::string str = item->AsString();
-      msg_warning("item", quote(str), "nested depth requirements =", schema.fathers.size(), "> stack size =", processed_stack.size() );
-      return PM_ERROR_SCHEMA;
-    }
-
-    int depth = 1;
-    for(auto father : schema.fathers){
-      const ConfigItem * cfg = processed_stack.at(schema.fathers.size() - depth);
-      if(cfg->type != father){
-        std::string str = item->AsString();
-        msg_warning(quote(str), "at depth level ", depth, " requires father", quote(father), " != ", quote(cfg->type));
-        return PM_ERROR_SCHEMA;
-      }
-      depth += 1;
+  void Config::ReportViolations(const std::vector<ConfigViolation> & violations, std::unordered_set<const ConfigItem*> & invalid) const {
+    for(const ConfigViolation & v : violations){
+      invalid.insert(v.item);
+      std::string item = v.item->type + (v.item->HasAttribute("id") ? ":" + v.item->Attribute("id") : "");
+      if(v.kind == cfg_violation::MANDATORY){ msg_warning("item", quote(item), "has no mandatory attribute", quote(v.what)); }
+      else if(v.kind == cfg_violation::DEPTH){ msg_warning("item", quote(item), "is nested less deep than required by its fathers list"); }
+      else { msg_warning("item", quote(item), "requires father", quote(v.what)); }
     }
-
-    return PM_SUCCESS;
   }
 
   //! add schema and function to validate and process config item element
   void Config::AddProcessingRule(std::string key, const ConfigSchema & schema, std::function<int(const ConfigItem*)> proccessor) {
     processing_rules[key] = ConfigProcessingRule(schema, proccessor);
+    compiled_schema = nullptr;
   }
 
   void Config::AddProcessingRule(std::string key, std::function<int(const ConfigItem*)> proccessor) {
     processing_rules[key] = ConfigProcessingRule(proccessor);
+    compiled_schema = nullptr;
+  }
+
+  const CompiledConfigSchema & Config::Schema() const {
+    if(compiled_schema == nullptr){
+      compiled_schema = std::make_shared<CompiledConfigSchema>();
+      compiled_schema->Compile(processing_rules);
+    }
+    return *compiled_schema;
+  }
+
+  int Config::ValidateItems(std::vector<ConfigViolation> & violations) const {
+    std::unordered_set<const ConfigItem*> invalid;
+    int ret = Schema().ValidateNested(this, {}, violations);
+    ReportViolations(violations, invalid);
+    return ret;
   }
 
   int Config::ProcessItems(std::vector<const ConfigItem*> & processed_stack) const {
     /// top element do not have attributes, thus, this is directly alias over ProcessNestedItems
-    return ProcessNestedItems(this->nested, processed_stack);
+    std::vector<ConfigViolation> violations;
+    std::unordered_set<const ConfigItem*> invalid;
+    Schema().ValidateNested(this, processed_stack, violations);
+    ReportViolations(violations, invalid);
+    return ProcessNestedItems(this->nested, processed_stack, invalid);
+  }
+
+  int Config::ProcessSubtree(const ConfigItem* item, std::vector<const ConfigItem*> & processed_stack) const {
+    const ConfigProcessingRule * rule = map_get_ptr(processing_rules, item->type);
+    if(rule == nullptr) rule = &default_processing_rule;
+
+    std::vector<ConfigViolation> violations;
+    std::unordered_set<const ConfigItem*> invalid;
+    Schema().Validate(item, processed_stack, violations);
+    ReportViolations(violations, invalid);
+    return ProcessItem(item, *rule, processed_stack, invalid);
   }
 
   std::string Config::ProcessTemplate(std::string raw) const {
-    /// TODO
-    return raw;
+    if(not is_template(raw)) return raw;
+    auto program = compile_template(raw);
+    if(program == nullptr){
+      msg_warning("config template is invalid, use raw config");
+      return raw;
+    }
+    return program->Expand(template_vars);
   }
 
   std::string Config::IdFromPath(std::string & path) const {
@@ -193,6 +325,181 @@ namespace pmgd {
   }
 
   // ======= ConfigLoader ====================================================================
+  // ======= JsonConfigLoaderImp ====================================================================
+  void JsonConfigLoaderImp::Fail(const char * what){
+    if(failed) return;
+    failed = true;
+    int line = 1 + std::count(begin, ptr, '\n');
+    msg_warning("json config error at line", line, ":", what);
+  }
+
+  void JsonConfigLoaderImp::SkipSpaces(){
+    while(ptr < end and (*ptr == ' ' or *ptr == '\n' or *ptr == '\r' or *ptr == '\t')) ++ptr;
+  }
+
+  bool JsonConfigLoaderImp::Expect(char c){
+    SkipSpaces();
+    if(ptr < end and *ptr == c){ ++ptr; return true; }
+    Fail((std::string("expected '") + c + "'").c_str());
+    return false;
+  }
+
+  static int json_hex(const char * ptr){
+    int value = 0;
+    for(int i = 0; i < 4; ++i){
+      char c = ptr[i];
+      value <<= 4;
+      if(c >= '0' and c <= '9') value |= c - '0';
+      else if(c >= 'a' and c <= 'f') value |= c - 'a' + 10;
+      else if(c >= 'A' and c <= 'F') value |= c - 'A' + 10;
+      else return -1;
+    }
+    return value;
+  }
+
+  static void json_utf8(std::string & out, unsigned int cp){
+    if(cp < 0x80) out += char(cp);
+    else if(cp < 0x800){ out += char(0xC0 | (cp >> 6)); out += char(0x80 | (cp & 0x3F)); }
+    else if(cp < 0x10000){ out += char(0xE0 | (cp >> 12)); out += char(0x80 | ((cp >> 6) & 0x3F)); out += char(0x80 | (cp & 0x3F)); }
+    else { out += char(0xF0 | (cp >> 18)); out += char(0x80 | ((cp >> 12) & 0x3F)); out += char(0x80 | ((cp >> 6) & 0x3F)); out += char(0x80 | (cp & 0x3F)); }
+  }
+
+  bool JsonConfigLoaderImp::ParseString(std::string & out){
+    out.clear();
+    if(not Expect('"')) return false;
+    while(true){
+      /// copy runs of plain chars at once
+      const char * run = ptr;
+      while(ptr < end and *ptr != '"' and *ptr != '\\' and (unsigned char)*ptr >= 0x20) ++ptr;
+      out.append(run, ptr - run);
+      if(ptr >= end){ Fail("string is not closed"); return false; }
+      if(*ptr == '"'){ ++ptr; return true; }
+      if(*ptr != '\\'){ Fail("control character in string"); return false; }
+
+      if(++ptr >= end){ Fail("string is not closed"); return false; }
+      char c = *ptr++;
+      switch(c){
+        case '"': case '\\': case '/': out += c; break;
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+          int cp = end - ptr >= 4 ? json_hex(ptr) : -1;
+          if(cp < 0){ Fail("invalid \\u escape"); return false; }
+          ptr += 4;
+          if(cp >= 0xD800 and cp < 0xDC00 and end - ptr >= 6 and ptr[0] == '\\' and ptr[1] == 'u'){
+            int low = json_hex(ptr + 2);
+            if(low >= 0xDC00 and low < 0xE000){
+              cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+              ptr += 6;
+            }
+          }
+          /// unpaired surrogates can't be encoded in UTF-8, write U+FFFD
+          if(cp >= 0xD800 and cp < 0xE000) cp = 0xFFFD;
+          json_utf8(out, cp);
+          break;
+        }
+        default: Fail("invalid escape"); return false;
+      }
+    }
+  }
+
+  bool JsonConfigLoaderImp::ParseScalar(std::string & out, bool & is_null){
+    is_null = false;
+    if(*ptr == '"') return ParseString(out);
+
+    auto literal = [this](const char * word, int size){
+      if(end - ptr < size or strncmp(ptr, word, size)) return false;
+      ptr += size;
+      return true;
+    };
+    if(literal("true", 4)){ out = "true"; return true; }
+    if(literal("false", 5)){ out = "false"; return true; }
+    if(literal("null", 4)){ is_null = true; return true; }
+
+    /// numbers are kept as written
+    const char * start = ptr;
+    if(ptr < end and *ptr == '-') ++ptr;
+    const char * digits = ptr;
+    while(ptr < end and ((*ptr >= '0' and *ptr <= '9') or *ptr == '.' or *ptr == 'e' or *ptr == 'E' or *ptr == '+' or *ptr == '-')) ++ptr;
+    if(ptr == digits or not (*digits >= '0' and *digits <= '9')){
+      ptr = start;
+      Fail("unexpected value");
+      return false;
+    }
+    out.assign(start, ptr - start);
+    return true;
+  }
+
+  bool JsonConfigLoaderImp::ParseArray(ConfigItem* item, const std::string & key, int depth){
+    ++ptr;
+    SkipSpaces();
+    if(ptr < end and *ptr == ']'){ ++ptr; return true; }
+    while(true){
+      SkipSpaces();
+      if(ptr >= end or *ptr != '{'){ Fail("array should contain objects only"); return false; }
+      ConfigItem* child = new ConfigItem();
+      child->type = key;
+      item->Add(key, child);
+      if(not ParseObject(child, depth + 1)) return false;
+
+      SkipSpaces();
+      if(ptr < end and *ptr == ','){ ++ptr; continue; }
+      return Expect(']');
+    }
+  }
+
+  bool JsonConfigLoaderImp::ParseObject(ConfigItem* item, int depth){
+    if(depth > MAX_DEPTH){ Fail("too deep nesting"); return false; }
+    if(not Expect('{')) return false;
+    SkipSpaces();
+    if(ptr < end and *ptr == '}'){ ++ptr; return true; }
+
+    std::string key, value;
+    while(true){
+      SkipSpaces();
+      if(not ParseString(key)) return false;
+      if(not Expect(':')) return false;
+      SkipSpaces();
+      if(ptr >= end){ Fail("unexpected end"); return false; }
+
+      if(*ptr == '{'){
+        ConfigItem* child = new ConfigItem();
+        child->type = key;
+        item->Add(key, child);
+        if(not ParseObject(child, depth + 1)) return false;
+      } else if(*ptr == '['){
+        if(not ParseArray(item, key, depth)) return false;
+      } else {
+        bool is_null;
+        if(not ParseScalar(value, is_null)) return false;
+        if(not is_null) item->AddAttribute(std::move(key), std::move(value));
+      }
+
+      SkipSpaces();
+      if(ptr < end and *ptr == ','){ ++ptr; continue; }
+      return Expect('}');
+    }
+  }
+
+  void JsonConfigLoaderImp::ToCfg(std::string_view raw, std::shared_ptr<Config> cfg, std::string id){
+    begin = ptr = raw.data();
+    end = raw.data() + raw.size();
+    failed = false;
+    if(end - ptr >= 3 and not strncmp(ptr, "\xEF\xBB\xBF", 3)) ptr += 3;
+
+    cfg->type = "cfg";
+    cfg->AddAttribute("id", id);
+    if(ParseObject(cfg.get(), 0)){
+      SkipSpaces();
+      if(ptr != end) Fail("unexpected data after the top object");
+    }
+    cfg->AddAttribute("id", id);
+    if(failed) cfg->valid = false;
+  }
+
   #ifdef USE_TINYXML2
     void TinyXmlConfigLoaderImp::ToCfgRec(ConfigItem* item, const tinyxml2::XMLElement* head){
       /// add attributes
@@ -208,10 +515,7 @@ namespace pmgd {
         ConfigItem* child_item = new ConfigItem();
         child_item->type = name;
         ToCfgRec(child_item, child);
-
-        msg("><");
         item->Add(name, child_item);
-        msg("><x");
       }
     }
   #endif
@@ -241,28 +545,253 @@ namespace pmgd {
     return ret;
   }
 
+  int ProtoLoader::LoadSubtree(std::shared_ptr<Config> cfg, const std::vector<std::string> & keys, const ConfigItem* item){
+    msg_debug("load subtree start ...", item->type, item->Attribute("id", "-"));
+    for(auto key : keys){
+      cfg->AddProcessingRule(key, [this](const ConfigItem* c) {return this->LoadProtoObject(c);});
+    }
+
+    /// fathers of the item without the top Config item
+    proto_objects.clear();
+    processed_stack.clear();
+    for(const ConfigItem* head = item->father; head != nullptr and head->father != nullptr; head = head->father)
+      processed_stack.push_back(head);
+    std::reverse(processed_stack.begin(), processed_stack.end());
+
+    int ret = cfg->ProcessSubtree(item, processed_stack);
+    msg_debug("load subtree done ...", ret);
+    return ret;
+  }
+
+  // ======= config diff ====================================================================
+  static std::string cfg_item_key_part(const ConfigItem* item, int index){
+    auto it = item->attributes.find("id");
+    if(it != item->attributes.end()) return it->second;
+    return "#" + std::to_string(index);
+  }
+
+  NdKey cfg_item_key(const ConfigItem* item){
+    std::vector<const ConfigItem*> stack;
+    for(const ConfigItem* head = item; head != nullptr; head = head->father)
+      stack.push_back(head);
+
+    NdKey key;
+    for(int i = stack.size() - 1; i >= 0; --i){
+      const ConfigItem* cfg = stack[i];
+      if(cfg->father == nullptr){
+        key.Add(cfg->Attribute("id"));
+        continue;
+      }
+
+      int index = 0;
+      auto group = cfg->father->nested.find(cfg->type);
+      if(group != cfg->father->nested.end()){
+        auto pos = std::find(group->second.begin(), group->second.end(), cfg);
+        index = pos - group->second.begin();
+      }
+      key.Add(cfg->type);
+      key.Add(cfg_item_key_part(cfg, index));
+    }
+    return key;
+  }
+
+  static void diff_cfg_rec(const ConfigItem* old_item, const ConfigItem* new_item, const NdKey & key, std::vector<ConfigChange> & changes, bool keep_same){
+    ConfigChange change;
+    change.kind = (old_item->attributes == new_item->attributes) ? cfg_change::SAME : cfg_change::MODIFIED;
+    change.key = key;
+    change.old_item = old_item;
+    change.new_item = new_item;
+    if(change.kind != cfg_change::SAME or keep_same) changes.push_back(change);
+
+    /// groups present only in the old item are removed completely
+    for(auto iter : old_item->nested){
+      if(new_item->nested.count(iter.first)) continue;
+      for(int i = 0; i < iter.second.size(); ++i){
+        ConfigChange removed;
+        removed.kind = cfg_change::REMOVED;
+        removed.key = key + NdKey(iter.first, cfg_item_key_part(iter.second[i], i));
+        removed.old_item = iter.second[i];
+        changes.push_back(removed);
+      }
+    }
+
+    for(auto iter : new_item->nested){
+      const std::string & type = iter.first;
+      const std::vector<ConfigItem*> & new_group = iter.second;
+
+      /// match items of the group by id, first item wins for duplicated ids
+      std::unordered_map<std::string, std::pair<int, const ConfigItem*>> old_group;
+      auto old_find = old_item->nested.find(type);
+      if(old_find != old_item->nested.end()){
+        for(int i = 0; i < old_find->second.size(); ++i)
+          old_group.emplace(cfg_item_key_part(old_find->second[i], i), std::make_pair(i, old_find->second[i]));
+      }
+
+      for(int i = 0; i < new_group.size(); ++i){
+        std::string part = cfg_item_key_part(new_group[i], i);
+        NdKey item_key = key + NdKey(type, part);
+        auto match = old_group.find(part);
+        if(match == old_group.end()){
+          ConfigChange added;
+          added.kind = cfg_change::ADDED;
+          added.key = item_key;
+          added.new_item = new_group[i];
+          changes.push_back(added);
+          continue;
+        }
+        diff_cfg_rec(match->second.second, new_group[i], item_key, changes, keep_same);
+        old_group.erase(match);
+      }
+
+      for(auto left : old_group){
+        ConfigChange removed;
+        removed.kind = cfg_change::REMOVED;
+        removed.key = key + NdKey(type, left.first);
+        removed.old_item = left.second.second;
+        changes.push_back(removed);
+      }
+    }
+  }
+
+  void diff_cfg(const ConfigItem* old_cfg, const ConfigItem* new_cfg, std::vector<ConfigChange> & changes, bool keep_same){
+    /// top items are Configs, they are matched by definition
+    NdKey key(new_cfg->Attribute("id"));
+    diff_cfg_rec(old_cfg, new_cfg, key, changes, keep_same);
+  }
+
   // ======= functions to use outside ====================================================================
   //! internal function to detect cfg format
-  static std::string get_cfg_fmt(const std::string & raw){
+  static std::string get_cfg_fmt(std::string_view raw){
+    /// first significant char, skipping utf-8 BOM and spaces
+    size_t pos = raw.compare(0, 3, "\xEF\xBB\xBF") ? 0 : 3;
+    pos = raw.find_first_not_of(" \t\r\n", pos);
+    if(pos != std::string_view::npos and raw[pos] == '{') return "json";
     return "xml";
   }
 
   //! function to detect cfg format
-  std::shared_ptr<Config> load_cfg(const std::string & raw, const std::string id){
+  std::shared_ptr<Config> load_cfg(std::string_view raw, const std::string id){
+    return load_cfg(raw, id, {});
+  }
+
+  std::shared_ptr<Config> load_cfg(std::string_view raw, const std::string id, const std::map<std::string, std::string> & template_vars){
+    auto cfg = std::make_shared<Config>();
+    cfg->template_vars = template_vars;
+    std::string expanded;
+    if(is_template(raw)) expanded = cfg->ProcessTemplate(std::string(raw));
+    std::string_view src = expanded.size() ? std::string_view(expanded) : raw;
+
     std::shared_ptr<ConfigLoaderImp> cli = nullptr;
-    auto fmt = get_cfg_fmt(raw);
+    auto fmt = get_cfg_fmt(src);
     if(fmt == "xml"){
       #ifdef USE_TINYXML2
         cli = std::make_shared<TinyXmlConfigLoaderImp>();
       #endif
+    } else if(fmt == "json"){
+      cli = std::make_shared<JsonConfigLoaderImp>();
     }
 
-    auto cfg = std::make_shared<Config>();
     if(cli){
-      cli->ToCfg(raw, cfg, id);
+      cli->ToCfg(src, cfg, id);
     } else {
       msg_err("config loader implementation is nullptr");
     }
+
+    /// partially parsed config is dropped, so file loads & reloads keep the previous one
+    if(not cfg->valid){
+      msg_err("can't parse config", quote(id));
+      return nullptr;
+    }
+    return cfg;
+  }
+
+  //! file of the include tree
+  struct cfg_file_node {
+    std::string path;
+    std::shared_ptr<Config> cfg;
+    std::vector<int> includes;
+    int state = 0; /// 0 - not merged, 1 - merging, 2 - merged
+  };
+
+  static void merge_cfg_files(std::vector<cfg_file_node> & files, int index, std::shared_ptr<Config> answer){
+    cfg_file_node & file = files[index];
+    if(file.state == 2) return;
+    if(file.state == 1){
+      msg_err("include loop detected at", quote(file.path), "skip");
+      return;
+    }
+    file.state = 1;
+
+    /// includes first in order of appearance, the file itself last, so it overrides attributes of included files
+    for(int include : file.includes) merge_cfg_files(files, include, answer);
+    file.cfg->nested.erase("include");
+    answer->Merge(file.cfg.get());
+    file.state = 2;
+  }
+
+  std::shared_ptr<Config> load_cfg_file(const std::string & path, const std::string id, std::shared_ptr<IoTxt> io, std::vector<std::string> * paths){
+    std::vector<cfg_file_node> files;
+    std::unordered_map<std::string, int> indexes;
+
+    files.emplace_back();
+    files[0].path = std::filesystem::path(path).lexically_normal().string();
+    indexes[files[0].path] = 0;
+
+    /// files of one include level are read & parsed concurrently
+    std::vector<int> level = {0};
+    while(level.size()){
+      parallel_for(thread_pool(), 0, level.size(), [&](int i_start, int i_end){
+        for(int i = i_start; i < i_end; ++i){
+          cfg_file_node & file = files[level[i]];
+          TxtView txt = io->View(file.path);
+          if(txt.owner == nullptr or txt.data.empty()) continue;
+          file.cfg = load_cfg(txt.data, id);
+        }
+      });
+
+      std::vector<int> next_level;
+      for(int index : level){
+        if(files[index].cfg == nullptr) continue;
+        std::filesystem::path dir = std::filesystem::path(files[index].path).parent_path();
+        std::vector<std::string> includes = files[index].cfg->GetAttrsFromNested("include", "path");
+        for(const std::string & include : includes){
+          std::filesystem::path include_path(include);
+          if(include_path.is_relative()) include_path = dir / include_path;
+          std::string include_str = include_path.lexically_normal().string();
+
+          auto find = indexes.find(include_str);
+          if(find != indexes.end()){
+            files[index].includes.push_back(find->second);
+            continue;
+          }
+
+          int include_index = files.size();
+          files.emplace_back();
+          files.back().path = include_str;
+          indexes[include_str] = include_index;
+          files[index].includes.push_back(include_index);
+          next_level.push_back(include_index);
+        }
+      }
+      std::swap(level, next_level);
+    }
+
+    if(paths != nullptr)
+      for(auto & file : files) paths->push_back(file.path);
+
+    /// missing or empty file of the tree fails the whole load, so a reload keeps the previous config
+    bool missing = false;
+    for(auto & file : files){
+      if(file.cfg != nullptr) continue;
+      msg_err("can't read config file", quote(file.path));
+      missing = true;
+    }
+    if(missing) return nullptr;
+
+    auto cfg = std::make_shared<Config>();
+    cfg->type = "cfg";
+    merge_cfg_files(files, 0, cfg);
+    cfg->AddAttribute("id", id);
     return cfg;
   }
 
@@ -277,6 +806,11 @@ namespace pmgd {
       if(item->HasAttribute("accelerator")) sysopt.accelerator = item->Attribute("accelerator");
       if(item->HasAttribute("io_backend")) sysopt.io = item->Attribute("io_backend");
       if(item->HasAttribute("img_backend")) sysopt.img = item->Attribute("img_backend");
+      if(item->HasAttribute("pack")) sysopt.pack = item->Attribute("pack");
+      if(item->HasAttribute("img_cache")) sysopt.img_cache = item->Attribute("img_cache");
+      if(item->HasAttribute("img_cache_size")) sysopt.img_cache_size = item->AttributeI("img_cache_size");
+      if(item->HasAttribute("img_mips")) sysopt.img_mips = item->Attribute("img_mips");
+      if(item->HasAttribute("memory_budget")) sysopt.memory_budget = item->AttributeI("memory_budget");
     }
     return sysopt;
   }
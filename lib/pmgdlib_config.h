@@ -7,11 +7,17 @@
 #include <functional>
 #include <vector>
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <string_view>
 
 #include "pmgdlib_std.h"
 #include "pmgdlib_msg.h"
 #include "pmgdlib_core.h"
 #include "pmgdlib_string.h"
+#include "pmgdlib_template.h"
 
 #ifdef USE_TINYXML2
   #include "tinyxml2.h"
@@ -34,7 +40,7 @@ namespace pmgd {
     void AddAttribute(std::string && name, std::string && value);
     void Add(std::string name, ConfigItem *value);
 
-    /// Merge with another cfg
+    /// Merge with another cfg, nested items of other with the ids of existing items replace them
     bool Merge(ConfigItem * other);
 
     /// check if has attribute
@@ -73,29 +79,93 @@ namespace pmgd {
     ConfigProcessingRule(){proccessor = [](const ConfigItem* c) { return PM_SUCCESS; };}
   };
 
+  // ======= compiled schema ====================================================================
+  namespace cfg_violation {
+    enum {
+      MANDATORY = 0, /// missing or empty mandatory attribute <what>
+      DEPTH,         /// item is nested less deep than its fathers list
+      FATHER,        /// father at some depth is not of type <what>
+    };
+  };
+
+  struct ConfigViolation {
+    const ConfigItem* item = nullptr;
+    int kind = cfg_violation::MANDATORY;
+    std::string what;
+  };
+
+  //! schemas of processing rules compiled into per-type tables,
+  //! attribute and type names are interned into ids, mandatory attributes are sorted
+  //! to be checked against item attributes in one merge walk
+  class CompiledConfigSchema : public BaseMsg {
+    struct TypeTable {
+      std::vector<int> mandatory; /// attribute ids sorted by name
+      std::vector<int> fathers;   /// type ids, same order as in ConfigSchema
+    };
+
+    std::vector<std::string> attr_names;
+    std::unordered_map<std::string, int> attr_ids;
+    std::vector<std::string> type_names;
+    std::unordered_map<std::string, int> type_ids;
+    std::vector<TypeTable> tables; /// by type id
+
+    int Intern(std::unordered_map<std::string, int> & ids, std::vector<std::string> & names, const std::string & name);
+    void ValidateItem(const ConfigItem* item, int type, const std::vector<int> & father_types, std::vector<ConfigViolation> & violations) const;
+    void ValidateNestedItems(const ConfigItem* item, std::vector<int> & father_types, std::vector<ConfigViolation> & violations) const;
+
+    public:
+    void Compile(const std::map<std::string, ConfigProcessingRule> & rules);
+
+    //! -1 if type is not known
+    int TypeId(const std::string & type) const;
+
+    //! validate item with all nested items in one pass and collect all violations,
+    //! processed_stack should contain item fathers (without the top Config)
+    int Validate(const ConfigItem* item, const std::vector<const ConfigItem*> & processed_stack, std::vector<ConfigViolation> & violations) const;
+
+    //! same but only nested items of item are validated, used for the top Config
+    int ValidateNested(const ConfigItem* item, const std::vector<const ConfigItem*> & processed_stack, std::vector<ConfigViolation> & violations) const;
+  };
+
   class Config : public ConfigItem {
     std::map<std::string, ConfigProcessingRule> processing_rules;
     ConfigProcessingRule default_processing_rule;
+    mutable std::shared_ptr<CompiledConfigSchema> compiled_schema; /// reset when rules are changed
 
     int ProcessNestedGroup(const std::vector<ConfigItem*> & group, const ConfigProcessingRule & rule, 
       std::vector<const ConfigItem*> & processed_stack) const;
 
     int ProcessNestedItems(const std::map<std::string, std::vector<ConfigItem*>> & nested, 
-      std::vector<const ConfigItem*> & processed_stack) const;
+      std::vector<const ConfigItem*> & processed_stack, const std::unordered_set<const ConfigItem*> & invalid) const;
 
     int ProcessItem(const ConfigItem* item, const ConfigProcessingRule & rule, 
-      std::vector<const ConfigItem*> & processed_stack) const;
+      std::vector<const ConfigItem*> & processed_stack, const std::unordered_set<const ConfigItem*> & invalid) const;
 
-    public:
-    int Validate(const ConfigSchema & schema, const ConfigItem* item, 
-      std::vector<const ConfigItem*> & processed_stack) const;
+    void ReportViolations(const std::vector<ConfigViolation> & violations, std::unordered_set<const ConfigItem*> & invalid) const;
 
+    public:
     //! add schema and function to validate and process config item element
     void AddProcessingRule(std::string key, const ConfigSchema & schema, std::function<int(const ConfigItem*)> proccessor);
     void AddProcessingRule(std::string key, std::function<int(const ConfigItem*)> proccessor);
 
+    //! schema of all processing rules, compiled on first use after rules are changed
+    const CompiledConfigSchema & Schema() const;
+
+    //! validate all items in one pass, every violation is reported, PM_ERROR_SCHEMA if there are any
+    int ValidateItems(std::vector<ConfigViolation> & violations) const;
+
+    //! validate all items, then process valid ones, invalid items are skipped with their nested items
     int ProcessItems(std::vector<const ConfigItem*> & processed_stack) const;
 
+    //! process one item and its nested items with the rule registered for item type,
+    //! processed_stack should contain item fathers (without the top Config)
+    int ProcessSubtree(const ConfigItem* item, std::vector<const ConfigItem*> & processed_stack) const;
+
+    //! variables for ${name} in config templates, see pmgdlib_template.h
+    std::map<std::string, std::string> template_vars;
+    void SetTemplateVar(const std::string & name, const std::string & value){ template_vars[name] = value; }
+
+    //! expand raw config template with template_vars, raw is returned as is if it is not a template or invalid
     std::string ProcessTemplate(std::string raw) const;
 
     std::string IdFromPath(std::string & path) const;
@@ -106,7 +176,34 @@ namespace pmgd {
       public:
       virtual ~ConfigLoaderImp(){}
       /// predefined function to load data into internal cfg format
-      virtual void ToCfg(const std::string & raw, std::shared_ptr<Config> cfg, std::string id = "") = 0;
+      virtual void ToCfg(std::string_view raw, std::shared_ptr<Config> cfg, std::string id = "") = 0;
+  };
+
+  //! JSON config, object keys are mapped to the same ConfigItem tree as xml:
+  //!   scalar value  -> attribute, numbers & true/false are kept as written, null is skipped
+  //!   object value  -> one nested item with type = key
+  //!   array value   -> nested items with type = key, array should contain objects only
+  //! e.g. {"texture": [{"id": "t1", "path": "t1.png"}], "scene": {"id": "s1"}}
+  //! parsed in one pass straight from the input, strings are copied only into the final attributes
+  class JsonConfigLoaderImp : public ConfigLoaderImp {
+    static const int MAX_DEPTH = 256;
+
+    const char * begin = nullptr;
+    const char * ptr = nullptr;
+    const char * end = nullptr;
+    bool failed = false;
+
+    void Fail(const char * what);
+    void SkipSpaces();
+    bool Expect(char c);
+    bool ParseString(std::string & out);
+    bool ParseScalar(std::string & out, bool & is_null);
+    bool ParseObject(ConfigItem* item, int depth);
+    bool ParseArray(ConfigItem* item, const std::string & key, int depth);
+
+    public:
+    virtual ~JsonConfigLoaderImp(){}
+    virtual void ToCfg(std::string_view raw, std::shared_ptr<Config> cfg, std::string id = "");
   };
 
   #ifdef USE_TINYXML2
@@ -117,8 +214,8 @@ namespace pmgd {
 
       public:
       virtual ~TinyXmlConfigLoaderImp(){}
-      virtual void ToCfg(const std::string & raw, std::shared_ptr<Config> cfg, std::string id = ""){
-        doc.Parse(raw.c_str());
+      virtual void ToCfg(std::string_view raw, std::shared_ptr<Config> cfg, std::string id = ""){
+        doc.Parse(raw.data(), raw.size());
 
         cfg->type = "cfg";
         cfg->AddAttribute("id", id);
@@ -139,8 +236,13 @@ namespace pmgd {
     const ConfigItem * cfg_item;
     std::shared_ptr<void> object = nullptr;
 
+    size_t bytes = 0;      /// approximate memory used by warm object
+    uint64_t last_use = 0; /// tick of the last use, see ProtoCache
+    int pins = 0;          /// pinned objects are never cooled by ProtoCache
+
     ProtoObject(const ConfigItem * cfg_item_): cfg_item(cfg_item_) {}
-    bool IsWarm(){ return object == nullptr; }
+    bool IsWarm(){ return object != nullptr; }
+    void Cool(){ object = nullptr; bytes = 0; }
   };
 
   //! get Config as input and setup ProtoObjects
@@ -157,12 +259,51 @@ namespace pmgd {
 
     // actual loading of ProtoObjects with type in <keys> from <cfg>
     int Load(std::shared_ptr<Config> cfg, const std::vector<std::string> & keys);
+
+    // same as Load() but only for the <item> subtree of the <cfg>
+    int LoadSubtree(std::shared_ptr<Config> cfg, const std::vector<std::string> & keys, const ConfigItem* item);
     std::vector<std::shared_ptr<ProtoObject>> proto_objects;
   };  
 
+  // ======= config diff ====================================================================
+  namespace cfg_change {
+    enum {
+      SAME = 0,
+      MODIFIED,
+      ADDED,
+      REMOVED,
+    };
+  };
+
+  //! difference between two ConfigItem trees for one item matched by (type, id) path
+  struct ConfigChange {
+    int kind = cfg_change::SAME;
+    NdKey key;
+    const ConfigItem * old_item = nullptr;
+    const ConfigItem * new_item = nullptr;
+  };
+
+  //! (type, id) path of the item in the config tree, same key is used to store ProtoObjects in NdMap
+  //! items without "id" attribute use "#N" where N is the item index in the father group
+  NdKey cfg_item_key(const ConfigItem* item);
+
+  //! compare trees item by item, MODIFIED means item own attributes differ,
+  //! ADDED/REMOVED are reported once for the top item of the subtree,
+  //! SAME items are reported only if keep_same is true
+  void diff_cfg(const ConfigItem* old_cfg, const ConfigItem* new_cfg, std::vector<ConfigChange> & changes, bool keep_same = false);
+
   // ======= functions to use outside ====================================================================
   //! use this function to load raw cfg into Config class with ConfigItems
-  std::shared_ptr<Config> load_cfg(const std::string & raw, const std::string id);
+  std::shared_ptr<Config> load_cfg(std::string_view raw, const std::string id);
+  //! same with template variables for ${name} in raw cfg
+  std::shared_ptr<Config> load_cfg(std::string_view raw, const std::string id, const std::map<std::string, std::string> & template_vars);
+
+  //! load cfg file with all files included by <include path="..."/> items, paths are relative to the including file,
+  //! files of the same include depth are read & parsed in parallel, then merged in depth-first order:
+  //! included files go before the including one in order of <include> items, so the including file has the last word,
+  //! items with the same type & id are replaced by the later one, paths of all loaded files are added to <paths> if provided,
+  //! nullptr is returned if any file of the tree is missing or empty
+  std::shared_ptr<Config> load_cfg_file(const std::string & path, const std::string id, std::shared_ptr<IoTxt> io, std::vector<std::string> * paths = nullptr);
 
   //! get base engine sys options from config
   SysOptions get_cfg_sys_options(std::shared_ptr<Config> cfg);
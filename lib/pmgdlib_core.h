@@ -13,6 +13,8 @@
 #include "pmgdlib_graph.h"
 #include "pmgdlib_storage.h"
 #include <stack>
+#include <functional>
+#include <string_view>
 
 namespace pmgd {
   // mouse base class =====================================================================================================
@@ -117,14 +119,28 @@ namespace pmgd {
   };
 
   // io related items =====================================================================================================
+  //! read-only text data, owner keeps the storage (std::string, mapped file, ...) alive
+  struct TxtView {
+    std::string_view data;
+    std::shared_ptr<const void> owner;
+
+    std::string Str() const { return std::string(data); }
+  };
+
   class IoTxt {
     public:
     virtual std::string Read(const std::string & path) {return "dummy data";};
+    //! read without copies if the implementation supports it, default view owns the Read() result
+    virtual TxtView View(const std::string & path) {
+      auto str = std::make_shared<const std::string>(Read(path));
+      return TxtView{*str, str};
+    };
     virtual int Write(const std::string & path, const std::string & data) {return PM_SUCCESS;};
     virtual ~IoTxt(){};
   };
 
   class Image;
+  struct ImageView;
   class IoImage : public BaseMsg {
     public:
     virtual std::shared_ptr<Image> Read(const std::string & path) {
@@ -135,6 +151,20 @@ namespace pmgd {
       msg_warning("function not implemented");
       return PM_SUCCESS;
     };
+    //! write part of an image, default implementation packs the view and calls Write()
+    virtual int WriteView(const std::string & path, const ImageView & view);
+    //! read many images, done(index, image) is called on the calling thread for every path as images are ready,
+    //! max_bytes limits decoded pixels waiting for done(), 0 - no limit, return number of read images,
+    //! default implementation reads one by one
+    virtual int ReadBatch(const std::vector<std::string> & paths, const std::function<void(int, std::shared_ptr<Image>)> & done, size_t max_bytes = 256 << 20) {
+      int answer = 0;
+      for(int i = 0; i < paths.size(); ++i){
+        std::shared_ptr<Image> img = Read(paths[i]);
+        if(img) answer++;
+        done(i, img);
+      }
+      return answer;
+    };
     virtual ~IoImage(){};
   };
 
@@ -147,13 +177,25 @@ namespace pmgd {
       return txt_imp->Read(path);
     }
 
+    TxtView ViewTxt(const std::string & path){
+      return txt_imp->View(path);
+    }
+
     std::shared_ptr<Image> ReadImage(const std::string & path){
       return img_imp->Read(path);
     }
 
+    int ReadImages(const std::vector<std::string> & paths, const std::function<void(int, std::shared_ptr<Image>)> & done, size_t max_bytes = 256 << 20){
+      return img_imp->ReadBatch(paths, done, max_bytes);
+    }
+
     int WriteImage(const std::string & path, std::shared_ptr<Image> image){
       return img_imp->Write(path, image);
     }
+
+    int WriteImage(const std::string & path, const ImageView & view){
+      return img_imp->WriteView(path, view);
+    }
   };
 
   // drawing related items =================================================================================================
@@ -225,11 +267,16 @@ namespace pmgd {
     std::string accelerator;
     std::string io;
     std::string img;
+    std::string pack; /// archive for "PACK" io & img backends
+    std::string img_cache; /// directory of decoded images cache, empty - no cache
+    int img_cache_size = 1024; /// MB of the decoded images cache, 0 - no limit
+    std::string img_mips; /// "BOX" or "KAISER" - cached images are stored with mip chains
     int fps = 60;
+    int memory_budget = 0; /// MB of warm objects before LRU ones are cooled, 0 - no limit
 
     // aliases
-    bool gl;
-    bool soft_render;
+    bool gl = false;
+    bool soft_render = false;
 
     void Finilize(){
       gl = accelerator == "GL";
@@ -244,6 +291,8 @@ namespace pmgd {
       answer += tabs2 + "Backends:\n";
       answer += tabs4 + "io backend = " + io + "\n";
       answer += tabs4 + "img backend = " + img + "\n";
+      answer += tabs4 + "pack = " + pack + "\n";
+      answer += tabs4 + "img cache = " + img_cache + " " + std::to_string(img_cache_size) + " MB " + img_mips + "\n";
       answer += tabs4 + "multimedia_library backend = " + multimedia_library + "\n";
       answer += tabs4 + "accelerator backend = " + accelerator + "\n";
       answer += tabs2 + "Screen options:" + "\n";
@@ -4,15 +4,42 @@
 
 namespace pmgd {
   //================================================ Base classes
-  TexTile * TexAtlas::Get(const std::string & key){
-    auto ptr = atlas.find(key);
-    if(ptr == atlas.end()) return nullptr;
-    return &(ptr->second);
+  int TexAtlas::Handle(const std::string & key) const {
+    auto ptr = names.find(key);
+    if(ptr == names.end()) return -1;
+    return ptr->second;
   }
 
-  void TexAtlas::Add(const std::string & key, const v2 & tp, const v2 & ts){
-    if(Get(key)) return;
-    atlas[key] = TexTile(tp, ts);
+  int TexAtlas::Add(const std::string & key, const v2 & tp, const v2 & ts){
+    int handle = Handle(key);
+    if(handle >= 0) return handle;
+    names[key] = tiles.size();
+    tiles.emplace_back(tp, ts);
+    return tiles.size() - 1;
+  }
+
+  TexGrid TexAtlas::AddGrid(const v2 & tp, const v2 & tile_size, int nx, int ny, const std::string & name){
+    TexGrid grid;
+    if(nx <= 0 or ny <= 0 or grids.count(name)) return grid;
+    /// handles of the grid are consecutive, so tiles are appended even if the keys are known
+    grid.first = tiles.size();
+    grid.nx = nx;
+    grid.ny = ny;
+    for(int y = 0; y < ny; ++y){
+      for(int x = 0; x < nx; ++x){
+        std::string key = name.size() ? GenItemKey(name, x, y) : GenItemKey(x, y);
+        if(not names.count(key)) names[key] = tiles.size();
+        tiles.emplace_back(v2(tp.x + x * tile_size.x, tp.y + y * tile_size.y), tile_size);
+      }
+    }
+    grids[name] = grid;
+    return grid;
+  }
+
+  TexGrid TexAtlas::GetGrid(const std::string & name) const {
+    auto ptr = grids.find(name);
+    if(ptr == grids.end()) return TexGrid();
+    return ptr->second;
   }
 
   std::string TexAtlas::GenItemKey(int x, int y) const {
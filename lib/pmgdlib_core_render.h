@@ -7,17 +7,25 @@
 #include <memory>
 #include <stack>
 #include <unordered_map>
+#include <vector>
 
+#include "pmgdlib_defs.h"
 #include "pmgdlib_msg.h"
 #include "pmgdlib_math.h"
 
 namespace pmgd {
   //================================================ Base classes
+  struct ImageView;
   class Texture : public BaseMsg {
     /// base abstract texture class
     public:
     virtual void Bind()   = 0;
     virtual void Unbind() = 0;
+    //! replace texels of the region at x, y with the view
+    virtual int Upload(const ImageView & view, int x = 0, int y = 0){
+      msg_warning("function not implemented");
+      return PM_ERROR;
+    }
     virtual ~Texture() {};
   };
 
@@ -40,14 +48,39 @@ namespace pmgd {
     v2 tpos, tsize;
   };
 
+  struct TexGrid {
+    /// regular sheet of nx x ny tiles stored row by row in TexAtlas starting from handle first
+    int first = -1, nx = 0, ny = 0;
+    bool Valid() const { return first >= 0; }
+    int Handle(int x, int y) const { return first + y * nx + x; }
+  };
+
   class TexAtlas {
+    /// tiles are stored in a dense array, names & grids are resolved to integer handles once at load,
+    /// per frame lookups are array indexing via Tile(handle)
     private:
-      std::unordered_map<std::string, TexTile> atlas;
+      std::vector<TexTile> tiles;
+      std::unordered_map<std::string, int> names;
+      std::unordered_map<std::string, TexGrid> grids;
       v2 size;
 
     public:
-      TexTile * Get(const std::string & key);
-      void Add(const std::string & key, const v2 & tp, const v2 & ts);
+      //! handle of the tile or -1
+      int Handle(const std::string & key) const;
+      //! unchecked, pointers & references are valid until the next Add
+      TexTile & Tile(int handle){ return tiles[handle]; }
+      const TexTile & Tile(int handle) const { return tiles[handle]; }
+      TexTile * Get(int handle){ return handle >= 0 and handle < tiles.size() ? &tiles[handle] : nullptr; }
+      TexTile * Get(const std::string & key){ return Get(Handle(key)); }
+      int Size() const { return tiles.size(); }
+
+      //! handle of the new tile, or of the existing one with the same key which is not changed
+      int Add(const std::string & key, const v2 & tp, const v2 & ts);
+      //! nx x ny tiles of tile_size from tp, named GenItemKey(x, y) or GenItemKey(name, x, y) if name is given
+      TexGrid AddGrid(const v2 & tp, const v2 & tile_size, int nx, int ny, const std::string & name = "");
+      //! grid added with the name, invalid if missing
+      TexGrid GetGrid(const std::string & name = "") const;
+
       std::string GenItemKey(int x, int y) const;
       std::string GenItemKey(std::string name, int x, int y) const;
   };
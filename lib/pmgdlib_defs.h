@@ -25,6 +25,8 @@ namespace pmgd {
     enum  {
       UNDEFINED = -1,
       RGBA,
+      RGB,
+      BGRA,
     };
   };
 
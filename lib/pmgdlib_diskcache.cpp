@@ -0,0 +1,221 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+#include "pmgdlib_diskcache.h"
+
+namespace pmgd {
+  // ======= IoImageDiskCache ====================================================================
+  IoImageDiskCache::IoImageDiskCache(std::shared_ptr<IoImage> source_, const std::string & dir_, size_t max_bytes_, int mips_){
+    source = source_;
+    dir = dir_;
+    max_bytes = max_bytes_;
+    mips = mips_;
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if(ec) msg_warning("can't create image cache directory", quote(dir));
+    for(auto & it : std::filesystem::directory_iterator(dir, ec))
+      if(it.path().extension() == ".pmimg") used += it.file_size(ec);
+    msg_debug("image cache", quote(dir), "uses", used, "bytes");
+  }
+
+  bool IoImageDiskCache::MakeKey(const std::string & path, Key & key) const {
+    std::error_code ec;
+    if(not std::filesystem::is_regular_file(path, ec)) return false;
+    MappedFile file(path);
+    if(not file.Valid()) return false;
+
+    key.hash = hash_fnv1a(file.View());
+    key.size = file.Size();
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx_%llx_m%d.pmimg", (unsigned long long)key.hash, (unsigned long long)key.size, mips);
+    key.path = (std::filesystem::path(dir) / name).string();
+    return true;
+  }
+
+  std::string IoImageDiskCache::CachePath(const std::string & path) const {
+    Key key;
+    return MakeKey(path, key) ? key.path : "";
+  }
+
+  /// offsets of levels from the end of the header, the last one is the end of data
+  static std::vector<uint64_t> disk_image_offsets(const Image & img, uint32_t n_mips){
+    std::vector<uint64_t> answer = {0};
+    Image level(nullptr, img.w, img.h, img.format, img.type);
+    for(uint32_t i = 0; i <= n_mips; ++i){
+      answer.push_back(answer.back() + (level.Bytes() + 63) / 64 * 64);
+      level = Image(nullptr, std::max(1, level.w / 2), std::max(1, level.h / 2), img.format, img.type);
+    }
+    return answer;
+  }
+
+  std::shared_ptr<Image> IoImageDiskCache::Load(const Key & key){
+    std::error_code ec;
+    if(not std::filesystem::exists(key.path, ec)) return nullptr;
+
+    auto file = std::make_shared<const MappedFile>(key.path, true);
+    DiskImageHeader header;
+    if(not file->Valid() or file->Size() < sizeof(header)) return nullptr;
+    memcpy(&header, file->Data(), sizeof(header));
+
+    Image probe(nullptr, header.w, header.h, header.format, header.type);
+    bool ok = not memcmp(header.magic, DiskImageHeader().magic, sizeof(header.magic));
+    ok = ok and header.source_hash == key.hash and header.source_size == key.size;
+    ok = ok and header.format == image_format::RGBA and header.mip_filter == mips and header.n_mips < 32;
+    std::vector<uint64_t> offsets = ok ? disk_image_offsets(probe, header.n_mips) : std::vector<uint64_t>();
+    ok = ok and header.data_size == offsets.back();
+    ok = ok and file->Size() >= sizeof(header) + header.data_size;
+    if(not ok){
+      msg_warning("broken image cache file", quote(key.path), "remove");
+      std::lock_guard<std::mutex> lock(mutex);
+      std::filesystem::remove(key.path, ec);
+      if(not ec) used -= std::min<size_t>(used, file->Size());
+      return nullptr;
+    }
+
+    /// mtime is the last use for eviction
+    std::filesystem::last_write_time(key.path, std::filesystem::file_time_type::clock::now(), ec);
+
+    const char * data = file->Data() + sizeof(header);
+    auto answer = std::make_shared<Image>((void*)data, header.w, header.h, header.format, header.type);
+    answer->owner = file;
+    for(uint32_t i = 1; i <= header.n_mips; ++i){
+      const Image & above = i == 1 ? *answer : *answer->mips.back();
+      auto level = std::make_shared<Image>((void*)(data + offsets[i]), std::max(1, above.w / 2), std::max(1, above.h / 2), header.format, header.type);
+      level->owner = file;
+      answer->mips.push_back(level);
+    }
+    return answer;
+  }
+
+  void IoImageDiskCache::Store(const Key & key, std::shared_ptr<Image> img){
+    if(img == nullptr or img->data == nullptr or img->format != image_format::RGBA) return;
+    if(img->type != image_type::UNSIGNED_CHAR and img->type != image_type::FLOAT) return;
+    if(mips != mip_filter::NONE and img->mips.empty() and make_mips(img, mips) != PM_SUCCESS) return;
+
+    DiskImageHeader header;
+    header.w = img->w;
+    header.h = img->h;
+    header.format = img->format;
+    header.type = img->type;
+    header.source_hash = key.hash;
+    header.source_size = key.size;
+    header.n_mips = img->mips.size();
+    header.mip_filter = mips;
+    std::vector<uint64_t> offsets = disk_image_offsets(*img, header.n_mips);
+    header.data_size = offsets.back();
+
+    /// write aside and rename, so readers never see partial files
+    std::string tmp = key.path + ".tmp" + std::to_string(n_tmp++);
+    {
+      std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+      const char zeros[64] = {};
+      out.write((const char*)&header, sizeof(header));
+      for(uint32_t i = 0; i <= header.n_mips; ++i){
+        const Image & level = i ? *img->mips[i - 1] : *img;
+        out.write((const char*)level.data, level.Bytes());
+        out.write(zeros, offsets[i + 1] - offsets[i] - level.Bytes());
+      }
+      if(not out){
+        msg_warning("can't write image cache file", quote(tmp));
+        out.close();
+        std::error_code ec;
+        std::filesystem::remove(tmp, ec);
+        return;
+      }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, key.path, ec);
+    if(ec){
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+    /// same clock as in Load(), file system timestamps are coarse
+    std::filesystem::last_write_time(key.path, std::filesystem::file_time_type::clock::now(), ec);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      used += sizeof(header) + header.data_size;
+    }
+    if(max_bytes and used > max_bytes) Evict();
+  }
+
+  std::shared_ptr<Image> IoImageDiskCache::Read(const std::string & path){
+    Key key;
+    if(not MakeKey(path, key)) return source->Read(path);
+
+    std::shared_ptr<Image> answer = Load(key);
+    if(answer){
+      n_hits++;
+      return answer;
+    }
+
+    n_misses++;
+    answer = source->Read(path);
+    Store(key, answer);
+    return answer;
+  }
+
+  int IoImageDiskCache::ReadBatch(const std::vector<std::string> & paths, const std::function<void(int, std::shared_ptr<Image>)> & done, size_t max_bytes_){
+    int answer = 0;
+    std::vector<int> misses;
+    std::vector<std::string> miss_paths;
+    std::vector<Key> miss_keys;
+    for(int i = 0; i < paths.size(); ++i){
+      Key key;
+      bool cached = MakeKey(paths[i], key);
+      std::shared_ptr<Image> img = cached ? Load(key) : nullptr;
+      if(img == nullptr){
+        misses.push_back(i);
+        miss_paths.push_back(paths[i]);
+        miss_keys.push_back(cached ? key : Key());
+        continue;
+      }
+      n_hits++;
+      answer++;
+      done(i, img);
+    }
+
+    n_misses += misses.size();
+    answer += source->ReadBatch(miss_paths, [&](int j, std::shared_ptr<Image> img){
+      if(miss_keys[j].path.size()) Store(miss_keys[j], img);
+      done(misses[j], img);
+    }, max_bytes_);
+    return answer;
+  }
+
+  int IoImageDiskCache::Evict(){
+    std::lock_guard<std::mutex> lock(mutex);
+    struct File {
+      std::filesystem::file_time_type mtime;
+      size_t size;
+      std::filesystem::path path;
+    };
+    std::vector<File> files;
+    std::error_code ec;
+    used = 0;
+    for(auto & it : std::filesystem::directory_iterator(dir, ec)){
+      if(it.path().extension() != ".pmimg") continue;
+      File file{it.last_write_time(ec), size_t(it.file_size(ec)), it.path()};
+      used += file.size;
+      files.push_back(file);
+    }
+    if(not max_bytes or used <= max_bytes) return 0;
+
+    std::sort(files.begin(), files.end(), [](const File & a, const File & b){ return a.mtime < b.mtime; });
+    int answer = 0;
+    for(auto & file : files){
+      if(used <= max_bytes) break;
+      if(not std::filesystem::remove(file.path, ec)) continue;
+      used -= file.size;
+      answer++;
+    }
+    msg_debug("image cache evicted", answer, "files,", used, "bytes left");
+    return answer;
+  }
+};
@@ -0,0 +1,78 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_DISKCACHE_HH
+#define PMGDLIB_DISKCACHE_HH 1
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_core.h"
+#include "pmgdlib_io.h"
+#include "pmgdlib_image.h"
+#include "pmgdlib_mip.h"
+
+namespace pmgd {
+  // ======= IoImageDiskCache ====================================================================
+  //! cache file: header + raw pixels, 64 bytes header keeps pixels aligned in the mapping
+  struct DiskImageHeader {
+    char magic[8] = {'P', 'M', 'G', 'D', 'I', 'M', 'G', '1'};
+    uint32_t w = 0, h = 0;
+    int32_t format = image_format::UNDEFINED;
+    int32_t type = image_type::UNDEFINED;
+    uint64_t source_hash = 0;
+    uint64_t source_size = 0;
+    uint64_t data_size = 0; /// all levels, every level starts at 64 bytes boundary
+    uint32_t n_mips = 0;    /// levels after the first one
+    int32_t mip_filter = mip_filter::NONE;
+    char reserved[8] = {};
+  };
+  static_assert(sizeof(DiskImageHeader) == 64);
+
+  //! decoded images stored on disk by hash of the source file content,
+  //! cached images are mapped copy-on-write and go to MakeTexture without decoding,
+  //! least recently used files are removed when the cache is over max_bytes,
+  //! only RGBA images are cached, other images & paths which are not files are read from source every time,
+  //! with mips filter the mip chain is made once before storing and comes mapped with the image
+  class IoImageDiskCache : public IoImage {
+    std::shared_ptr<IoImage> source;
+    std::string dir;
+    size_t max_bytes = 0;
+    int mips = mip_filter::NONE;
+    std::mutex mutex;
+    size_t used = 0;
+    std::atomic<int> n_hits = 0, n_misses = 0, n_tmp = 0;
+
+    struct Key {
+      uint64_t hash = 0, size = 0;
+      std::string path;
+    };
+    bool MakeKey(const std::string & path, Key & key) const;
+    std::shared_ptr<Image> Load(const Key & key);
+    void Store(const Key & key, std::shared_ptr<Image> img);
+
+    public:
+    //! max_bytes = 0 - no limit
+    IoImageDiskCache(std::shared_ptr<IoImage> source_, const std::string & dir_, size_t max_bytes_ = size_t(1) << 30, int mips_ = mip_filter::NONE);
+
+    virtual std::shared_ptr<Image> Read(const std::string & path);
+    virtual int Write(const std::string & path, std::shared_ptr<Image> image){ return source->Write(path, image); }
+    //! hits are loaded on the calling thread, misses are decoded by source->ReadBatch()
+    virtual int ReadBatch(const std::vector<std::string> & paths, const std::function<void(int, std::shared_ptr<Image>)> & done, size_t max_bytes = 256 << 20);
+
+    //! cache file for the source file, empty if the source can't be read
+    std::string CachePath(const std::string & path) const;
+
+    //! remove least recently used files until under max_bytes, return number of removed files
+    int Evict();
+
+    size_t Used() const { return used; }
+    int Hits() const { return n_hits; }
+    int Misses() const { return n_misses; }
+  };
+};
+
+#endif
@@ -1,10 +1,402 @@
 // P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
 
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
 #include "pmgdlib_factory.h"
 #include "pmgdlib_defs.h"
+#include "pmgdlib_thread.h"
 
 namespace pmgd {
 
+  // ======= ProtoBuilder ====================================================================
+  ProtoBuilder::ProtoBuilder(std::shared_ptr<Backend> back_, std::shared_ptr<NdMap<ProtoObject>> ndmap_){
+    back = back_;
+    ndmap = ndmap_;
+
+    processors["texture"].prepare = [this](const ConfigItem* c) {return std::static_pointer_cast<void>(this->PrepareTexture(c));};
+    processors["texture"].make = [this](const ConfigItem* c, std::shared_ptr<void> data) {
+      return std::static_pointer_cast<void>(this->BuildTexture(c, std::static_pointer_cast<PreparedTexture>(data)));};
+    processors["texture"].size = [](const ConfigItem* c, std::shared_ptr<void> data) {
+      auto prepared = std::static_pointer_cast<PreparedTexture>(data);
+      return prepared and prepared->img ? prepared->img->Bytes() : size_t(0);};
+    processors["shader"].prepare = [this](const ConfigItem* c) {return std::static_pointer_cast<void>(this->PrepareShader(c));};
+    processors["shader"].make = [this](const ConfigItem* c, std::shared_ptr<void> data) {
+      return std::static_pointer_cast<void>(this->BuildShader(c, std::static_pointer_cast<PreparedShader>(data)));};
+    processors["shader"].size = [](const ConfigItem* c, std::shared_ptr<void> data) {
+      auto prepared = std::static_pointer_cast<PreparedShader>(data);
+      if(not prepared) return size_t(0);
+      return (prepared->vert ? prepared->vert->size() : 0) + (prepared->frag ? prepared->frag->size() : 0);};
+    processors["drawer"].make = [this](const ConfigItem* c, std::shared_ptr<void>) {return std::static_pointer_cast<void>(this->BuildSimpleDrawer(c));};
+    processors["scene"].make = [this](const ConfigItem* c, std::shared_ptr<void>) {return std::static_pointer_cast<void>(this->BuildScene(c));};
+    processors["pipeline"].make = [this](const ConfigItem* c, std::shared_ptr<void>) {return std::static_pointer_cast<void>(this->BuildPipeline(c));};
+  }
+
+  ProtoBuilder::~ProtoBuilder(){
+    std::unique_lock<std::mutex> lock(tasks->mutex);
+    tasks->closed = true;
+    tasks->cv.wait(lock, [this](){ return tasks->n_running == 0; });
+  }
+
+  std::shared_ptr<Image> ProtoBuilder::LoadImage(const std::string & path){
+    return resources->GetOrLoad<Image>(ResourceCache::Key("image", path), [&]() -> std::shared_ptr<Image> {
+      std::shared_ptr<Image> img = back->ReadImage(path);
+      if(img == nullptr or img->data == nullptr) return nullptr;
+      return img;
+    });
+  }
+
+  std::shared_ptr<std::string> ProtoBuilder::LoadTxt(const std::string & path){
+    return resources->GetOrLoad<std::string>(ResourceCache::Key("txt", path), [&](){
+      return std::make_shared<std::string>(back->ReadTxt(path));
+    });
+  }
+
+  std::shared_ptr<ProtoBuilder::PreparedTexture> ProtoBuilder::PrepareTexture(const ConfigItem* cfg){
+    std::string path = cfg->Attribute("image_path", cfg->Attribute("path"));
+    if(not path.size()){
+      msg_warning("texture", quote(cfg->Attribute("id")), "has no image_path");
+      return nullptr;
+    }
+
+    auto answer = std::make_shared<PreparedTexture>();
+    answer->path = path;
+    answer->key = ResourceCache::Key("texture", path);
+    if(resources->Get(answer->key)) return answer; /// already uploaded, the make stage takes it from the cache
+
+    answer->img = LoadImage(path);
+    if(answer->img == nullptr){
+      msg_warning("texture", quote(cfg->Attribute("id")), "failed to read image", quote(path));
+      return nullptr;
+    }
+    return answer;
+  }
+
+  std::shared_ptr<Texture> ProtoBuilder::BuildTexture(const ConfigItem* cfg, std::shared_ptr<PreparedTexture> data){
+    if(data == nullptr) return nullptr;
+    return resources->GetOrLoad<Texture>(data->key, [&]() -> std::shared_ptr<Texture> {
+      /// texture was released between the stages
+      std::shared_ptr<Image> img = data->img ? data->img : LoadImage(data->path);
+      if(img == nullptr) return nullptr;
+      return back->MakeTexture(img);
+    });
+  }
+
+  std::shared_ptr<ProtoBuilder::PreparedShader> ProtoBuilder::PrepareShader(const ConfigItem* cfg){
+    auto answer = std::make_shared<PreparedShader>();
+    answer->vert_path = cfg->Attribute("vert");
+    answer->frag_path = cfg->Attribute("frag");
+    answer->key = "shader:" + ResourceCache::Key("vert", answer->vert_path) + "|" + ResourceCache::Key("frag", answer->frag_path);
+    if(resources->Get(answer->key)) return answer;
+
+    answer->vert = LoadTxt(answer->vert_path);
+    answer->frag = LoadTxt(answer->frag_path);
+    return answer;
+  }
+
+  std::shared_ptr<Shader> ProtoBuilder::BuildShader(const ConfigItem* cfg, std::shared_ptr<PreparedShader> data){
+    return resources->GetOrLoad<Shader>(data->key, [&](){
+      std::shared_ptr<std::string> vert = data->vert ? data->vert : LoadTxt(data->vert_path);
+      std::shared_ptr<std::string> frag = data->frag ? data->frag : LoadTxt(data->frag_path);
+      return back->MakeShader(*vert, *frag);
+    });
+  }
+
+  std::shared_ptr<Scene> ProtoBuilder::BuildScene(const ConfigItem* cfg){
+    std::string id = cfg->Attribute("id");
+    return back->MakeScene(id);
+  }
+
+  std::shared_ptr<SimpleDrawer> ProtoBuilder::BuildSimpleDrawer(const ConfigItem* cfg){
+    auto texture = GetDependence<Texture>(cfg, "texture");
+    return back->MakeSimpleDrawer();
+  }
+
+  std::shared_ptr<ScenePipeline> ProtoBuilder::BuildPipeline(const ConfigItem* cfg){
+    std::shared_ptr<ScenePipeline> obj = back->MakeScenePipeline();
+    for(auto chain : cfg->GetAttrsFromNested("chain", "data")) obj->AddChain(chain);
+    return obj;
+  }
+
+  int ProtoBuilder::BuildObject(std::shared_ptr<ProtoObject> po){
+    //! do not reload object if warm
+    if(po->IsWarm()) return PM_SUCCESS;
+
+    //! get config from proto object and build
+    const ConfigItem* cfg = po->cfg_item;
+    auto find = processors.find(cfg->type);
+    if(find == processors.end()) return PM_ERROR;
+
+    std::shared_ptr<void> data = find->second.prepare ? find->second.prepare(cfg) : nullptr;
+    MakeObject(po, find->second, data);
+    return PM_SUCCESS;
+  }
+
+  void ProtoBuilder::MakeObject(std::shared_ptr<ProtoObject> po, const Processor & processor, std::shared_ptr<void> data){
+    msg_info("start build", po->cfg_item->type);
+    po->object = processor.make(po->cfg_item, data);
+    po->bytes = processor.size ? processor.size(po->cfg_item, data) : 0;
+    if(on_built and po->object != nullptr) on_built(po);
+  }
+
+  std::vector<std::shared_ptr<ProtoObject>> ProtoBuilder::Dependencies(std::shared_ptr<ProtoObject> po){
+    std::vector<std::shared_ptr<ProtoObject>> answer;
+    for(auto & attr : po->cfg_item->attributes){
+      if(not attr.second.size() or processors.find(attr.first) == processors.end()) continue;
+      std::shared_ptr<ProtoObject> dep = ndmap->GetOne(namespaces, NdKey(attr.first, attr.second));
+      if(dep != nullptr and dep != po) answer.push_back(dep);
+    }
+    return answer;
+  }
+
+  int ProtoBuilder::BuildObjects(std::vector<NdKey> namespaces_, std::vector<std::shared_ptr<ProtoObject>> objects){
+    msg_debug("build start ...");
+    std::shared_ptr<ProtoBuildJob> job = StartBuild(namespaces_, objects);
+    job->Step();
+    msg_debug("build done ...");
+    return job->Result();
+  }
+
+  std::shared_ptr<ProtoBuildJob> ProtoBuilder::StartBuild(std::vector<NdKey> namespaces_, std::vector<std::shared_ptr<ProtoObject>> objects){
+    namespaces = namespaces_;
+    auto job = std::make_shared<ProtoBuildJob>();
+    job->builder = this;
+    job->verbose_lvl = verbose_lvl;
+    std::vector<ProtoBuildJob::Node> & nodes = job->nodes;
+
+    //! dependency graph of cold objects
+    std::unordered_map<ProtoObject*, int> index;
+    std::function<int(std::shared_ptr<ProtoObject>)> add_node = [&](std::shared_ptr<ProtoObject> po){
+      auto it = index.find(po.get());
+      if(it != index.end()) return it->second;
+      int i = nodes.size();
+      index[po.get()] = i;
+      nodes.emplace_back();
+      nodes[i].po = po;
+      auto find = processors.find(po->cfg_item->type);
+      if(find != processors.end()) nodes[i].processor = &(find->second);
+
+      for(auto dep : Dependencies(po)){
+        if(dep->IsWarm()) continue;
+        int j = add_node(dep);
+        nodes[j].dependents.push_back(i);
+        nodes[i].n_deps++;
+      }
+      return i;
+    };
+    for(auto po : objects) if(not po->IsWarm()) add_node(po);
+
+    //! prepare stage on workers, finished nodes are reported to the owner thread via queue
+    job->shared->data.resize(nodes.size());
+    for(int i = 0; i < nodes.size(); ++i){
+      ProtoBuildJob::Node & node = nodes[i];
+      const Processor * processor = node.processor;
+      if(processor == nullptr or processor->prepare == nullptr or not parallel){
+        if(processor and processor->prepare) job->shared->data[i] = processor->prepare(node.po->cfg_item);
+        node.prepared = true;
+        job->n_prepared++;
+        if(node.n_deps == 0) job->ready.push_back(i);
+        continue;
+      }
+
+      job->n_pending++;
+      std::shared_ptr<ProtoBuildJob::Shared> shared = job->shared;
+      const ConfigItem * cfg = node.po->cfg_item;
+      Processor::Preparer prepare = processor->prepare;
+      thread_pool().Submit([shared, tasks = tasks, i, cfg, prepare](){
+        {
+          std::lock_guard<std::mutex> lock(tasks->mutex);
+          if(tasks->closed) return;
+          tasks->n_running++;
+        }
+        std::shared_ptr<void> data = prepare(cfg);
+        {
+          std::lock_guard<std::mutex> lock(shared->mutex);
+          shared->data[i] = data;
+          shared->prepared_queue.push_back(i);
+          shared->cv.notify_one();
+        }
+        std::lock_guard<std::mutex> lock(tasks->mutex);
+        if(--tasks->n_running == 0) tasks->cv.notify_all();
+      });
+    }
+
+    if(not nodes.size()) job->finished = true;
+    return job;
+  }
+
+  // ======= ProtoBuildJob ====================================================================
+  void ProtoBuildJob::Collect(bool wait){
+    std::vector<int> prepared;
+    {
+      std::unique_lock<std::mutex> lock(shared->mutex);
+      if(wait) shared->cv.wait(lock, [this]{ return shared->prepared_queue.size(); });
+      prepared.swap(shared->prepared_queue);
+    }
+    n_pending -= prepared.size();
+    n_prepared += prepared.size();
+    for(int i : prepared){
+      nodes[i].prepared = true;
+      if(nodes[i].n_deps == 0) ready.push_back(i);
+    }
+  }
+
+  void ProtoBuildJob::Finish(){
+    finished = true;
+    if(n_made == nodes.size()) return;
+    msg_warning("cyclic dependencies,", nodes.size() - n_made, "objects are not built:");
+    for(auto & node : nodes) if(node.n_deps) msg_warning(quote(node.po->cfg_item->type), quote(node.po->cfg_item->Attribute("id")));
+    ret = PM_ERROR;
+  }
+
+  bool ProtoBuildJob::BuildUntil(std::shared_ptr<ProtoObject> po){
+    for(int i = 0; i < nodes.size(); ++i){
+      if(nodes[i].po != po) continue;
+      if(not nodes[i].made) Run(-1, i);
+      return po->IsWarm();
+    }
+    return false;
+  }
+
+  bool ProtoBuildJob::Run(double max_ms, int target){
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&start](){ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+
+    while(not finished){
+      Collect(false);
+
+      //! make stage as soon as node is prepared and its dependencies are made
+      while(ready.size()){
+        int i = ready.back();
+        ready.pop_back();
+        Node & node = nodes[i];
+        node.made = true;
+        n_made++;
+
+        if(node.processor == nullptr) ret = PM_ERROR;
+        else builder->MakeObject(node.po, *node.processor, shared->data[i]);
+        shared->data[i] = nullptr;
+
+        for(int j : node.dependents)
+          if(--nodes[j].n_deps == 0 and nodes[j].prepared) ready.push_back(j);
+        if(i == target) break;
+        if(max_ms >= 0 and elapsed() >= max_ms) break;
+      }
+
+      if(n_made == nodes.size() or (n_pending == 0 and not ready.size())){
+        Finish();
+        break;
+      }
+      if(max_ms >= 0 or (target >= 0 and nodes[target].made)) break;
+      if(not ready.size()) Collect(true);
+    }
+    return finished;
+  }
+
+  std::vector<std::shared_ptr<ProtoObject>> ProtoBuildJob::Objects() const {
+    std::vector<std::shared_ptr<ProtoObject>> answer;
+    for(auto & node : nodes) answer.push_back(node.po);
+    return answer;
+  }
+
+  // ======= ProtoCache ====================================================================
+  ProtoCache::ProtoCache(std::shared_ptr<ProtoBuilder> builder_, std::vector<NdKey> namespaces_){
+    builder = builder_;
+    namespaces = namespaces_;
+    builder->SetNamespaces(namespaces);
+    builder->on_built = [this](std::shared_ptr<ProtoObject> po){ this->Track(po); };
+  }
+
+  void ProtoCache::Track(std::shared_ptr<ProtoObject> po){
+    auto find = entries.find(po.get());
+    if(find != entries.end()){
+      used -= find->second.bytes;
+      lru.erase(find->second.it);
+    }
+
+    lru.push_front(po);
+    Entry & entry = entries[po.get()];
+    entry.it = lru.begin();
+    entry.bytes = po->bytes;
+    used += po->bytes;
+    po->last_use = ++tick;
+  }
+
+  void ProtoCache::Touch(std::shared_ptr<ProtoObject> po){
+    po->last_use = ++tick;
+    auto find = entries.find(po.get());
+    if(find == entries.end()) return;
+    lru.splice(lru.begin(), lru, find->second.it);
+  }
+
+  std::shared_ptr<void> ProtoCache::Get(std::shared_ptr<ProtoObject> po){
+    if(po == nullptr) return nullptr;
+    if(not po->IsWarm()){
+      /// do not build twice the object prepared by a background job, built objects are tracked via on_built
+      auto find = building.find(po.get());
+      if(find != building.end()){
+        std::shared_ptr<ProtoBuildJob> job = find->second.lock();
+        building.erase(find);
+        if(job and not job->Done()) job->BuildUntil(po);
+      }
+      if(not po->IsWarm()) builder->BuildObjects(namespaces, {po});
+      Evict();
+    }
+    else Touch(po);
+    return po->object;
+  }
+
+  std::shared_ptr<ProtoBuildJob> ProtoCache::StartWarmUp(const std::vector<std::shared_ptr<ProtoObject>> & objects){
+    for(auto it = building.begin(); it != building.end(); ){
+      std::shared_ptr<ProtoBuildJob> job = it->second.lock();
+      if(job == nullptr or job->Done()) it = building.erase(it);
+      else ++it;
+    }
+
+    std::shared_ptr<ProtoBuildJob> job = builder->StartBuild(namespaces, objects);
+    for(auto po : job->Objects()) building[po.get()] = job;
+    return job;
+  }
+
+  int ProtoCache::WarmUp(const std::vector<std::shared_ptr<ProtoObject>> & objects){
+    int ret = builder->BuildObjects(namespaces, objects);
+    for(auto po : objects) if(po->IsWarm()) Touch(po);
+    Evict();
+    return ret;
+  }
+
+  void ProtoCache::CoolDown(std::shared_ptr<ProtoObject> po){
+    auto find = entries.find(po.get());
+    if(find != entries.end()){
+      used -= find->second.bytes;
+      lru.erase(find->second.it);
+      entries.erase(find);
+    }
+    po->Cool();
+  }
+
+  int ProtoCache::Evict(){
+    if(budget == 0 or used <= budget or lru.empty()) return 0;
+
+    /// the most recently used object is kept even if it does not fit the budget alone
+    int n_cooled = 0;
+    for(auto it = std::prev(lru.end()); used > budget and it != lru.begin(); ){
+      std::shared_ptr<ProtoObject> po = *it;
+      auto next = std::prev(it);
+      if(not po->pins){
+        msg_debug("cool", quotec(po->cfg_item->type), quote(po->cfg_item->Attribute("id")), po->bytes, "bytes");
+        CoolDown(po);
+        n_cooled++;
+      }
+      it = next;
+    }
+
+    if(used > budget) msg_warning("warm objects use", used, "bytes over budget", budget, "bytes");
+    return n_cooled;
+  }
+
   // ======= factory ====================================================================
 
   // ======= functions to use outside ====================================================================
@@ -22,6 +414,12 @@ namespace pmgd {
     }
     #endif
 
+    if(options.accelerator == "SOFT"){
+      msg_debug("setup software accelerator backend ...");
+      back->accel_imp = std::make_shared<AccelFactorySoft>();
+      msg_debug("setup software accelerator backend ... ok");
+    }
+
     if(options.io == "SDL"){
       #ifdef USE_SDL
         msg_debug("setup SDL IO backend ...");
@@ -32,6 +430,29 @@ namespace pmgd {
       #endif
     }
 
+    if(options.io == "MMAP"){
+      msg_debug("setup mmap IO backend ...");
+      back->txt_imp = std::make_shared<IoTxtMmap>();
+      msg_debug("setup mmap IO backend ... ok");
+    }
+
+    std::shared_ptr<PackArchive> pack = nullptr;
+    if(options.io == "PACK" or options.img == "PACK"){
+      msg_debug("open pack", quote(options.pack), "...");
+      pack = std::make_shared<PackArchive>(options.pack);
+      if(not pack->Valid()){
+        msg_warning("can't open pack", quote(options.pack), "use files");
+        pack = nullptr;
+      }
+    }
+
+    if(options.io == "PACK"){
+      msg_debug("setup pack IO backend ...");
+      if(pack) back->txt_imp = std::make_shared<IoTxtPack>(pack, std::make_shared<IoTxtMmap>());
+      else back->txt_imp = std::make_shared<IoTxtMmap>();
+      msg_debug("setup pack IO backend ... ok");
+    }
+
     if(options.multimedia_library == "SDL"){
       #ifdef USE_SDL
         msg_debug("setup SDL multimedia backend ...");
@@ -48,8 +469,25 @@ namespace pmgd {
       back->img_imp = std::make_shared<IoImageStb>();
       msg_debug("setup STB image IO backend ... ok");
     }
+
+    if(options.img == "PACK"){
+      msg_debug("setup pack image IO backend ...");
+      if(pack) back->img_imp = std::make_shared<IoImagePack>(pack, std::make_shared<IoImageStb>());
+      else back->img_imp = std::make_shared<IoImageStb>();
+      msg_debug("setup pack image IO backend ... ok");
+    }
+    #else
+    if(options.img == "PACK") msg_warning("to decode pack images recompile sources with -DUSE_STB");
     #endif
 
+    if(options.img_cache.size()){
+      msg_debug("setup image disk cache", quote(options.img_cache), "...");
+      int mips = mip_filter_from_string(options.img_mips);
+      if(options.img_mips.size() and mips == mip_filter::NONE) msg_warning("unknown mip filter", quote(options.img_mips));
+      back->img_imp = std::make_shared<IoImageDiskCache>(back->img_imp, options.img_cache, size_t(options.img_cache_size) << 20, mips);
+      msg_debug("setup image disk cache ... ok");
+    }
+
     msg_debug("Factory backend ok ...");
     return back;
   };
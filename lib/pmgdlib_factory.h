@@ -2,11 +2,21 @@
 #ifndef PMGDLIB_FACTORY_HH
 #define PMGDLIB_FACTORY_HH 1
 
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+
 #include "pmgdlib_string.h"
 #include "pmgdlib_core.h"
 #include "pmgdlib_core_render.h"
 #include "pmgdlib_config.h"
 #include "pmgdlib_image.h"
+#include "pmgdlib_resources.h"
+#include "pmgdlib_io.h"
+#include "pmgdlib_pack.h"
+#include "pmgdlib_diskcache.h"
+#include "pmgdlib_soft.h"
 
 #ifdef USE_SDL
   #include "pmgdlib_sdl.h"
@@ -109,35 +119,118 @@ namespace pmgd {
     }
   };
 
-  //! Create objects from ProtoObjects and put into DataContainer
-  class ProtoBuilder : public BaseMsg {
-    std::shared_ptr<Backend> back;
-    std::shared_ptr<NdMap<ProtoObject>> ndmap = nullptr;
-    std::vector<NdKey> namespaces;
-    std::map<std::string, std::function<std::shared_ptr<void>(const ConfigItem*)>> processors;
+  class ProtoBuilder;
 
-    int BuildTexture(std::shared_ptr<ProtoObject> po){
-      const ConfigItem * cfg = po->cfg_item;
+  //! stages of building object of one type, see ProtoBuilder
+  struct ProtoProcessor {
+    using Preparer = std::function<std::shared_ptr<void>(const ConfigItem*)>;
+    using Maker = std::function<std::shared_ptr<void>(const ConfigItem*, std::shared_ptr<void>)>;
+    using Sizer = std::function<size_t(const ConfigItem*, std::shared_ptr<void>)>;
 
-      return PM_SUCCESS;
-    }
+    Preparer prepare = nullptr;
+    Maker make = nullptr;
+    Sizer size = nullptr; /// approximate object size from prepared data
+  };
 
-    auto BuildShader(const ConfigItem* cfg){
-      std::string vert_path = cfg->Attribute("vert");
-      std::string frag_path = cfg->Attribute("frag");
+  //! objects of one ProtoBuilder::StartBuild() call, prepare stage is started on workers on creation,
+  //! make stage is done by Step() on the owner thread, so building can be spread over frames
+  class ProtoBuildJob : public BaseMsg {
+    friend class ProtoBuilder;
+
+    struct Node {
+      std::shared_ptr<ProtoObject> po;
+      const ProtoProcessor * processor = nullptr;
+      std::vector<int> dependents;
+      int n_deps = 0;
+      bool prepared = false;
+      bool made = false;
+    };
+
+    /// shared with worker tasks, so abandoned job is safe to destroy
+    struct Shared {
+      std::mutex mutex;
+      std::condition_variable cv;
+      std::vector<int> prepared_queue;
+      std::vector<std::shared_ptr<void>> data;
+    };
+
+    ProtoBuilder * builder = nullptr;
+    std::vector<Node> nodes;
+    std::shared_ptr<Shared> shared = std::make_shared<Shared>();
+    std::vector<int> ready;
+    int n_pending = 0, n_prepared = 0, n_made = 0;
+    int ret = PM_SUCCESS;
+    bool finished = false;
+
+    void Collect(bool wait);
+    void Finish();
+    bool Run(double max_ms, int target);
 
-      std::string vert_txt = back->ReadTxt(vert_path);
-      std::string frag_txt = back->ReadTxt(frag_path);
+    public:
+    //! make ready objects during max_ms milliseconds without waiting for workers,
+    //! max_ms < 0 - wait and make until all objects are built, return Done()
+    bool Step(double max_ms = -1){ return Run(max_ms, -1); }
 
-      std::shared_ptr<Shader> obj = back->MakeShader(vert_txt, frag_txt);
-      return obj;
-    }
+    //! make objects until po is built, waiting for workers if needed, other objects are left to Step(),
+    //! return false if po is not in the job or can't be built
+    bool BuildUntil(std::shared_ptr<ProtoObject> po);
 
-    auto BuildScene(const ConfigItem* cfg){
-      std::string id = cfg->Attribute("id");
-      std::shared_ptr<Scene> obj = back->MakeScene(id);
-      return obj;
-    }
+    bool Done() const { return finished; }
+    int Size() const { return nodes.size(); }
+    int Made() const { return n_made; }
+
+    //! prepare and make stages are counted with equal weights
+    float Progress() const { return nodes.size() ? (n_prepared + n_made) / (2.f * nodes.size()) : 1.f; }
+
+    //! PM_SUCCESS or PM_ERROR for unknown types & dependency cycles
+    int Result() const { return ret; }
+
+    //! all objects of the job including cold dependencies
+    std::vector<std::shared_ptr<ProtoObject>> Objects() const;
+  };
+
+  //! Create objects from ProtoObjects and put into DataContainer,
+  //! every object type is built in two stages:
+  //!   prepare - read & decode data, e.g. image for texture, runs on worker threads
+  //!   make    - accelerator-bound part, e.g. MakeTexture, runs on the thread called BuildObjects (owner of the context)
+  //! dependencies are attributes named after built types, e.g. texture="t1", they are made before dependent objects
+  class ProtoBuilder : public BaseMsg {
+    friend class ProtoBuildJob;
+    using Processor = ProtoProcessor;
+    std::shared_ptr<Backend> back;
+    std::shared_ptr<NdMap<ProtoObject>> ndmap = nullptr;
+    std::vector<NdKey> namespaces;
+    std::map<std::string, Processor> processors;
+
+    //! prepare tasks on the pool check it before using the builder, so the builder can be destroyed with jobs in flight:
+    //! the destructor closes it and waits only for the tasks which are already running
+    struct Tasks {
+      std::mutex mutex;
+      std::condition_variable cv;
+      int n_running = 0;
+      bool closed = false;
+    };
+    std::shared_ptr<Tasks> tasks = std::make_shared<Tasks>();
+
+    //! prepared data carries the resource key, sources are not loaded if the resource is already alive
+    struct PreparedTexture {
+      std::string key, path;
+      std::shared_ptr<Image> img;
+    };
+    struct PreparedShader {
+      std::string key, vert_path, frag_path;
+      std::shared_ptr<std::string> vert, frag;
+    };
+
+    std::shared_ptr<Image> LoadImage(const std::string & path);
+    std::shared_ptr<std::string> LoadTxt(const std::string & path);
+    std::shared_ptr<PreparedTexture> PrepareTexture(const ConfigItem* cfg);
+    std::shared_ptr<Texture> BuildTexture(const ConfigItem* cfg, std::shared_ptr<PreparedTexture> data);
+    std::shared_ptr<PreparedShader> PrepareShader(const ConfigItem* cfg);
+    std::shared_ptr<Shader> BuildShader(const ConfigItem* cfg, std::shared_ptr<PreparedShader> data);
+    std::shared_ptr<Scene> BuildScene(const ConfigItem* cfg);
+    std::shared_ptr<SimpleDrawer> BuildSimpleDrawer(const ConfigItem* cfg);
+    std::shared_ptr<ScenePipeline> BuildPipeline(const ConfigItem* cfg);
 
     template<typename T>
     std::shared_ptr<T> GetDependence(const ConfigItem* cfg, std::string id_key, std::string type = ""){
@@ -151,62 +244,86 @@ namespace pmgd {
       return std::static_pointer_cast<T>(po->object);
     }
 
-    auto BuildSimpleDrawer(const ConfigItem* cfg){
-      std::string texture_id = cfg->Attribute("texture");
+    //! build one object with both stages on the calling thread
+    int BuildObject(std::shared_ptr<ProtoObject> po);
 
-      auto texture = GetDependence<Texture>(cfg, "texture");
+    //! make stage, also sets object size and calls on_built
+    void MakeObject(std::shared_ptr<ProtoObject> po, const Processor & processor, std::shared_ptr<void> data);
 
-      std::shared_ptr<SimpleDrawer> obj = back->MakeSimpleDrawer();
-      return obj;
-    }
+    public:
+    //! run prepare stage on thread_pool(), set false to build everything on the calling thread
+    bool parallel = true;
 
-    auto BuildPipeline(const ConfigItem* cfg){
-      std::vector<std::string> chains = cfg->GetAttrsFromNested("chain", "data");
-      // std::shared_ptr<Pipeline> obj = back->MakePipeline();
-    }
+    //! images, shader sources, textures & shaders shared by all objects with the same source files,
+    //! can be shared between builders
+    std::shared_ptr<ResourceCache> resources = std::make_shared<ResourceCache>();
 
-    int BuildObject(std::shared_ptr<ProtoObject> po){
-      //! do not reload object if warm
-      if(po->IsWarm()){
-        return PM_SUCCESS;
-      }
+    //! called on the owner thread for every built object, including dependencies
+    std::function<void(std::shared_ptr<ProtoObject>)> on_built = nullptr;
 
-      //! get config from proto object and build
-      const ConfigItem* cfg = po->cfg_item;
-      std::string type = cfg->type;
+    //! prefixes to look for dependencies, also set by BuildObjects() & StartBuild()
+    void SetNamespaces(const std::vector<NdKey> & namespaces_){ namespaces = namespaces_; }
 
-      auto find = processors.find(type);
-      if(find == processors.end()){
-        return PM_ERROR;
-      }
+    //! proto objects referred by po attributes
+    std::vector<std::shared_ptr<ProtoObject>> Dependencies(std::shared_ptr<ProtoObject> po);
 
-      msg_info("start build", type);
-      po->object = std::static_pointer_cast<void>(find->second(cfg));
-      return PM_SUCCESS;
-    }
+    //! build cold objects with their cold dependencies
+    int BuildObjects(std::vector<NdKey> namespaces_, std::vector<std::shared_ptr<ProtoObject>> objects);
+
+    //! same but returns after prepare stage is started, Step() of the job needs the builder,
+    //! prepare tasks not started before the builder is destroyed are dropped
+    std::shared_ptr<ProtoBuildJob> StartBuild(std::vector<NdKey> namespaces_, std::vector<std::shared_ptr<ProtoObject>> objects);
+
+    ProtoBuilder(std::shared_ptr<Backend> back_, std::shared_ptr<NdMap<ProtoObject>> ndmap_);
+    ~ProtoBuilder();
+  };
+
+  //! warm objects are tracked by last use & approximate size, when the total size exceeds the budget
+  //! the least recently used objects are cooled, cooled objects are built again from cfg_item on the next Get()
+  class ProtoCache : public BaseMsg {
+    struct Entry {
+      std::list<std::shared_ptr<ProtoObject>>::iterator it;
+      size_t bytes = 0;
+    };
+
+    std::shared_ptr<ProtoBuilder> builder;
+    std::vector<NdKey> namespaces;
+    std::list<std::shared_ptr<ProtoObject>> lru; /// most recently used first
+    std::unordered_map<ProtoObject*, Entry> entries;
+    std::unordered_map<ProtoObject*, std::weak_ptr<ProtoBuildJob>> building; /// objects of StartWarmUp() jobs
+    size_t budget = 0, used = 0;
+    uint64_t tick = 0;
+
+    void Track(std::shared_ptr<ProtoObject> po);
 
     public:
-    int BuildObjects(std::vector<NdKey> namespaces_, std::vector<std::shared_ptr<ProtoObject>> objects){
-      namespaces = namespaces_;
-
-      msg_debug("build start ...");
-      int ret = PM_SUCCESS;
-      for(auto object : objects){
-        int retloc = BuildObject(object);
-        if(retloc != PM_SUCCESS) ret = retloc;
-      }
-      msg_debug("build done ...");
-      return ret;
-    } 
+    ProtoCache(std::shared_ptr<ProtoBuilder> builder_, std::vector<NdKey> namespaces_);
 
-    ProtoBuilder(std::shared_ptr<Backend> back_, std::shared_ptr<NdMap<ProtoObject>> ndmap_){
-      back = back_;
-      ndmap = ndmap_;
+    //! 0 - no limit
+    void SetBudget(size_t bytes){ budget = bytes; Evict(); }
+    size_t Budget() const { return budget; }
+    size_t Used() const { return used; }
+    int Size() const { return entries.size(); }
 
-      processors["shader"] = [this](const ConfigItem* c) {return std::static_pointer_cast<void>(this->BuildShader(c));};
-      processors["drawer"] = [this](const ConfigItem* c) {return std::static_pointer_cast<void>(this->BuildSimpleDrawer(c));}; 
-      processors["scene"] = [this](const ConfigItem* c) {return std::static_pointer_cast<void>(this->BuildPipeline(c));};
-    }
+    //! warm object on demand and mark it as used, object of a StartWarmUp() job in flight is taken from the job
+    std::shared_ptr<void> Get(std::shared_ptr<ProtoObject> po);
+    template<typename T> std::shared_ptr<T> Get(std::shared_ptr<ProtoObject> po){ return std::static_pointer_cast<T>(Get(po)); }
+
+    //! build cold objects together, see ProtoBuilder::BuildObjects
+    int WarmUp(const std::vector<std::shared_ptr<ProtoObject>> & objects);
+
+    //! same but objects are built by the job Step() calls, see ProtoBuilder::StartBuild
+    std::shared_ptr<ProtoBuildJob> StartWarmUp(const std::vector<std::shared_ptr<ProtoObject>> & objects);
+
+    std::shared_ptr<ProtoBuilder> Builder() const { return builder; }
+    void CoolDown(std::shared_ptr<ProtoObject> po);
+    void Touch(std::shared_ptr<ProtoObject> po);
+
+    void Pin(std::shared_ptr<ProtoObject> po){ po->pins++; }
+    void Unpin(std::shared_ptr<ProtoObject> po){ if(po->pins > 0) po->pins--; }
+
+    //! cool least recently used not pinned objects until under budget, return number of cooled objects
+    int Evict();
   };
 };
 
@@ -206,6 +206,7 @@ namespace pmgd {
   // ======= texture ====================================================================
   GLuint image_format_to_gl(int format){
     if(format == image_format::RGBA) return GL_RGBA;
+    if(format == image_format::RGB) return GL_RGB;
     return image_format::UNDEFINED;
   };
 
@@ -234,7 +235,8 @@ namespace pmgd {
         format = image_format_to_gl(img->format);
         type   = image_type_to_gl(img->type);
         internalformat = format;
-        if(format == (GLuint)image_format::UNDEFINED){
+        /// size of pixels in unknown formats is not known, Bytes() of such image is a guess
+        if(img->data == nullptr or img->format == image_format::UNDEFINED or format == (GLuint)image_format::UNDEFINED){
           msg_warning("invalid image format", img->format);
           return;
         }
@@ -242,6 +244,12 @@ namespace pmgd {
           msg_warning("invalid image type", img->type);
           return;
         }
+        for(auto & mip : img->mips){
+          if(mip == nullptr or mip->data == nullptr or mip->format != img->format or mip->type != img->type){
+            msg_warning("mip level format differs from the image format");
+            return;
+          }
+        }
 
         glGenTextures(1, &id);
         if(not id){
@@ -257,17 +265,27 @@ namespace pmgd {
         // msg( w, h, type, format, GL_FLOAT, GL_RGBA );
         // for(int i = 0; i < 10; i++) msg( i, (int)((unsigned char*) (image->data))[ i ] );
 
+        /// rows are tightly packed, e.g. 3 * w bytes of RGB images are not 4 byte aligned
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
         glTexImage2D(GL_TEXTURE_2D, 0, internalformat, img->w, img->h, 0, format, type, img->data);
         // void glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, const void *data);
         // glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, image->format, image->type, image->data);
 
+        /// levels made on CPU by make_mips(), the chain may stop before 1x1
+        for(int level = 0; level < img->mips.size(); ++level){
+          auto & mip = img->mips[level];
+          glTexImage2D(GL_TEXTURE_2D, level + 1, internalformat, mip->w, mip->h, 0, format, type, mip->data);
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, img->mips.size());
+
         // TODO use or not?
         // glGenerateMipmap(GL_TEXTURE_2D);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         //glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, img->mips.size() ? GL_LINEAR_MIPMAP_LINEAR : GL_NEAREST);
 
         std::string any_errors = gl_get_errors_msg();
         if(any_errors.size()){
@@ -283,6 +301,33 @@ namespace pmgd {
       virtual void Bind()  { if(    is_binded) return; glBindTexture(GL_TEXTURE_2D, id); is_binded = true;  }
       virtual void Unbind(){ if(not is_binded) return; glBindTexture(GL_TEXTURE_2D,  0); is_binded = false; }
 
+      //! rows with padding are uploaded in place with GL_UNPACK_ROW_LENGTH, flipped and channel views are packed first
+      virtual int Upload(const ImageView & view, int x = 0, int y = 0){
+        if(not id or not view.Valid() or view.format == image_format::UNDEFINED or view.channels != image_channels(view.format) or image_format_to_gl(view.format) != format or image_type_to_gl(view.type) != type){
+          msg_warning("can't upload view to texture", id);
+          return PM_ERROR_INCORRECT_ARGUMENTS;
+        }
+
+        ImageView src = view;
+        if(not view.Packed() or view.stride <= 0 or view.stride % view.PixelBytes()) src = ImageView(view.ToImage());
+
+        Bind();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, src.stride / src.PixelBytes());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, src.w, src.h, format, type, src.data);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        Unbind();
+
+        std::string any_errors = gl_get_errors_msg();
+        if(any_errors.size()){
+          msg_warning("GL texture upload failed");
+          msg_warning(any_errors);
+          return PM_ERROR_GL;
+        }
+        return PM_SUCCESS;
+      }
+
       virtual void Draw(const TextureDrawData & data){
         Bind();
         glEnable(GL_TEXTURE_2D);
@@ -0,0 +1,163 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifdef USE_STB
+  #define STB_IMAGE_IMPLEMENTATION
+  #define STB_IMAGE_WRITE_IMPLEMENTATION
+#endif
+
+#include "pmgdlib_image.h"
+
+#include <deque>
+#include <cstdlib>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= PixelPool ====================================================================
+  std::shared_ptr<void> PixelPool::Acquire(size_t bytes){
+    int size_class = MIN_CLASS;
+    while(size_class <= MAX_CLASS and (size_t(1) << size_class) < bytes) size_class++;
+
+    void * ptr = nullptr;
+    size_t size = size_class <= MAX_CLASS ? size_t(1) << size_class : (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if(size_class <= MAX_CLASS){
+      std::lock_guard<std::mutex> lock(mutex);
+      auto & buffers = free_buffers[size_class];
+      if(buffers.size()){
+        ptr = buffers.back();
+        buffers.pop_back();
+        cached -= size;
+        n_reuses++;
+      }
+    }
+    if(ptr == nullptr){
+      ptr = std::aligned_alloc(ALIGNMENT, size);
+      if(ptr == nullptr){
+        msg_error("can't allocate", size, "bytes of pixels");
+        return nullptr;
+      }
+      n_allocs++;
+    }
+    return std::shared_ptr<void>(ptr, [this, size_class, size](void * p){ Release(p, size_class, size); });
+  }
+
+  void PixelPool::Release(void * ptr, int size_class, size_t bytes){
+    if(size_class <= MAX_CLASS){
+      std::lock_guard<std::mutex> lock(mutex);
+      if(cached + bytes <= max_cached){
+        free_buffers[size_class].push_back(ptr);
+        cached += bytes;
+        return;
+      }
+    }
+    std::free(ptr);
+  }
+
+  void PixelPool::Trim(){
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto & buffers : free_buffers){
+      for(void * ptr : buffers) std::free(ptr);
+      buffers.clear();
+    }
+    cached = 0;
+  }
+
+  PixelPool & pixel_pool(){
+    static PixelPool * pool = new PixelPool(); /// never destroyed, images in static objects may outlive any static pool
+    return *pool;
+  }
+
+  // ======= IoImage ====================================================================
+  int IoImage::WriteView(const std::string & path, const ImageView & view){
+    std::shared_ptr<Image> img = view.ToImage();
+    if(img == nullptr){
+      msg_warning("can't write view with", view.channels, "channels to", quote(path));
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    }
+    return Write(path, img);
+  }
+
+  #ifdef USE_STB
+    // ======= IoImageStb ====================================================================
+    int IoImageStb::WriteView(const std::string & path, const ImageView & view){
+      if(view.type == image_type::UNSIGNED_CHAR and view.Packed() and view.stride > 0 and view.stride < (1 << 30)){
+        int n = view.channels;
+        return stbi_write_png(path.c_str(), view.w, view.h, n, view.data, view.stride) ? PM_SUCCESS : PM_ERROR_STB;
+      }
+      return IoImage::WriteView(path, view);
+    }
+
+    int IoImageStb::ReadBatch(const std::vector<std::string> & paths, const std::function<void(int, std::shared_ptr<Image>)> & done, size_t max_bytes){
+      /// pool tasks may start after the batch is over, they only touch the shared state then
+      struct Shared {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::pair<int, std::shared_ptr<Image>>> ready;
+        std::unique_ptr<std::atomic<bool>[]> claimed;
+      };
+      int n = paths.size();
+      auto shared = std::make_shared<Shared>();
+      shared->claimed.reset(new std::atomic<bool>[n]);
+      for(int i = 0; i < n; ++i) shared->claimed[i] = false;
+
+      auto estimate = [](const std::string & path){
+        int w, h, comp;
+        if(not stbi_info(path.c_str(), &w, &h, &comp)) return size_t(0);
+        return size_t(w) * h * (comp < 3 ? 4 : comp); /// grey images are expanded to RGBA
+      };
+
+      std::vector<size_t> bytes(n);
+      size_t in_flight = 0;
+      int next = 0, help_from = 0, n_done = 0, answer = 0;
+      while(n_done < n){
+        /// start decoding while the decoded pixels fit, one image is always allowed
+        while(next < n){
+          bytes[next] = estimate(paths[next]);
+          if(in_flight and max_bytes and in_flight + bytes[next] > max_bytes) break;
+          in_flight += bytes[next];
+          thread_pool().Submit([this, shared, index = next, path = paths[next]](){
+            if(shared->claimed[index].exchange(true)) return;
+            std::shared_ptr<Image> img = this->Read(path);
+            {
+              std::lock_guard<std::mutex> lock(shared->mutex);
+              shared->ready.emplace_back(index, img);
+            }
+            shared->cv.notify_one();
+          });
+          next++;
+        }
+
+        std::pair<int, std::shared_ptr<Image>> item(-1, nullptr);
+        {
+          std::lock_guard<std::mutex> lock(shared->mutex);
+          if(shared->ready.size()){
+            item = std::move(shared->ready.front());
+            shared->ready.pop_front();
+          }
+        }
+
+        /// nothing is ready, decode a queued image here instead of waiting
+        for(; item.first < 0 and help_from < next; help_from++){
+          if(shared->claimed[help_from].exchange(true)) continue;
+          item = {help_from, Read(paths[help_from])};
+        }
+
+        if(item.first < 0){
+          std::unique_lock<std::mutex> lock(shared->mutex);
+          shared->cv.wait(lock, [&shared](){ return shared->ready.size(); });
+          item = std::move(shared->ready.front());
+          shared->ready.pop_front();
+        }
+
+        in_flight -= bytes[item.first];
+        n_done++;
+        if(item.second and item.second->data) answer++;
+        done(item.first, item.second);
+      }
+      return answer;
+    }
+  #endif
+};
@@ -5,13 +5,21 @@
 #ifndef PMGDLIB_IMAGE_HH
 #define PMGDLIB_IMAGE_HH 1
 
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
 #include "pmgdlib_defs.h"
 #include "pmgdlib_core.h"
 
 #ifdef USE_STB
+  /// implementation is compiled in pmgdlib_image.cpp
   #define STBI_ONLY_PNG 1
-  #define STB_IMAGE_IMPLEMENTATION
-  #define STB_IMAGE_WRITE_IMPLEMENTATION
   #include "stb_image.h"
   #include "stb_image_write.h"
 #endif
@@ -21,6 +29,44 @@
 #endif
 
 namespace pmgd {
+  // ======= PixelPool ====================================================================
+  //! 64-byte aligned pixel buffers in power-of-two size classes,
+  //! released buffers are kept for reuse up to max_cached bytes, so images recreated every frame
+  //! (screenshots, readbacks, scratch images of CPU kernels) don't go to the allocator,
+  //! the pool must outlive its buffers, pixel_pool() is never destroyed
+  class PixelPool : public BaseMsg {
+    static const int MIN_CLASS = 8;  /// 256 bytes
+    static const int MAX_CLASS = 30; /// 1 GB, larger buffers are not kept
+    std::mutex mutex;
+    std::vector<void*> free_buffers[MAX_CLASS + 1];
+    size_t cached = 0, max_cached;
+    std::atomic<int> n_allocs = 0, n_reuses = 0;
+
+    void Release(void * ptr, int size_class, size_t bytes);
+
+    public:
+    static const size_t ALIGNMENT = 64;
+
+    PixelPool(size_t max_cached_ = size_t(64) << 20) : max_cached(max_cached_) {}
+    ~PixelPool(){ Trim(); }
+
+    //! aligned buffer of at least bytes, returned to the pool when the last owner is gone
+    std::shared_ptr<void> Acquire(size_t bytes);
+    //! free all kept buffers
+    void Trim();
+
+    size_t Cached() const { return cached; }
+    int Allocs() const { return n_allocs; }
+    int Reuses() const { return n_reuses; }
+  };
+
+  PixelPool & pixel_pool();
+
+  // ======= Image ====================================================================
+  //! channels per pixel, undefined formats are treated as RGBA
+  inline int image_channels(int format){
+    return format == image_format::RGB ? 3 : 4;
+  }
 
   // image base class
   class Image {
@@ -30,6 +76,8 @@ namespace pmgd {
       int w,h;
       int format, type;
       v2 size;
+      std::shared_ptr<const void> owner; /// frees data with the image: pool buffer, stb or SDL allocation, mapped file, nullptr - data is not owned
+      std::vector<std::shared_ptr<Image>> mips; /// levels 1, 2, ... of the mip chain, see make_mips()
 
     public:
       Image(void *data_, int w_, int h_, int format_, int type_, void* userdata_=nullptr){
@@ -41,42 +89,215 @@ namespace pmgd {
         userdata = userdata_;
         size = v2(w,h);
       }
+
+      //! image with own aligned storage from pixel_pool(), pixels are not initialized
+      Image(int w_, int h_, int format_ = image_format::RGBA, int type_ = image_type::UNSIGNED_CHAR) : Image(nullptr, w_, h_, format_, type_) {
+        std::shared_ptr<void> buffer = pixel_pool().Acquire(Bytes());
+        data = buffer.get();
+        owner = std::move(buffer);
+      }
+
+      //! take ownership of foreign data, deleter is called with data when the image is gone
+      template<typename D> Image(void *data_, int w_, int h_, int format_, int type_, D deleter, void* userdata_=nullptr) : Image(data_, w_, h_, format_, type_, userdata_) {
+        owner = std::shared_ptr<void>(data_, deleter);
+      }
+
+      //! bytes of pixel data
+      size_t Bytes() const {
+        size_t channel = type == image_type::UNSIGNED_CHAR ? 1 : 4;
+        return size_t(w) * h * image_channels(format) * channel;
+      }
+
+      //! copy into own pooled storage
+      std::shared_ptr<Image> Clone() const {
+        auto answer = std::make_shared<Image>(w, h, format, type);
+        if(data) memcpy(answer->data, data, Bytes());
+        answer->mips = mips;
+        return answer;
+      }
   };
 
-  std::shared_ptr<Image> get_test_image(int type = image_type::FLOAT){
+  // ======= ImageView ====================================================================
+  //! window into pixels of an image without copies: w x h pixels of channels values,
+  //! rows are stride bytes apart and pixels are step bytes apart, negative for flips,
+  //! views of views share the owner of the pixels, CPU kernels take views
+  struct ImageView {
+    uint8_t * data = nullptr; /// first channel of the top left pixel
+    int w = 0, h = 0;
+    int format = image_format::UNDEFINED, type = image_type::UNDEFINED;
+    int channels = 0;
+    ptrdiff_t stride = 0;
+    ptrdiff_t step = 0;
+    std::shared_ptr<const void> owner;
+
+    ImageView(){}
+    //! view of the whole image, keeps the image alive
+    ImageView(std::shared_ptr<Image> img) : ImageView(*img) { owner = img; }
+    //! view of the whole image, the image must outlive the view if it does not own data
+    ImageView(const Image & img){
+      data = (uint8_t*)img.data;
+      w = img.w;
+      h = img.h;
+      format = img.format;
+      type = img.type;
+      channels = image_channels(format);
+      step = PixelBytes();
+      stride = step * w;
+      owner = img.owner;
+    }
+
+    bool Valid() const { return data != nullptr and w > 0 and h > 0; }
+    size_t ChannelBytes() const { return type == image_type::UNSIGNED_CHAR ? 1 : 4; }
+    size_t PixelBytes() const { return channels * ChannelBytes(); }
+    //! bytes of the packed copy
+    size_t Bytes() const { return size_t(w) * h * PixelBytes(); }
+    //! pixels of a row are adjacent, rows may have padding
+    bool Packed() const { return step == ptrdiff_t(PixelBytes()); }
+    //! the view is one tightly packed block, the same layout as Image
+    bool Contiguous() const { return Packed() and stride == step * w; }
+
+    uint8_t * Row(int y) const { return data + y * stride; }
+    uint8_t * Pixel(int x, int y) const { return data + y * stride + x * step; }
+    template<typename T> T * At(int x, int y, int c = 0) const { return (T*)(Pixel(x, y) + c * ChannelBytes()); }
+
+    //! sub-rectangle, clipped to the view
+    ImageView Sub(int x, int y, int w_, int h_) const {
+      ImageView answer = *this;
+      int x1 = std::min(w, x + w_), y1 = std::min(h, y + h_);
+      x = std::max(0, x);
+      y = std::max(0, y);
+      answer.w = std::max(0, x1 - x);
+      answer.h = std::max(0, y1 - y);
+      answer.data = Pixel(x, y);
+      return answer;
+    }
+
+    ImageView FlipX() const {
+      ImageView answer = *this;
+      answer.data = Pixel(w - 1, 0);
+      answer.step = -step;
+      return answer;
+    }
+
+    ImageView FlipY() const {
+      ImageView answer = *this;
+      answer.data = Row(h - 1);
+      answer.stride = -stride;
+      return answer;
+    }
+
+    //! single channel c of every pixel
+    ImageView Channel(int c) const {
+      ImageView answer = *this;
+      answer.data = data + c * ChannelBytes();
+      answer.channels = 1;
+      answer.format = image_format::UNDEFINED;
+      return answer;
+    }
+
+    //! tiles of tile_w x tile_h in rows from the top left, incomplete tiles are skipped
+    std::vector<ImageView> Grid(int tile_w, int tile_h) const {
+      std::vector<ImageView> answer;
+      if(tile_w <= 0 or tile_h <= 0) return answer;
+      for(int y = 0; y + tile_h <= h; y += tile_h)
+        for(int x = 0; x + tile_w <= w; x += tile_w)
+          answer.push_back(Sub(x, y, tile_w, tile_h));
+      return answer;
+    }
+
+    //! pack pixels into dst of Bytes() size
+    void CopyTo(void * dst) const {
+      uint8_t * out = (uint8_t*)dst;
+      size_t row_bytes = w * PixelBytes();
+      if(Contiguous()){
+        memcpy(out, data, Bytes());
+        return;
+      }
+      for(int y = 0; y < h; ++y, out += row_bytes){
+        if(Packed()){
+          memcpy(out, Row(y), row_bytes);
+          continue;
+        }
+        for(int x = 0; x < w; ++x) memcpy(out + x * PixelBytes(), Pixel(x, y), PixelBytes());
+      }
+    }
+
+    //! packed copy in pooled storage, not for channel views
+    std::shared_ptr<Image> ToImage() const {
+      if(channels != image_channels(format)) return nullptr;
+      auto answer = std::make_shared<Image>(w, h, format, type);
+      CopyTo(answer->data);
+      return answer;
+    }
+  };
+
+  inline std::shared_ptr<Image> get_test_image(int type = image_type::FLOAT){
     if(type == image_type::UNSIGNED_CHAR){
-      unsigned char *test_image_data = new unsigned char[64] { 255, 0, 0, 255,   0, 255, 0, 255,   255, 0, 0, 255,   0, 0, 255, 255,
+      static const unsigned char test_image_data[64] = { 255, 0, 0, 255,   0, 255, 0, 255,   255, 0, 0, 255,   0, 0, 255, 255,
                                                                0, 255, 0, 255,   255, 0, 0, 255,   0, 255, 0, 255,   255, 0, 0, 255,
                                                                255, 0, 0, 255,   0, 255, 0, 255,   255, 0, 0, 255,   0, 0, 255, 255,
                                                                0, 255, 0, 255,   255, 0, 0, 255,   0, 255, 0, 255,   255, 0, 0, 255 };
-      return std::make_shared<Image>(test_image_data, 4, 4, image_format::RGBA, image_type::UNSIGNED_CHAR);
+      auto answer = std::make_shared<Image>(4, 4, image_format::RGBA, image_type::UNSIGNED_CHAR);
+      memcpy(answer->data, test_image_data, sizeof(test_image_data));
+      return answer;
     }
 
     // checker image, 4x4, GL_RGBA, GL_FLOAT data.
-    float *test_image_data = new float[64] { 1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,   1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,
+    static const float test_image_data[64] = { 1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,   1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,
                                              0.0f, 0.0f, 1.0f, 1.0f,   1.0f, 1.0f, 0.0f, 1.0f,   0.0f, 0.0f, 1.0f, 1.0f,   1.0f, 1.0f, 0.0f, 1.0f,
                                              1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,   1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,
                                              0.0f, 0.0f, 1.0f, 1.0f,   1.0f, 1.0f, 0.0f, 1.0f,   0.0f, 0.0f, 1.0f, 1.0f,   1.0f, 1.0f, 0.0f, 1.0f };
 
-    return std::make_shared<Image>(test_image_data, 4, 4, image_format::RGBA, image_type::FLOAT);
+    auto answer = std::make_shared<Image>(4, 4, image_format::RGBA, image_type::FLOAT);
+    memcpy(answer->data, test_image_data, sizeof(test_image_data));
+    return answer;
   };
 
   #ifdef USE_STB
+    //! image over stb pixels, grey & grey + alpha are expanded to RGBA so decoded images always have a known format
+    inline std::shared_ptr<Image> image_from_stb(unsigned char * data, int w, int h, int n){
+      if(data == nullptr) return nullptr;
+      if(n == 4) return std::make_shared<Image>((void*)data, w, h, image_format::RGBA, image_type::UNSIGNED_CHAR, stbi_image_free);
+      if(n == 3) return std::make_shared<Image>((void*)data, w, h, image_format::RGB, image_type::UNSIGNED_CHAR, stbi_image_free);
+
+      auto answer = std::make_shared<Image>(w, h, image_format::RGBA, image_type::UNSIGNED_CHAR);
+      uint8_t * out = (uint8_t*)answer->data;
+      for(size_t i = 0; i < size_t(w) * h; ++i){
+        memset(out + 4 * i, data[i * n], 3);
+        out[4 * i + 3] = n == 2 ? data[i * n + 1] : 255;
+      }
+      stbi_image_free(data);
+      return answer;
+    }
+
+    //! decode png from memory, nullptr on error
+    inline std::shared_ptr<Image> decode_image_stb(const void * raw, size_t size){
+      int w, h, n;
+      unsigned char *data = stbi_load_from_memory((const stbi_uc*)raw, size, &w, &h, &n, 0);
+      return image_from_stb(data, w, h, n);
+    }
+
     class IoImageStb : public IoImage {
       public:
       virtual std::shared_ptr<Image> Read(const std::string & path) {
         int w, h, n;
         unsigned char *data = stbi_load(path.c_str(), &w, &h, &n, 0);
-        int format = image_format::UNDEFINED;
-        if(n == 4) format = image_format::RGBA;
-        return std::make_shared<Image>((void*)data, w, h, format, image_type::UNSIGNED_CHAR);
+        return image_from_stb(data, w, h, n);
       };
 
       virtual int Write(const std::string & path, std::shared_ptr<Image> image) {
         int n = 0;
         if(image->format == image_format::RGBA) n = 4;
+        if(image->format == image_format::RGB) n = 3;
         return stbi_write_png(path.c_str(), image->w, image->h, n, image->data, 0) ? PM_SUCCESS : PM_ERROR_STB;
       }
+
+      //! rows with padding are written in place, other views are packed first
+      virtual int WriteView(const std::string & path, const ImageView & view);
+
+      //! decode concurrently on thread_pool(), decoded size is known from the png header before decoding,
+      //! the calling thread decodes too while waiting, so it is safe to call from pool tasks
+      virtual int ReadBatch(const std::vector<std::string> & paths, const std::function<void(int, std::shared_ptr<Image>)> & done, size_t max_bytes = 256 << 20);
     };
   #endif
 
@@ -96,7 +317,9 @@ namespace pmgd {
 
         int format = image_format::RGBA;
         int type = image_type::UNSIGNED_CHAR;
-        return std::make_shared<Image>((void*)surf->pixels, surf->w, surf->h, format, type, (void*)surf);
+        auto answer = std::make_shared<Image>((void*)surf->pixels, surf->w, surf->h, format, type, (void*)surf);
+        answer->owner = std::shared_ptr<SDL_Surface>(surf, SDL_FreeSurface);
+        return answer;
       };
     };
   #endif
@@ -0,0 +1,221 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <fstream>
+#include <iterator>
+
+#include "pmgdlib_io.h"
+
+#ifdef PMGD_USE_MMAP
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+namespace pmgd {
+  // ======= MappedFile ====================================================================
+  MappedFile::MappedFile(const std::string & path, bool private_copy){
+    ptr = "";
+    #ifdef PMGD_USE_MMAP
+      int fd = open(path.c_str(), O_RDONLY);
+      if(fd < 0){
+        msg_warning("can't open", quote(path));
+        return;
+      }
+
+      struct stat st;
+      if(fstat(fd, &st) != 0){
+        msg_warning("can't stat", quote(path));
+        close(fd);
+        return;
+      }
+
+      /// zero-length mappings are not allowed, empty file is a valid empty view
+      if(st.st_size > 0){
+        int prot = private_copy ? PROT_READ | PROT_WRITE : PROT_READ;
+        void * addr = mmap(nullptr, st.st_size, prot, MAP_PRIVATE, fd, 0);
+        if(addr == MAP_FAILED){
+          msg_warning("mmap() failed for", quote(path));
+          close(fd);
+          return;
+        }
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(addr);
+        size = st.st_size;
+        mapped = true;
+      }
+      close(fd); /// mapping stays valid after the descriptor is closed
+      valid = true;
+    #else
+      std::ifstream file(path, std::ios::binary);
+      if(not file){
+        msg_warning("can't open", quote(path));
+        return;
+      }
+      buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+      ptr = buffer.data();
+      size = buffer.size();
+      valid = true;
+    #endif
+  }
+
+  MappedFile::~MappedFile(){
+    #ifdef PMGD_USE_MMAP
+      if(mapped) munmap(const_cast<char*>(ptr), size);
+    #endif
+  }
+
+  // ======= IoTxtMmap ====================================================================
+  TxtView IoTxtMmap::View(const std::string & path){
+    auto file = std::make_shared<const MappedFile>(path);
+    if(not file->Valid()) return TxtView();
+    return TxtView{file->View(), file};
+  }
+
+  std::string IoTxtMmap::Read(const std::string & path){
+    return View(path).Str();
+  }
+
+  int IoTxtMmap::Write(const std::string & path, const std::string & data){
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if(not file){
+      msg_warning("can't open", quote(path), "for writing");
+      return PM_ERROR_IO;
+    }
+    file.write(data.data(), data.size());
+    return file ? PM_SUCCESS : PM_ERROR_IO;
+  }
+
+  // ======= IoQueue ====================================================================
+  IoQueue::IoQueue(std::shared_ptr<IO> io_, int n_threads){
+    io = io_;
+    if(n_threads <= 0) n_threads = 2;
+    for(int i = 0; i < n_threads; ++i)
+      workers.emplace_back([this](){ this->Work(); });
+  }
+
+  IoQueue::~IoQueue(){
+    std::map<std::pair<int, uint64_t>, Request> cancelled;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+      cancelled.swap(pending);
+      priorities.clear();
+    }
+    cv_request.notify_all();
+    for(auto & worker : workers) worker.join();
+    for(auto & it : cancelled) it.second.cancel();
+  }
+
+  void IoQueue::Work(){
+    while(true){
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_request.wait(lock, [this](){ return stop or pending.size(); });
+        if(stop) return;
+        auto it = pending.begin();
+        request = std::move(it->second);
+        priorities.erase(it->first.second);
+        pending.erase(it);
+        n_running++;
+      }
+
+      request.run();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        n_running--;
+      }
+      cv_done.notify_all();
+    }
+  }
+
+  uint64_t IoQueue::Push(int priority, Request && request){
+    uint64_t id;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      id = next_id++;
+      pending[{-priority, id}] = std::move(request);
+      priorities[id] = priority;
+    }
+    cv_request.notify_one();
+    return id;
+  }
+
+  void IoQueue::Complete(std::function<void()> && callback){
+    std::lock_guard<std::mutex> lock(mutex);
+    completed.push_back(std::move(callback));
+  }
+
+  IoTicket<TxtView> IoQueue::ReadTxt(const std::string & path, int priority, std::function<void(const TxtView &)> done){
+    std::shared_ptr<IO> io_ = io;
+    return Submit<TxtView>([io_, path](){ return io_->ViewTxt(path); }, priority, done);
+  }
+
+  IoTicket<std::shared_ptr<Image>> IoQueue::ReadImage(const std::string & path, int priority, std::function<void(const std::shared_ptr<Image> &)> done){
+    std::shared_ptr<IO> io_ = io;
+    return Submit<std::shared_ptr<Image>>([io_, path](){ return io_->ReadImage(path); }, priority, done);
+  }
+
+  std::vector<IoTicket<TxtView>> IoQueue::ReadTxt(const std::vector<std::string> & paths, int priority){
+    std::vector<IoTicket<TxtView>> answer;
+    answer.reserve(paths.size());
+    for(auto & path : paths) answer.push_back(ReadTxt(path, priority));
+    return answer;
+  }
+
+  std::vector<IoTicket<std::shared_ptr<Image>>> IoQueue::ReadImage(const std::vector<std::string> & paths, int priority){
+    std::vector<IoTicket<std::shared_ptr<Image>>> answer;
+    answer.reserve(paths.size());
+    for(auto & path : paths) answer.push_back(ReadImage(path, priority));
+    return answer;
+  }
+
+  bool IoQueue::Cancel(uint64_t id){
+    Request request;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = priorities.find(id);
+      if(it == priorities.end()) return false;
+      auto pit = pending.find({-it->second, id});
+      request = std::move(pit->second);
+      pending.erase(pit);
+      priorities.erase(it);
+    }
+    request.cancel();
+    cv_done.notify_all();
+    return true;
+  }
+
+  bool IoQueue::SetPriority(uint64_t id, int priority){
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = priorities.find(id);
+    if(it == priorities.end()) return false;
+    auto node = pending.extract({-it->second, id});
+    node.key() = {-priority, id};
+    pending.insert(std::move(node));
+    it->second = priority;
+    return true;
+  }
+
+  int IoQueue::Poll(){
+    std::deque<std::function<void()>> callbacks;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      callbacks.swap(completed);
+    }
+    for(auto & callback : callbacks) callback();
+    return callbacks.size();
+  }
+
+  void IoQueue::Wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cv_done.wait(lock, [this](){ return pending.empty() and n_running == 0; });
+  }
+
+  int IoQueue::Pending(){
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+  }
+};
@@ -0,0 +1,147 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_IO_HH
+#define PMGDLIB_IO_HH 1
+
+#include <string>
+#include <string_view>
+#include <memory>
+#include <map>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <unordered_map>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_core.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+  #define PMGD_USE_MMAP 1
+#endif
+
+namespace pmgd {
+  // ======= MappedFile ====================================================================
+  //! read-only file content mapped into memory, unmapped in destructor,
+  //! private_copy - pages are writable copy-on-write, changes are never written to the file,
+  //! without mmap support the file is read into a buffer
+  class MappedFile : public BaseMsg {
+    const char * ptr = nullptr;
+    size_t size = 0;
+    bool valid = false;
+    bool mapped = false;
+    std::string buffer;
+
+    public:
+    MappedFile(const std::string & path, bool private_copy = false);
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    bool Valid() const { return valid; }
+    const char * Data() const { return ptr; }
+    size_t Size() const { return size; }
+    std::string_view View() const { return std::string_view(ptr, size); }
+  };
+
+  // ======= IoTxtMmap ====================================================================
+  //! text IO over mapped files, View() returns the mapping itself without copies,
+  //! Read() copies the content into std::string for the old interface
+  class IoTxtMmap : public IoTxt, public BaseMsg {
+    public:
+    virtual std::string Read(const std::string & path);
+    virtual TxtView View(const std::string & path);
+    virtual int Write(const std::string & path, const std::string & data);
+  };
+
+  // ======= IoQueue ====================================================================
+  //! handle of the queued request, result is empty (TxtView(), nullptr image) if the request is cancelled
+  template<typename T>
+  struct IoTicket {
+    uint64_t id = 0;
+    std::shared_future<T> result;
+
+    bool Ready() const { return result.valid() and result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+  };
+
+  //! asynchronous reads on dedicated IO threads,
+  //! requests with higher priority go first, requests with equal priority in submission order,
+  //! completion callbacks are called from Poll() on the thread owning the queue, e.g. between frames
+  class IoQueue : public BaseMsg {
+    struct Request {
+      std::function<void()> run;
+      std::function<void()> cancel;
+    };
+
+    std::shared_ptr<IO> io;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable cv_request, cv_done;
+    std::map<std::pair<int, uint64_t>, Request> pending; /// (-priority, id) -> request
+    std::unordered_map<uint64_t, int> priorities;
+    std::deque<std::function<void()>> completed;
+    uint64_t next_id = 1;
+    int n_running = 0;
+    bool stop = false;
+
+    void Work();
+    uint64_t Push(int priority, Request && request);
+    void Complete(std::function<void()> && callback);
+
+    public:
+    //! n_threads <= 0 means 2 threads, IO is bound by the storage rather than CPU
+    IoQueue(std::shared_ptr<IO> io_, int n_threads = 2);
+    //! pending requests are cancelled, running requests are finished
+    ~IoQueue();
+
+    //! queue any read, load() runs on an IO thread, done(result) is called from Poll()
+    template<typename T>
+    IoTicket<T> Submit(std::function<T()> load, int priority = 0, std::function<void(const T &)> done = nullptr){
+      auto promise = std::make_shared<std::promise<T>>();
+      IoTicket<T> answer;
+      answer.result = promise->get_future().share();
+
+      Request request;
+      request.run = [this, promise, load, done](){
+        T value;
+        try {
+          value = load();
+        } catch(...) {
+          promise->set_exception(std::current_exception());
+          return;
+        }
+        promise->set_value(value);
+        if(done) Complete([done, value](){ done(value); });
+      };
+      request.cancel = [promise](){ promise->set_value(T()); };
+      answer.id = Push(priority, std::move(request));
+      return answer;
+    }
+
+    IoTicket<TxtView> ReadTxt(const std::string & path, int priority = 0, std::function<void(const TxtView &)> done = nullptr);
+    IoTicket<std::shared_ptr<Image>> ReadImage(const std::string & path, int priority = 0, std::function<void(const std::shared_ptr<Image> &)> done = nullptr);
+
+    //! batches keep the order of paths
+    std::vector<IoTicket<TxtView>> ReadTxt(const std::vector<std::string> & paths, int priority = 0);
+    std::vector<IoTicket<std::shared_ptr<Image>>> ReadImage(const std::vector<std::string> & paths, int priority = 0);
+
+    //! true if the request was still pending, running & finished requests are not affected
+    bool Cancel(uint64_t id);
+    //! move pending request in the queue, false if it is not pending anymore
+    bool SetPriority(uint64_t id, int priority);
+
+    //! call completion callbacks of finished requests, return number of called callbacks
+    int Poll();
+    //! block until no requests are pending or running, callbacks are not called
+    void Wait();
+
+    int Pending();
+    int Size() const { return workers.size(); }
+  };
+};
+
+#endif
@@ -0,0 +1,224 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cstring>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "pmgdlib_lz.h"
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= LZ block compression ====================================================================
+  static const int LZ_HASH_LOG = 12;
+  static const size_t LZ_MIN_MATCH = 4;
+  static const size_t LZ_LAST_LITERALS = 5; /// block ends with literals, so decoder never reads past the match
+  static const size_t LZ_MF_LIMIT = 12;     /// no matches start in the last bytes
+  static const size_t LZ_MAX_OFFSET = 0xFFFF;
+  static const uint32_t LZ_STORED = 0x80000000u;
+  static const size_t LZ_MAX_RATIO = 255;   /// decoded bytes per encoded byte, 255 is one extra byte of match length
+
+  static inline uint32_t lz_read32(const uint8_t * p){
+    uint32_t answer;
+    memcpy(&answer, p, 4);
+    return answer;
+  }
+
+  static inline uint32_t lz_hash(uint32_t seq){
+    return (seq * 2654435761u) >> (32 - LZ_HASH_LOG);
+  }
+
+  static inline uint8_t * lz_put_length(uint8_t * op, size_t len){
+    for(; len >= 255; len -= 255) *op++ = 255;
+    *op++ = len;
+    return op;
+  }
+
+  static inline uint8_t * lz_put_sequence(uint8_t * op, const uint8_t * literals, size_t n_literals, size_t offset, size_t match){
+    uint8_t * token = op++;
+    *token = std::min<size_t>(n_literals, 15) << 4;
+    if(n_literals >= 15) op = lz_put_length(op, n_literals - 15);
+    memcpy(op, literals, n_literals);
+    op += n_literals;
+    if(not match) return op; /// last literals
+
+    *op++ = offset & 0xFF;
+    *op++ = offset >> 8;
+    match -= LZ_MIN_MATCH;
+    *token |= std::min<size_t>(match, 15);
+    if(match >= 15) op = lz_put_length(op, match - 15);
+    return op;
+  }
+
+  size_t lz_compress_block(const char * src, size_t size, std::string & out){
+    size_t start = out.size();
+    out.resize(start + lz_block_bound(size));
+    const uint8_t * base = (const uint8_t*)src;
+    uint8_t * op = (uint8_t*)out.data() + start;
+
+    size_t anchor = 0;
+    if(size >= LZ_MF_LIMIT){
+      uint32_t table[1 << LZ_HASH_LOG] = {};
+      size_t limit = size - LZ_MF_LIMIT;
+      size_t match_limit = size - LZ_LAST_LITERALS;
+      size_t ip = 0;
+      unsigned misses = 0;
+      while(ip <= limit){
+        uint32_t seq = lz_read32(base + ip);
+        uint32_t h = lz_hash(seq);
+        size_t ref = table[h];
+        table[h] = ip;
+        if(ref >= ip or ip - ref > LZ_MAX_OFFSET or lz_read32(base + ref) != seq){
+          ip += 1 + (misses++ >> 6); /// skip faster over incompressible data
+          continue;
+        }
+
+        while(ip > anchor and ref > 0 and base[ip - 1] == base[ref - 1]){ ip--; ref--; }
+        size_t len = LZ_MIN_MATCH;
+        while(ip + len < match_limit and base[ip + len] == base[ref + len]) len++;
+
+        op = lz_put_sequence(op, base + anchor, ip - anchor, ip - ref, len);
+        ip += len;
+        anchor = ip;
+        misses = 0;
+        if(ip - 2 <= limit) table[lz_hash(lz_read32(base + ip - 2))] = ip - 2;
+      }
+    }
+
+    op = lz_put_sequence(op, base + anchor, size - anchor, 0, 0);
+    out.resize(op - (uint8_t*)out.data());
+    return out.size() - start;
+  }
+
+  int64_t lz_decompress_block(const char * src, size_t size, char * dst, size_t dst_size){
+    const uint8_t * ip = (const uint8_t*)src;
+    const uint8_t * iend = ip + size;
+    uint8_t * begin = (uint8_t*)dst;
+    uint8_t * op = begin;
+    uint8_t * oend = op + dst_size;
+
+    auto get_length = [&](size_t & len){
+      uint8_t b;
+      do {
+        if(ip >= iend) return false;
+        b = *ip++;
+        len += b;
+      } while(b == 255);
+      return true;
+    };
+
+    while(ip < iend){
+      unsigned token = *ip++;
+      size_t n_literals = token >> 4;
+      if(n_literals == 15 and not get_length(n_literals)) return -1;
+      if(n_literals > size_t(iend - ip) or n_literals > size_t(oend - op)) return -1;
+      memcpy(op, ip, n_literals);
+      op += n_literals;
+      ip += n_literals;
+      if(ip == iend) break; /// last sequence has no match
+
+      if(iend - ip < 2) return -1;
+      size_t offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if(offset == 0 or offset > size_t(op - begin)) return -1;
+
+      size_t len = token & 15;
+      if(len == 15 and not get_length(len)) return -1;
+      len += LZ_MIN_MATCH;
+      if(len > size_t(oend - op)) return -1;
+
+      const uint8_t * ref = op - offset;
+      if(offset >= len) memcpy(op, ref, len);
+      else for(size_t i = 0; i < len; ++i) op[i] = ref[i]; /// overlapped copy repeats the pattern
+      op += len;
+    }
+    return op - begin;
+  }
+
+  std::string lz_compress(std::string_view src, uint32_t block_size, bool parallel){
+    if(block_size == 0 or block_size >= LZ_STORED) block_size = LZ_BLOCK_SIZE;
+    LzHeader header;
+    header.block_size = block_size;
+    header.raw_size = src.size();
+    header.n_blocks = (src.size() + block_size - 1) / block_size;
+
+    std::vector<std::string> blocks(header.n_blocks);
+    std::vector<uint32_t> sizes(header.n_blocks);
+    auto compress = [&](int i_start, int i_end){
+      for(int i = i_start; i < i_end; ++i){
+        const char * block = src.data() + size_t(i) * block_size;
+        size_t n = std::min<size_t>(block_size, src.size() - size_t(i) * block_size);
+        lz_compress_block(block, n, blocks[i]);
+        sizes[i] = blocks[i].size();
+        if(blocks[i].size() >= n){
+          blocks[i].assign(block, n);
+          sizes[i] = n | LZ_STORED;
+        }
+      }
+    };
+    if(parallel and header.n_blocks > 1) parallel_for(thread_pool(), 0, header.n_blocks, compress);
+    else compress(0, header.n_blocks);
+
+    size_t total = sizeof(LzHeader) + sizes.size() * sizeof(uint32_t);
+    for(auto & block : blocks) total += block.size();
+    std::string answer;
+    answer.reserve(total);
+    answer.append((const char*)&header, sizeof(header));
+    answer.append((const char*)sizes.data(), sizes.size() * sizeof(uint32_t));
+    for(auto & block : blocks) answer += block;
+    return answer;
+  }
+
+  int64_t lz_raw_size(std::string_view src){
+    LzHeader header;
+    if(src.size() < sizeof(LzHeader)) return -1;
+    memcpy(&header, src.data(), sizeof(header));
+    if(memcmp(header.magic, LzHeader().magic, sizeof(header.magic))) return -1;
+    return header.raw_size;
+  }
+
+  int lz_decompress(std::string_view src, std::string & out, bool parallel){
+    if(lz_raw_size(src) < 0) return PM_ERROR;
+    LzHeader header;
+    memcpy(&header, src.data(), sizeof(header));
+    if(header.block_size == 0 or header.block_size >= LZ_STORED) return PM_ERROR;
+    if(header.n_blocks != header.raw_size / header.block_size + (header.raw_size % header.block_size != 0)) return PM_ERROR;
+
+    size_t table_end = sizeof(LzHeader) + size_t(header.n_blocks) * sizeof(uint32_t);
+    if(table_end > src.size()) return PM_ERROR;
+    std::vector<uint32_t> sizes(header.n_blocks);
+    if(sizes.size()) memcpy(sizes.data(), src.data() + sizeof(LzHeader), sizes.size() * sizeof(uint32_t));
+
+    /// raw size is not trusted before allocation, every block can't decode to more than its stored size allows
+    std::vector<size_t> offsets(header.n_blocks);
+    size_t offset = table_end;
+    for(uint32_t i = 0; i < header.n_blocks; ++i){
+      offsets[i] = offset;
+      size_t stored = sizes[i] & ~LZ_STORED;
+      size_t n = std::min<uint64_t>(header.block_size, header.raw_size - uint64_t(i) * header.block_size);
+      if(n > ((sizes[i] & LZ_STORED) ? stored : stored * LZ_MAX_RATIO)) return PM_ERROR;
+      offset += stored;
+    }
+    if(offset > src.size()) return PM_ERROR;
+
+    out.resize(header.raw_size);
+    std::atomic<bool> ok = true;
+    auto decompress = [&](int i_start, int i_end){
+      for(int i = i_start; i < i_end; ++i){
+        char * dst = out.data() + size_t(i) * header.block_size;
+        size_t n = std::min<size_t>(header.block_size, header.raw_size - size_t(i) * header.block_size);
+        size_t stored = sizes[i] & ~LZ_STORED;
+        if(sizes[i] & LZ_STORED){
+          if(stored != n){ ok = false; return; }
+          memcpy(dst, src.data() + offsets[i], n);
+        } else if(lz_decompress_block(src.data() + offsets[i], stored, dst, n) != int64_t(n)){
+          ok = false;
+          return;
+        }
+      }
+    };
+    if(parallel and header.n_blocks > 1) parallel_for(thread_pool(), 0, header.n_blocks, decompress);
+    else decompress(0, header.n_blocks);
+    return ok ? PM_SUCCESS : PM_ERROR;
+  }
+};
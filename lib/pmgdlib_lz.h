@@ -0,0 +1,46 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_LZ_HH
+#define PMGDLIB_LZ_HH 1
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+#include "pmgdlib_defs.h"
+
+namespace pmgd {
+  // ======= LZ block compression ====================================================================
+  //! LZ77 with the LZ4 block layout: token (literals length << 4 | match length - 4), literals, 16 bit offset,
+  //! greedy matching over 4 byte hashes, no entropy coding - decoding is a sequence of memcpy's
+
+  //! max compressed size of n bytes
+  inline size_t lz_block_bound(size_t n){ return n + n / 255 + 16; }
+
+  //! append compressed src to out, return compressed size
+  size_t lz_compress_block(const char * src, size_t size, std::string & out);
+
+  //! decode one block into dst, return decoded size or -1 on broken input or too small dst
+  int64_t lz_decompress_block(const char * src, size_t size, char * dst, size_t dst_size);
+
+  //! framed stream of independent blocks, which are compressed & decoded in parallel on thread_pool():
+  //!   LzHeader, uint32_t stored size of every block (high bit - block is stored as is), blocks
+  struct LzHeader {
+    char magic[4] = {'P', 'M', 'L', 'Z'};
+    uint32_t block_size = 0;
+    uint64_t raw_size = 0;
+    uint32_t n_blocks = 0;
+    uint32_t reserved = 0;
+  };
+
+  static const uint32_t LZ_BLOCK_SIZE = 1 << 16;
+
+  std::string lz_compress(std::string_view src, uint32_t block_size = LZ_BLOCK_SIZE, bool parallel = true);
+
+  //! PM_SUCCESS or PM_ERROR for broken streams, out is resized to the raw size
+  int lz_decompress(std::string_view src, std::string & out, bool parallel = true);
+
+  //! raw size from the header, -1 if src is not a stream
+  int64_t lz_raw_size(std::string_view src);
+};
+
+#endif
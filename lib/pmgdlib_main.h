@@ -9,6 +9,10 @@
 #include "pmgdlib_config.h"
 #include "pmgdlib_factory.h"
 #include "pmgdlib_sdl.h"
+#include "pmgdlib_watch.h"
+#include "pmgdlib_scenes.h"
+
+#include <set>
 
 /*
 TARGET:
@@ -50,23 +54,9 @@ namespace pmgd {
   void proto_objects_into_map(std::shared_ptr<NdMap<ProtoObject>> ndmap, const std::vector<std::shared_ptr<ProtoObject>> proto_objects){
     for(int i = 0; i < proto_objects.size(); ++i){
       std::shared_ptr<ProtoObject> po = proto_objects.at(i);
-      
-      // make key
-      std::vector<const ConfigItem*> stack;
-      const ConfigItem* head = po->cfg_item;
-      while(head != nullptr){
-        stack.push_back(head);
-        head = head->father;
-      }
-
-      NdKey key;
-      for(int i = stack.size() - 1; i >= 0; --i){
-        const ConfigItem* cfg = stack[i];
 
-        if(i != stack.size()-1)
-          key.Add(cfg->type);
-        key.Add(cfg->Attribute("id", gen_uuid()));
-      }
+      // make key, same (type, id) path is used by diff_cfg() to reload configs
+      NdKey key = cfg_item_key(po->cfg_item);
 
       // add to tree
       ndmap->Add(key, po);
@@ -78,12 +68,26 @@ namespace pmgd {
     std::shared_ptr<Backend> backend = nullptr;
     std::shared_ptr<DataContainer> dc = std::make_shared<DataContainer>();
     std::shared_ptr<NdMap<ProtoObject>> ndmap = std::make_shared<NdMap<ProtoObject>>();
-    std::shared_ptr<ProtoObject> active_scene = nullptr, prev_scene = nullptr;
 
-    int LoadCfgData(std::shared_ptr<Config> cfg){
-      //! what objects load as ProtoObjects from cfg
-      std::vector<std::string> proto_objects_keys = {"texture", "shader", "scene", "chain", "frame_drawer", "pipeline", "drawer"};
+    //! warm objects with LRU cooling under sysopts.memory_budget
+    std::shared_ptr<ProtoCache> cache = nullptr;
+
+    //! active scene, prefetch & transitions
+    std::shared_ptr<SceneMachine> scenes = nullptr;
+
+    //! background reads, completion callbacks are called between frames
+    std::shared_ptr<IoQueue> io_queue = nullptr;
 
+    //! what objects load as ProtoObjects from cfg
+    std::vector<std::string> proto_objects_keys = {"texture", "shader", "scene", "chain", "frame_drawer", "pipeline", "drawer"};
+    std::vector<NdKey> namespaces = {NdKey({"default"}), NdKey("default")};
+
+    //! config files to reload on change, path -> config key, config key -> top file path
+    FileWatcher watcher;
+    std::map<std::string, std::string> cfg_paths;
+    std::map<std::string, std::string> cfg_files;
+
+    int LoadCfgData(std::shared_ptr<Config> cfg){
       //! step 1. load list of ProtoObjects 
       msg_debug("step 1. ...");
       ProtoLoader loader;
@@ -100,9 +104,7 @@ namespace pmgd {
         msg_debug("warm", quotec(item->cfg_item->type), "id =", quote(item->cfg_item->Attribute("id", "")));
       }
 
-      std::vector<NdKey> namespaces = {NdKey({"default"}), NdKey("default")};
-      ProtoBuilder pb(backend, ndmap);
-      pb.BuildObjects(namespaces, top_objects);
+      cache->WarmUp(top_objects);
 
       //! step 4. put scenes into container
 
@@ -118,12 +120,18 @@ namespace pmgd {
       sysopts = get_cfg_sys_options(cfg);
 
       msg_info("load IO/accel backends ...");
-      backend = get_backend(sysopts);
+      if(not backend) backend = get_backend(sysopts);
       if(not backend){
         msg_error("load IO/accel backends ... failed, return");
         return;
       }
 
+      cache = std::make_shared<ProtoCache>(std::make_shared<ProtoBuilder>(backend, ndmap), namespaces);
+      cache->SetBudget(size_t(sysopts.memory_budget) << 20);
+      scenes = std::make_shared<SceneMachine>(ndmap, cache, namespaces);
+      io_queue = std::make_shared<IoQueue>(backend);
+      for(auto & rule : get_cfg_scene_transitions(cfg)) scenes->AddRule(rule);
+
       /// load objects
       msg_info("load data from cfg ...");
       LoadCfgData(cfg);
@@ -145,6 +153,13 @@ namespace pmgd {
       msg_info("Main() ... done");
     }
 
+    //! use the given backend instead of one made from sys options, e.g. for tests & headless tools
+    Main(const std::string & cfg_raw, std::shared_ptr<Backend> backend_) : backend(backend_) {
+      msg_info("Main() ... start");
+      Setup(cfg_raw);
+      msg_info("Main() ... done");
+    }
+
     std::shared_ptr<Config> AddCfg(std::string key, const std::string & cfg_raw){
       msg_info("add config", quote(key));
       std::shared_ptr<Config> cfg = load_cfg(cfg_raw, key);
@@ -157,13 +172,203 @@ namespace pmgd {
       return cfg;
     }
 
+    //! add config from the file with all files it includes and load its objects
+    std::shared_ptr<Config> AddCfgFile(std::string key, const std::string & path){
+      msg_info("add config file", quote(path));
+      std::vector<std::string> paths;
+      std::shared_ptr<Config> cfg = load_cfg_file(path, key, backend->txt_imp, &paths);
+      if(cfg == nullptr){
+        msg_error("load_cfg_file returns nullptr");
+        return nullptr;
+      }
+      if(dc->Add(key, cfg) != PM_SUCCESS) return nullptr;
+      cfg_files[key] = path;
+      for(auto & file : paths) cfg_paths[FileWatcher::Normalize(file)] = key;
+      LoadCfgData(cfg);
+      return cfg;
+    }
+
+    //! reload config <key> when the file at <path> is changed
+    int WatchCfg(std::string key, const std::string & path){
+      cfg_paths[FileWatcher::Normalize(path)] = key;
+      return watcher.Add(path);
+    }
+
+    //! watch config <key> file and all files it includes
+    void WatchCfg(std::string key){
+      for(auto & it : cfg_paths)
+        if(it.second == key) watcher.Add(it.first);
+    }
+
+    //! reload changed watched configs, called every Loop() tick
+    void CheckReload(){
+      std::set<std::string> keys;
+      for(auto path : watcher.Poll()){
+        auto it = cfg_paths.find(path);
+        if(it == cfg_paths.end()) continue;
+        msg_info("config file changed", quote(path));
+
+        /// change in any included file reloads the whole include tree once
+        auto file = cfg_files.find(it->second);
+        if(file == cfg_files.end()){
+          TxtView txt = backend->ViewTxt(path);
+          Reload(it->second, load_cfg(txt.data, it->second));
+          continue;
+        }
+        if(keys.count(it->second)) continue;
+        keys.insert(it->second);
+
+        std::vector<std::string> paths;
+        Reload(it->second, load_cfg_file(file->second, it->second, backend->txt_imp, &paths));
+        for(auto & path : paths){
+          std::string normalized = FileWatcher::Normalize(path);
+          if(cfg_paths.count(normalized)) continue;
+          cfg_paths[normalized] = it->second;
+          watcher.Add(normalized);
+        }
+      }
+    }
+
+    //! replace config <key> by new data, ProtoObjects are rebuild only for changed subtrees and their dependents
+    int Reload(std::string key, const std::string & cfg_raw){
+      return Reload(key, load_cfg(cfg_raw, key));
+    }
+
+    int Reload(std::string key, std::shared_ptr<Config> cfg){
+      msg_info("reload config", quote(key), "...");
+      if(cfg == nullptr){
+        msg_error("load_cfg returns nullptr, keep old config");
+        return PM_ERROR;
+      }
+
+      std::shared_ptr<Config> old_cfg = dc->Get<Config>(key);
+      if(old_cfg == nullptr){
+        msg_warning("no config", quote(key), "to reload, add it");
+        return dc->Add(key, cfg);
+      }
+
+      std::vector<ConfigChange> changes;
+      diff_cfg(old_cfg.get(), cfg.get(), changes, true);
+
+      //! objects to cool down and build again
+      std::vector<std::shared_ptr<ProtoObject>> cooled;
+      std::set<ProtoObject*> cooled_set;
+      auto cool = [&](std::shared_ptr<ProtoObject> po){
+        if(po == nullptr or cooled_set.count(po.get())) return;
+        cooled_set.insert(po.get());
+        cooled.push_back(po);
+      };
+
+      //! changes of not-ProtoObject items (e.g. pipeline chains) are changes of their closest ProtoObject father
+      auto cool_father = [&](const ConfigItem* item){
+        for(const ConfigItem* head = item; head != nullptr; head = head->father){
+          std::shared_ptr<ProtoObject> po = ndmap->GetOne(cfg_item_key(head));
+          if(po == nullptr) continue;
+          cool(po);
+          return;
+        }
+      };
+
+      //! changed (type, id) pairs to find dependent objects
+      std::set<std::pair<std::string, std::string>> changed_ids;
+      int ret = PM_SUCCESS;
+      for(const ConfigChange & change : changes){
+        if(change.kind == cfg_change::SAME or change.kind == cfg_change::MODIFIED){
+          std::shared_ptr<ProtoObject> po = ndmap->GetOne(change.key);
+          if(po != nullptr) po->cfg_item = change.new_item;
+          if(change.kind == cfg_change::SAME) continue;
+
+          changed_ids.insert({change.new_item->type, change.new_item->Attribute("id")});
+          if(po != nullptr) cool(po);
+          else cool_father(change.new_item);
+          continue;
+        }
+
+        if(change.kind == cfg_change::REMOVED){
+          changed_ids.insert({change.old_item->type, change.old_item->Attribute("id")});
+          std::vector<const ConfigItem*> stack = {change.old_item};
+          while(stack.size()){
+            const ConfigItem* item = stack.back();
+            stack.pop_back();
+            std::shared_ptr<ProtoObject> po = ndmap->GetOne(cfg_item_key(item));
+            if(po != nullptr) cache->CoolDown(po);
+            ndmap->Remove(cfg_item_key(item));
+            for(auto group : item->nested) for(auto nested : group.second) stack.push_back(nested);
+          }
+          continue;
+        }
+
+        //! ADDED, validate and process new subtree with the same rules as in LoadCfgData()
+        changed_ids.insert({change.new_item->type, change.new_item->Attribute("id")});
+        ProtoLoader loader;
+        int retloc = loader.LoadSubtree(cfg, proto_objects_keys, change.new_item);
+        if(retloc != PM_SUCCESS) ret = retloc;
+        proto_objects_into_map(ndmap, loader.proto_objects);
+        for(auto po : loader.proto_objects) cool(po);
+        if(change.new_item->father) cool_father(change.new_item->father);
+      }
+
+      //! dependents - objects referring to changed ids as <type>="<id>" attribute, e.g. texture="t1"
+      std::vector<std::shared_ptr<ProtoObject>> all_objects = ndmap->All();
+      for(bool any = true; any; ){
+        any = false;
+        for(auto po : all_objects){
+          if(cooled_set.count(po.get())) continue;
+          for(auto attr : po->cfg_item->attributes){
+            if(not changed_ids.count({attr.first, attr.second})) continue;
+            cool(po);
+            changed_ids.insert({po->cfg_item->type, po->cfg_item->Attribute("id")});
+            any = true;
+            break;
+          }
+        }
+      }
+
+      //! build again objects which were warm, and new top level objects
+      std::vector<std::shared_ptr<ProtoObject>> to_build;
+      for(auto po : cooled){
+        bool top = cfg_item_key(po->cfg_item).size() == 3;
+        if(not po->IsWarm() and not top) continue;
+        cache->CoolDown(po);
+        to_build.push_back(po);
+      }
+      msg_debug("reload", changes.size(), "items compared,", cooled.size(), "objects changed,", to_build.size(), "to build");
+
+      int retbuild = cache->WarmUp(to_build);
+      if(retbuild != PM_SUCCESS) ret = retbuild;
+
+      dc->Replace(key, cfg);
+      msg_info("reload config", quote(key), "... done");
+      return ret;
+    }
+
+    //! ProtoObject by the full key of its config item, see cfg_item_key()
+    std::shared_ptr<ProtoObject> Proto(const NdKey & key){
+      return ndmap->GetOne(key);
+    }
+
+    //! object from the config by type & id, built on demand if it is cold
+    template<typename T> std::shared_ptr<T> Get(const std::string & type, const std::string & id){
+      std::shared_ptr<ProtoObject> po = ndmap->GetOne(namespaces, NdKey(type, id));
+      if(po == nullptr){
+        msg_warning("can't find", quotec(type), quote(id));
+        return nullptr;
+      }
+      return cache->Get<T>(po);
+    }
+
+    //! queue for asynchronous reads of assets outside of the config
+    std::shared_ptr<IoQueue> Queue(){ return io_queue; }
+
+    //! switch scene in the next frames, see SceneMachine
     void SetScene(std::string key){
       msg_info("set scene", quotec(key));
-      auto scene = ndmap->GetOne(NdKey({"*", "scene", key}));
-      if(not scene){
-        msg_warning("can't find scene, skip");
-        return;
-      }
+      if(scenes->Switch(key) != PM_SUCCESS) msg_warning("can't switch to scene", quote(key), "skip");
+    }
+
+    //! start building scene objects in background while the current scene is running
+    void PrefetchScene(std::string key){
+      scenes->Prefetch(key);
     }
 
     void Loop(){
@@ -174,6 +379,9 @@ namespace pmgd {
       int x = 0;
       bool on = true;
       while(on){
+        CheckReload();
+        io_queue->Poll();
+        scenes->Update();
         render->Draw();
         core->Tick();
 
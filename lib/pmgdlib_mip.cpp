@@ -0,0 +1,264 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "pmgdlib_mip.h"
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= mip chains ====================================================================
+  int mip_filter_from_string(const std::string & name){
+    if(name == "BOX") return mip_filter::BOX;
+    if(name == "KAISER") return mip_filter::KAISER;
+    return mip_filter::NONE;
+  }
+
+  int mip_levels(int w, int h){
+    int answer = 1;
+    for(; w > 1 or h > 1; ++answer){
+      w = std::max(1, w / 2);
+      h = std::max(1, h / 2);
+    }
+    return answer;
+  }
+
+  // ======= box filter ====================================================================
+  /// one row of dst from rows a & b of src, odd last column is repeated
+  static void box_row_scalar(const float * a, const float * b, float * out, int dst_w, int src_w, int x = 0){
+    for(; x < dst_w; ++x){
+      int x0 = 4 * 2 * x, x1 = 4 * std::min(2 * x + 1, src_w - 1);
+      for(int c = 0; c < 4; ++c) out[4 * x + c] = ((a[x0 + c] + a[x1 + c]) + (b[x0 + c] + b[x1 + c])) * 0.25f;
+    }
+  }
+
+  #ifdef PMGD_SIMD_X86
+    /// pixel is one register of 4 floats
+    PMGD_TARGET_SSE2 static void box_row_sse2(const float * a, const float * b, float * out, int dst_w, int src_w){
+      const __m128 k = _mm_set1_ps(0.25f);
+      int x = 0;
+      for(; 2 * x + 1 < src_w and x < dst_w; ++x){
+        __m128 sa = _mm_add_ps(_mm_loadu_ps(a + 8 * x), _mm_loadu_ps(a + 8 * x + 4));
+        __m128 sb = _mm_add_ps(_mm_loadu_ps(b + 8 * x), _mm_loadu_ps(b + 8 * x + 4));
+        _mm_storeu_ps(out + 4 * x, _mm_mul_ps(_mm_add_ps(sa, sb), k));
+      }
+      box_row_scalar(a, b, out, dst_w, src_w, x);
+    }
+
+    /// two pixels per register, pairs of source pixels are regrouped across lanes
+    PMGD_TARGET_AVX2 static void box_row_avx2(const float * a, const float * b, float * out, int dst_w, int src_w){
+      const __m256 k = _mm256_set1_ps(0.25f);
+      int x = 0;
+      for(; 2 * x + 3 < src_w and x + 1 < dst_w; x += 2){
+        __m256 a01 = _mm256_loadu_ps(a + 8 * x), a23 = _mm256_loadu_ps(a + 8 * x + 8);
+        __m256 b01 = _mm256_loadu_ps(b + 8 * x), b23 = _mm256_loadu_ps(b + 8 * x + 8);
+        __m256 sa = _mm256_add_ps(_mm256_permute2f128_ps(a01, a23, 0x20), _mm256_permute2f128_ps(a01, a23, 0x31));
+        __m256 sb = _mm256_add_ps(_mm256_permute2f128_ps(b01, b23, 0x20), _mm256_permute2f128_ps(b01, b23, 0x31));
+        _mm256_storeu_ps(out + 4 * x, _mm256_mul_ps(_mm256_add_ps(sa, sb), k));
+      }
+      box_row_scalar(a, b, out, dst_w, src_w, x);
+    }
+  #endif
+
+  static void box_row(const float * a, const float * b, float * out, int dst_w, int src_w){
+    #ifdef PMGD_SIMD_X86
+      int level = simd_get_level();
+      if(level >= simd_level::AVX2) return box_row_avx2(a, b, out, dst_w, src_w);
+      if(level >= simd_level::SSE2) return box_row_sse2(a, b, out, dst_w, src_w);
+    #endif
+    box_row_scalar(a, b, out, dst_w, src_w);
+  }
+
+  // ======= Kaiser filter ====================================================================
+  /// dst pixel x is centered between src pixels 2x and 2x + 1, taps are src pixels 2x - 3 ... 2x + 4
+  static const int KAISER_TAPS = 8;
+  static const int KAISER_FIRST = -3;
+
+  static double bessel_i0(double x){
+    double answer = 1, term = 1;
+    for(int k = 1; k < 32; ++k){
+      term *= (x / (2 * k)) * (x / (2 * k));
+      answer += term;
+    }
+    return answer;
+  }
+
+  /// sinc windowed over 2 dst pixels with alpha = 4, normalized
+  static const float * kaiser_weights(){
+    static const std::vector<float> weights = [](){
+      const double width = 2, alpha = 4, pi = 3.14159265358979323846;
+      std::vector<float> answer(KAISER_TAPS);
+      double sum = 0;
+      for(int k = 0; k < KAISER_TAPS; ++k){
+        double t = (KAISER_FIRST + k - 0.5) / 2; /// distance in dst pixels
+        double sinc = std::sin(pi * t) / (pi * t);
+        double r = t / width;
+        double window = bessel_i0(alpha * std::sqrt(std::max(0., 1 - r * r))) / bessel_i0(alpha);
+        answer[k] = sinc * window;
+        sum += answer[k];
+      }
+      for(auto & w : answer) w /= sum;
+      return answer;
+    }();
+    return weights.data();
+  }
+
+  /// horizontal pass of one row
+  static void kaiser_row_scalar(const float * src, float * out, int dst_w, int src_w){
+    const float * w = kaiser_weights();
+    for(int x = 0; x < dst_w; ++x){
+      float acc[4] = {0, 0, 0, 0};
+      for(int k = 0; k < KAISER_TAPS; ++k){
+        const float * p = src + 4 * std::clamp(2 * x + KAISER_FIRST + k, 0, src_w - 1);
+        for(int c = 0; c < 4; ++c) acc[c] += w[k] * p[c];
+      }
+      for(int c = 0; c < 4; ++c) out[4 * x + c] = acc[c];
+    }
+  }
+
+  /// vertical pass, out = sum of weighted rows, n floats
+  static void kaiser_column_scalar(const float * const * rows, float * out, size_t n, size_t i = 0){
+    const float * w = kaiser_weights();
+    for(; i < n; ++i){
+      float acc = 0;
+      for(int k = 0; k < KAISER_TAPS; ++k) acc += w[k] * rows[k][i];
+      out[i] = acc;
+    }
+  }
+
+  #ifdef PMGD_SIMD_X86
+    PMGD_TARGET_SSE2 static void kaiser_row_sse2(const float * src, float * out, int dst_w, int src_w){
+      const float * w = kaiser_weights();
+      for(int x = 0; x < dst_w; ++x){
+        __m128 acc = _mm_setzero_ps();
+        for(int k = 0; k < KAISER_TAPS; ++k){
+          const float * p = src + 4 * std::clamp(2 * x + KAISER_FIRST + k, 0, src_w - 1);
+          acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p)));
+        }
+        _mm_storeu_ps(out + 4 * x, acc);
+      }
+    }
+
+    PMGD_TARGET_SSE2 static void kaiser_column_sse2(const float * const * rows, float * out, size_t n){
+      const float * w = kaiser_weights();
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128 acc = _mm_setzero_ps();
+        for(int k = 0; k < KAISER_TAPS; ++k) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(out + i, acc);
+      }
+      kaiser_column_scalar(rows, out, n, i);
+    }
+
+    PMGD_TARGET_AVX2 static void kaiser_column_avx2(const float * const * rows, float * out, size_t n){
+      const float * w = kaiser_weights();
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256 acc = _mm256_setzero_ps();
+        for(int k = 0; k < KAISER_TAPS; ++k) acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), _mm256_loadu_ps(rows[k] + i)));
+        _mm256_storeu_ps(out + i, acc);
+      }
+      kaiser_column_scalar(rows, out, n, i);
+    }
+  #endif
+
+  static void kaiser_row(const float * src, float * out, int dst_w, int src_w){
+    #ifdef PMGD_SIMD_X86
+      if(simd_get_level() >= simd_level::SSE2) return kaiser_row_sse2(src, out, dst_w, src_w);
+    #endif
+    kaiser_row_scalar(src, out, dst_w, src_w);
+  }
+
+  static void kaiser_column(const float * const * rows, float * out, size_t n){
+    #ifdef PMGD_SIMD_X86
+      int level = simd_get_level();
+      if(level >= simd_level::AVX2) return kaiser_column_avx2(rows, out, n);
+      if(level >= simd_level::SSE2) return kaiser_column_sse2(rows, out, n);
+    #endif
+    kaiser_column_scalar(rows, out, n);
+  }
+
+  // ======= mip chains ====================================================================
+  int mip_downsample(const ImageView & src, const ImageView & dst, int filter){
+    auto rgba32f = [](const ImageView & view){
+      return view.Valid() and view.format == image_format::RGBA and view.type == image_type::FLOAT and view.Packed();
+    };
+    if(not rgba32f(src) or not rgba32f(dst)) return PM_ERROR_INCORRECT_ARGUMENTS;
+    if(dst.w != std::max(1, src.w / 2) or dst.h != std::max(1, src.h / 2)) return PM_ERROR_INCORRECT_ARGUMENTS;
+
+    if(filter == mip_filter::BOX){
+      parallel_rows(0, dst.h, src.w * 2, [&](int y0, int y1){
+        for(int y = y0; y < y1; ++y){
+          const float * a = (const float*)src.Row(2 * y);
+          const float * b = (const float*)src.Row(std::min(2 * y + 1, src.h - 1));
+          box_row(a, b, (float*)dst.Row(y), dst.w, src.w);
+        }
+      });
+      return PM_SUCCESS;
+    }
+
+    if(filter == mip_filter::KAISER){
+      Image tmp(dst.w, src.h, image_format::RGBA, image_type::FLOAT);
+      ImageView half(tmp);
+      parallel_rows(0, src.h, src.w, [&](int y0, int y1){
+        for(int y = y0; y < y1; ++y) kaiser_row((const float*)src.Row(y), (float*)half.Row(y), dst.w, src.w);
+      });
+      parallel_rows(0, dst.h, dst.w * KAISER_TAPS, [&](int y0, int y1){
+        const float * rows[KAISER_TAPS];
+        for(int y = y0; y < y1; ++y){
+          for(int k = 0; k < KAISER_TAPS; ++k) rows[k] = (const float*)half.Row(std::clamp(2 * y + KAISER_FIRST + k, 0, src.h - 1));
+          kaiser_column(rows, (float*)dst.Row(y), size_t(dst.w) * 4);
+        }
+      });
+      return PM_SUCCESS;
+    }
+    return PM_ERROR_INCORRECT_ARGUMENTS;
+  }
+
+  int make_mips(std::shared_ptr<Image> img, int filter, bool srgb, int max_levels){
+    if(img == nullptr or img->data == nullptr or img->format != image_format::RGBA) return PM_ERROR_INCORRECT_ARGUMENTS;
+    bool u8 = img->type == image_type::UNSIGNED_CHAR;
+    if(not u8 and img->type != image_type::FLOAT) return PM_ERROR_INCORRECT_ARGUMENTS;
+    img->mips.clear();
+    if(filter == mip_filter::NONE) return PM_SUCCESS;
+    int n_levels = mip_levels(img->w, img->h);
+    if(max_levels > 0) n_levels = std::min(n_levels, max_levels);
+    if(n_levels < 2) return PM_SUCCESS;
+
+    /// linear premultiplied working level, levels are made from the float level above, not from rounded pixels
+    auto level = std::make_shared<Image>(img->w, img->h, image_format::RGBA, image_type::FLOAT);
+    int status = (u8 and srgb) ? srgb_to_linear(*img, *level) : convert_pixels(*img, *level);
+    if(status == PM_SUCCESS) status = premultiply_alpha(*level);
+    if(status != PM_SUCCESS) return status;
+
+    for(int i = 1; i < n_levels; ++i){
+      auto next = std::make_shared<Image>(std::max(1, level->w / 2), std::max(1, level->h / 2), image_format::RGBA, image_type::FLOAT);
+      status = mip_downsample(*level, *next, filter);
+      if(status != PM_SUCCESS) return status;
+
+      auto out = std::make_shared<Image>(next->w, next->h, image_format::RGBA, img->type);
+      ImageView src(*next), dst(*out);
+      parallel_rows(0, out->h, out->w, [&](int y0, int y1){
+        std::vector<float> row(size_t(src.w) * 4);
+        for(int y = y0; y < y1; ++y){
+          const float * p = (const float*)src.Row(y);
+          for(int x = 0; x < src.w; ++x){
+            float a = std::clamp(p[4 * x + 3], 0.f, 1.f);
+            float k = a > 0 ? 1.f / a : 0.f;
+            for(int c = 0; c < 3; ++c) row[4 * x + c] = std::max(0.f, p[4 * x + c] * k);
+            row[4 * x + 3] = a;
+          }
+          if(not u8) std::copy(row.begin(), row.end(), (float*)dst.Row(y));
+          else if(srgb) pixel_linear32f_to_srgb8(row.data(), dst.Row(y), src.w);
+          else pixel_rgba32f_to_rgba8(row.data(), dst.Row(y), src.w);
+        }
+      });
+      img->mips.push_back(out);
+      level = next;
+    }
+    return PM_SUCCESS;
+  }
+};
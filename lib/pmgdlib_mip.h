@@ -0,0 +1,36 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_MIP_HH
+#define PMGDLIB_MIP_HH 1
+
+#include <memory>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_image.h"
+
+namespace pmgd {
+  // ======= mip chains ====================================================================
+  namespace mip_filter {
+    enum {
+      NONE = -1,
+      BOX,     /// 2x2 average
+      KAISER   /// 8 taps Kaiser-windowed sinc, sharper minification
+    };
+  };
+
+  //! "BOX", "KAISER", anything else - NONE
+  int mip_filter_from_string(const std::string & name);
+
+  //! number of levels down to 1x1, level 0 included
+  int mip_levels(int w, int h);
+
+  //! next level of the chain: dst is max(1, w / 2) x max(1, h / 2) of src,
+  //! both views are RGBA32F, rows are filtered in parallel on thread_pool()
+  int mip_downsample(const ImageView & src, const ImageView & dst, int filter = mip_filter::BOX);
+
+  //! fill img->mips down to 1x1 or to max_levels levels in total (0 - all), the levels have format & type of img,
+  //! RGBA8 and RGBA32F images, filtering is done in linear float with color weighted by alpha so transparent pixels don't bleed,
+  //! srgb - 8 bit color is sRGB encoded
+  int make_mips(std::shared_ptr<Image> img, int filter = mip_filter::BOX, bool srgb = true, int max_levels = 0);
+};
+
+#endif
@@ -0,0 +1,227 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <filesystem>
+
+#include "pmgdlib_pack.h"
+
+namespace pmgd {
+  // ======= pack format ====================================================================
+  uint64_t pack_hash(std::string_view path){
+    return hash_fnv1a(path);
+  }
+
+  std::string pack_path(const std::string & path){
+    return std::filesystem::path(path).lexically_normal().generic_string();
+  }
+
+  // ======= PackArchive ====================================================================
+  PackArchive::PackArchive(const std::string & path){
+    file = std::make_shared<const MappedFile>(path);
+    if(not file->Valid()) return;
+
+    if(file->Size() < sizeof(PackHeader)){
+      msg_warning(quote(path), "is too small for a pack");
+      return;
+    }
+    header = reinterpret_cast<const PackHeader*>(file->Data());
+    if(memcmp(header->magic, PackHeader().magic, sizeof(header->magic)) or header->version != PackHeader().version){
+      msg_warning(quote(path), "is not a pack or has unsupported version");
+      return;
+    }
+
+    uint64_t index_end = sizeof(PackHeader) + uint64_t(header->n_entries) * sizeof(PackEntry);
+    if(index_end > file->Size() or header->names_offset < index_end or header->data_offset < header->names_offset or header->data_offset > file->Size()){
+      msg_warning(quote(path), "has broken index");
+      return;
+    }
+    entries = reinterpret_cast<const PackEntry*>(file->Data() + sizeof(PackHeader));
+
+    /// check once, so lookups don't need to
+    for(uint32_t i = 0; i < header->n_entries; ++i){
+      const PackEntry & entry = entries[i];
+      bool name_ok = header->names_offset + entry.name_offset + entry.name_size <= header->data_offset;
+      bool data_ok = entry.offset >= header->data_offset and entry.offset <= file->Size() and entry.size <= file->Size() - entry.offset;
+      if(not name_ok or not data_ok){
+        msg_warning(quote(path), "has broken entry", i);
+        return;
+      }
+    }
+
+    valid = true;
+    msg_debug("open pack", quote(path), "with", header->n_entries, "entries");
+  }
+
+  const PackEntry * PackArchive::Find(const std::string & path) const {
+    if(not valid) return nullptr;
+    std::string key = pack_path(path);
+    uint64_t hash = pack_hash(key);
+
+    const PackEntry * end = entries + header->n_entries;
+    const PackEntry * it = std::lower_bound(entries, end, hash, [](const PackEntry & entry, uint64_t h){ return entry.hash < h; });
+    for(; it != end and it->hash == hash; ++it)
+      if(Name(*it) == key) return it;
+    return nullptr;
+  }
+
+  std::string_view PackArchive::Name(const PackEntry & entry) const {
+    return std::string_view(file->Data() + header->names_offset + entry.name_offset, entry.name_size);
+  }
+
+  std::string_view PackArchive::Stored(const PackEntry & entry) const {
+    return std::string_view(file->Data() + entry.offset, entry.size);
+  }
+
+  TxtView PackArchive::Data(const PackEntry & entry) const {
+    if(entry.codec == pack_codec::RAW) return TxtView{Stored(entry), file};
+    if(entry.codec == pack_codec::LZ){
+      auto answer = std::make_shared<std::string>();
+      /// stream header is checked before the output is allocated
+      if(lz_raw_size(Stored(entry)) != int64_t(entry.raw_size) or lz_decompress(Stored(entry), *answer) != PM_SUCCESS){
+        msg_warning("broken data of", quote(std::string(Name(entry))));
+        return TxtView();
+      }
+      return TxtView{*answer, answer};
+    }
+    msg_warning("unknown codec", entry.codec, "of", quote(std::string(Name(entry))));
+    return TxtView();
+  }
+
+  std::vector<std::string> PackArchive::Paths() const {
+    std::vector<std::string> answer;
+    for(int i = 0; i < Size(); ++i) answer.emplace_back(Name(entries[i]));
+    return answer;
+  }
+
+  // ======= PackBuilder ====================================================================
+  int PackBuilder::Add(const std::string & path, std::string data, int codec){
+    std::string key = pack_path(path);
+    for(auto & item : items){
+      if(item.path != key) continue;
+      msg_warning("path", quote(key), "is already in the pack");
+      return PM_ERROR_DUPLICATE;
+    }
+
+    Item item;
+    item.path = key;
+    item.raw_size = data.size();
+    if(codec == pack_codec::LZ){
+      std::string compressed = lz_compress(data);
+      if(compressed.size() < data.size()){
+        item.codec = pack_codec::LZ;
+        data = std::move(compressed);
+      }
+    }
+    item.data = std::move(data);
+    items.push_back(std::move(item));
+    return PM_SUCCESS;
+  }
+
+  int PackBuilder::AddFile(const std::string & pack_path, const std::string & file_path, int codec){
+    std::ifstream file(file_path, std::ios::binary);
+    if(not file){
+      msg_warning("can't open", quote(file_path));
+      return PM_ERROR_IO;
+    }
+    return Add(pack_path, std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()), codec);
+  }
+
+  int PackBuilder::Write(const std::string & out_path){
+    std::vector<const Item*> order;
+    for(auto & item : items) order.push_back(&item);
+    std::sort(order.begin(), order.end(), [](const Item* a, const Item* b){
+      uint64_t ha = pack_hash(a->path), hb = pack_hash(b->path);
+      return ha != hb ? ha < hb : a->path < b->path;
+    });
+
+    PackHeader header;
+    header.n_entries = order.size();
+    header.names_offset = sizeof(PackHeader) + order.size() * sizeof(PackEntry);
+
+    std::string names;
+    std::vector<PackEntry> entries(order.size());
+    for(int i = 0; i < order.size(); ++i){
+      entries[i].hash = pack_hash(order[i]->path);
+      entries[i].name_offset = names.size();
+      entries[i].name_size = order[i]->path.size();
+      names += order[i]->path;
+    }
+
+    auto align = [](uint64_t x){ return (x + 15) & ~uint64_t(15); };
+    header.data_offset = align(header.names_offset + names.size());
+    uint64_t offset = header.data_offset;
+    for(int i = 0; i < order.size(); ++i){
+      entries[i].offset = offset;
+      entries[i].size = order[i]->data.size();
+      entries[i].raw_size = order[i]->raw_size;
+      entries[i].codec = order[i]->codec;
+      offset = align(offset + entries[i].size);
+    }
+
+    std::ofstream out(out_path, std::ios::binary | std::ios::trunc);
+    if(not out){
+      msg_warning("can't open", quote(out_path), "for writing");
+      return PM_ERROR_IO;
+    }
+
+    const char zeros[16] = {};
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+    out.write(names.data(), names.size());
+    out.write(zeros, header.data_offset - header.names_offset - names.size());
+    for(int i = 0; i < order.size(); ++i){
+      out.write(order[i]->data.data(), order[i]->data.size());
+      out.write(zeros, align(entries[i].size) - entries[i].size);
+    }
+    if(not out){
+      msg_warning("failed to write", quote(out_path));
+      return PM_ERROR_IO;
+    }
+    msg_debug("write pack", quote(out_path), "with", order.size(), "entries,", offset, "bytes");
+    return PM_SUCCESS;
+  }
+
+  // ======= pack backends ====================================================================
+  TxtView IoTxtPack::View(const std::string & path){
+    const PackEntry * entry = pack->Find(path);
+    if(entry) return pack->Data(*entry);
+    if(fallback) return fallback->View(path);
+    msg_warning("path", quote(path), "is not in the pack");
+    return TxtView();
+  }
+
+  std::string IoTxtPack::Read(const std::string & path){
+    return View(path).Str();
+  }
+
+  int IoTxtPack::Write(const std::string & path, const std::string & data){
+    if(fallback) return fallback->Write(path, data);
+    msg_warning("pack is read-only, can't write", quote(path));
+    return PM_ERROR_IO;
+  }
+
+  #ifdef USE_STB
+    std::shared_ptr<Image> IoImagePack::Read(const std::string & path){
+      const PackEntry * entry = pack->Find(path);
+      if(entry == nullptr){
+        if(fallback) return fallback->Read(path);
+        msg_warning("image", quote(path), "is not in the pack");
+        return nullptr;
+      }
+
+      TxtView raw = pack->Data(*entry);
+      std::shared_ptr<Image> answer = decode_image_stb(raw.data.data(), raw.data.size());
+      if(answer == nullptr) msg_warning("failed to decode", quote(path));
+      return answer;
+    }
+
+    int IoImagePack::Write(const std::string & path, std::shared_ptr<Image> image){
+      if(fallback) return fallback->Write(path, image);
+      msg_warning("pack is read-only, can't write", quote(path));
+      return PM_ERROR_IO;
+    }
+  #endif
+};
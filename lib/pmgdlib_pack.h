@@ -0,0 +1,130 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_PACK_HH
+#define PMGDLIB_PACK_HH 1
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_core.h"
+#include "pmgdlib_io.h"
+#include "pmgdlib_image.h"
+#include "pmgdlib_lz.h"
+
+namespace pmgd {
+  // ======= pack format ====================================================================
+  //! one file with all assets, little-endian:
+  //!   PackHeader
+  //!   PackEntry[n_entries] sorted by path hash
+  //!   names - paths of entries without separators
+  //!   data  - entries data, every entry is aligned to 16 bytes
+  namespace pack_codec {
+    enum {
+      RAW = 0,
+      LZ        /// lz_compress() stream, decoded in parallel per block
+    };
+  };
+
+  struct PackHeader {
+    char magic[8] = {'P', 'M', 'G', 'D', 'P', 'A', 'C', 'K'};
+    uint32_t version = 1;
+    uint32_t n_entries = 0;
+    uint64_t names_offset = 0;
+    uint64_t data_offset = 0;
+  };
+
+  struct PackEntry {
+    uint64_t hash = 0;
+    uint64_t offset = 0;   /// from the start of the file
+    uint64_t size = 0;     /// stored bytes
+    uint64_t raw_size = 0; /// bytes after decoding
+    uint32_t codec = pack_codec::RAW;
+    uint32_t name_offset = 0;
+    uint32_t name_size = 0;
+    uint32_t reserved = 0;
+  };
+
+  //! FNV-1a of the normalized path
+  uint64_t pack_hash(std::string_view path);
+
+  //! lexically normal path with '/' separators, the key of entries
+  std::string pack_path(const std::string & path);
+
+  // ======= PackArchive ====================================================================
+  //! read-only archive served from one memory-mapped file
+  class PackArchive : public BaseMsg {
+    std::shared_ptr<const MappedFile> file;
+    const PackHeader * header = nullptr;
+    const PackEntry * entries = nullptr;
+    bool valid = false;
+
+    public:
+    PackArchive(const std::string & path);
+
+    bool Valid() const { return valid; }
+    int Size() const { return valid ? header->n_entries : 0; }
+
+    //! entry by path or nullptr
+    const PackEntry * Find(const std::string & path) const;
+    std::string_view Name(const PackEntry & entry) const;
+    //! stored bytes of the entry
+    std::string_view Stored(const PackEntry & entry) const;
+    //! decoded entry data, RAW entries are views into the mapping without copies, LZ entries own decoded copy, empty on error
+    TxtView Data(const PackEntry & entry) const;
+
+    std::vector<std::string> Paths() const;
+  };
+
+  // ======= PackBuilder ====================================================================
+  //! collect files in memory and write the archive
+  class PackBuilder : public BaseMsg {
+    struct Item {
+      std::string path;
+      std::string data;
+      uint32_t codec = pack_codec::RAW;
+      uint64_t raw_size = 0;
+    };
+    std::vector<Item> items;
+
+    public:
+    //! PM_ERROR_DUPLICATE if the path is already added, LZ data is stored as RAW if it does not compress
+    int Add(const std::string & path, std::string data, int codec = pack_codec::RAW);
+    //! read file from disk and store it as pack_path
+    int AddFile(const std::string & pack_path, const std::string & file_path, int codec = pack_codec::RAW);
+    int Size() const { return items.size(); }
+    int Write(const std::string & out_path);
+  };
+
+  // ======= pack backends ====================================================================
+  //! text IO from the archive, paths missing in the archive are passed to fallback if it is set
+  class IoTxtPack : public IoTxt, public BaseMsg {
+    std::shared_ptr<PackArchive> pack;
+    std::shared_ptr<IoTxt> fallback;
+
+    public:
+    IoTxtPack(std::shared_ptr<PackArchive> pack_, std::shared_ptr<IoTxt> fallback_ = nullptr) : pack(pack_), fallback(fallback_) {}
+    virtual std::string Read(const std::string & path);
+    virtual TxtView View(const std::string & path);
+    //! archive is read-only, writes go to fallback
+    virtual int Write(const std::string & path, const std::string & data);
+  };
+
+  #ifdef USE_STB
+    //! images decoded from the archive
+    class IoImagePack : public IoImage {
+      std::shared_ptr<PackArchive> pack;
+      std::shared_ptr<IoImage> fallback;
+
+      public:
+      IoImagePack(std::shared_ptr<PackArchive> pack_, std::shared_ptr<IoImage> fallback_ = nullptr) : pack(pack_), fallback(fallback_) {}
+      virtual std::shared_ptr<Image> Read(const std::string & path);
+      virtual int Write(const std::string & path, std::shared_ptr<Image> image);
+    };
+  #endif
+};
+
+#endif
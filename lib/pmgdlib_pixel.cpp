@@ -0,0 +1,398 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "pmgdlib_pixel.h"
+
+namespace pmgd {
+  // ======= scalar kernels ====================================================================
+  static inline float pixel_clamp01(float v){ return v > 0.f ? (v < 1.f ? v : 1.f) : 0.f; } /// NaN -> 0
+
+  /// round to nearest even for x in [0, 2^22] like cvtps2dq does, std::nearbyint is a libm call in scalar loops
+  static inline int pixel_round(float x){
+    const float magic = 12582912.f; /// 1.5 * 2^23, not folded without -ffast-math
+    return int((x + magic) - magic);
+  }
+
+  /// round(x / 255) for x in [0, 255 * 255]
+  static inline uint32_t pixel_div255(uint32_t x){
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+  }
+
+  static void rgba8_to_rgba32f_scalar(const uint8_t * src, float * dst, size_t n){
+    const float k = 1.f / 255.f;
+    for(size_t i = 0; i < n * 4; ++i) dst[i] = src[i] * k;
+  }
+
+  static void rgba32f_to_rgba8_scalar(const float * src, uint8_t * dst, size_t n){
+    for(size_t i = 0; i < n * 4; ++i) dst[i] = pixel_round(pixel_clamp01(src[i]) * 255.f);
+  }
+
+  static void rgb8_to_rgba8_scalar(const uint8_t * src, uint8_t * dst, size_t n){
+    for(size_t i = 0; i < n; ++i, src += 3, dst += 4){
+      dst[0] = src[0];
+      dst[1] = src[1];
+      dst[2] = src[2];
+      dst[3] = 255;
+    }
+  }
+
+  static void swap_rb8_scalar(const uint8_t * src, uint8_t * dst, size_t n){
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      uint8_t r = src[0], b = src[2];
+      dst[0] = b;
+      dst[1] = src[1];
+      dst[2] = r;
+      dst[3] = src[3];
+    }
+  }
+
+  static void premultiply8_scalar(const uint8_t * src, uint8_t * dst, size_t n){
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      uint32_t a = src[3];
+      dst[0] = pixel_div255(src[0] * a);
+      dst[1] = pixel_div255(src[1] * a);
+      dst[2] = pixel_div255(src[2] * a);
+      dst[3] = a;
+    }
+  }
+
+  #ifdef PMGD_SIMD_X86
+    // ======= SSE2 kernels ====================================================================
+    PMGD_TARGET_SSE2 static void rgba8_to_rgba32f_sse2(const uint8_t * src, float * dst, size_t n){
+      const __m128 k = _mm_set1_ps(1.f / 255.f);
+      const __m128i zero = _mm_setzero_si128();
+      size_t i = 0, m = n * 4;
+      for(; i + 16 <= m; i += 16){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(dst + i,      _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), k));
+        _mm_storeu_ps(dst + i + 4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), k));
+        _mm_storeu_ps(dst + i + 8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), k));
+        _mm_storeu_ps(dst + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), k));
+      }
+      rgba8_to_rgba32f_scalar(src + i, dst + i, (m - i) / 4);
+    }
+
+    PMGD_TARGET_SSE2 static inline __m128i rgba32f_to_i32_sse2(const float * src){
+      const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f), k = _mm_set1_ps(255.f);
+      __m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src), zero), one); /// max(NaN, 0) = 0
+      return _mm_cvtps_epi32(_mm_mul_ps(v, k));
+    }
+
+    PMGD_TARGET_SSE2 static void rgba32f_to_rgba8_sse2(const float * src, uint8_t * dst, size_t n){
+      size_t i = 0, m = n * 4;
+      for(; i + 16 <= m; i += 16){
+        __m128i ab = _mm_packs_epi32(rgba32f_to_i32_sse2(src + i), rgba32f_to_i32_sse2(src + i + 4));
+        __m128i cd = _mm_packs_epi32(rgba32f_to_i32_sse2(src + i + 8), rgba32f_to_i32_sse2(src + i + 12));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(ab, cd));
+      }
+      rgba32f_to_rgba8_scalar(src + i, dst + i, (m - i) / 4);
+    }
+
+    PMGD_TARGET_SSE2 static void swap_rb8_sse2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m128i ga = _mm_set1_epi32(0xFF00FF00);
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        __m128i rb = _mm_andnot_si128(ga, v);
+        rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_or_si128(_mm_and_si128(v, ga), rb));
+      }
+      swap_rb8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    /// two pixels of 16 bit channels, alpha is multiplied by 255 so it stays the same
+    PMGD_TARGET_SSE2 static inline __m128i premultiply16_sse2(__m128i v){
+      const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+      __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a), _mm_and_si128(alpha_lanes, _mm_set1_epi16(255)));
+      __m128i x = _mm_add_epi16(_mm_mullo_epi16(v, a), _mm_set1_epi16(128));
+      return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+    }
+
+    PMGD_TARGET_SSE2 static void premultiply8_sse2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m128i zero = _mm_setzero_si128();
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 4));
+        __m128i lo = premultiply16_sse2(_mm_unpacklo_epi8(v, zero));
+        __m128i hi = premultiply16_sse2(_mm_unpackhi_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(dst + i * 4), _mm_packus_epi16(lo, hi));
+      }
+      premultiply8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    // ======= AVX2 kernels ====================================================================
+    PMGD_TARGET_AVX2 static void rgba8_to_rgba32f_avx2(const uint8_t * src, float * dst, size_t n){
+      const __m256 k = _mm256_set1_ps(1.f / 255.f);
+      size_t i = 0, m = n * 4;
+      for(; i + 32 <= m; i += 32){
+        for(int j = 0; j < 32; j += 8){
+          __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src + i + j)));
+          _mm256_storeu_ps(dst + i + j, _mm256_mul_ps(_mm256_cvtepi32_ps(v), k));
+        }
+      }
+      rgba8_to_rgba32f_scalar(src + i, dst + i, (m - i) / 4);
+    }
+
+    PMGD_TARGET_AVX2 static inline __m256i rgba32f_to_i32_avx2(const float * src){
+      const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f), k = _mm256_set1_ps(255.f);
+      __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(src), zero), one);
+      return _mm256_cvtps_epi32(_mm256_mul_ps(v, k));
+    }
+
+    PMGD_TARGET_AVX2 static void rgba32f_to_rgba8_avx2(const float * src, uint8_t * dst, size_t n){
+      /// packs work inside 128 bit lanes, the permutation puts 4 byte groups back in order
+      const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+      size_t i = 0, m = n * 4;
+      for(; i + 32 <= m; i += 32){
+        __m256i ab = _mm256_packs_epi32(rgba32f_to_i32_avx2(src + i), rgba32f_to_i32_avx2(src + i + 8));
+        __m256i cd = _mm256_packs_epi32(rgba32f_to_i32_avx2(src + i + 16), rgba32f_to_i32_avx2(src + i + 24));
+        __m256i v = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(ab, cd), order);
+        _mm256_storeu_si256((__m256i*)(dst + i), v);
+      }
+      rgba32f_to_rgba8_scalar(src + i, dst + i, (m - i) / 4);
+    }
+
+    PMGD_TARGET_AVX2 static void rgb8_to_rgba8_avx2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m256i shuffle = _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                                               0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+      const __m256i alpha = _mm256_set1_epi32(0xFF000000);
+      size_t i = 0;
+      /// 8 pixels from two 16 byte loads at 0 and 12, the second load reads 4 bytes past the pixels
+      for(; (i + 8) * 3 + 4 <= n * 3; i += 8){
+        __m128i lo = _mm_loadu_si128((const __m128i*)(src + i * 3));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(src + i * 3 + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), v);
+      }
+      rgb8_to_rgba8_scalar(src + i * 3, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_AVX2 static void swap_rb8_avx2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                               2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_shuffle_epi8(v, shuffle));
+      }
+      swap_rb8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+
+    PMGD_TARGET_AVX2 static inline __m256i premultiply16_avx2(__m256i v){
+      const __m256i alpha_lanes = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+      __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm256_blendv_epi8(a, _mm256_set1_epi16(255), alpha_lanes);
+      __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(v, a), _mm256_set1_epi16(128));
+      return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+    }
+
+    PMGD_TARGET_AVX2 static void premultiply8_avx2(const uint8_t * src, uint8_t * dst, size_t n){
+      const __m256i zero = _mm256_setzero_si256();
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + i * 4));
+        __m256i lo = premultiply16_avx2(_mm256_unpacklo_epi8(v, zero));
+        __m256i hi = premultiply16_avx2(_mm256_unpackhi_epi8(v, zero));
+        _mm256_storeu_si256((__m256i*)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+      }
+      premultiply8_scalar(src + i * 4, dst + i * 4, n - i);
+    }
+  #endif
+
+  // ======= CPU dispatch ====================================================================
+  struct PixelKernels {
+    void (*rgba8_to_rgba32f)(const uint8_t*, float*, size_t);
+    void (*rgba32f_to_rgba8)(const float*, uint8_t*, size_t);
+    void (*rgb8_to_rgba8)(const uint8_t*, uint8_t*, size_t);
+    void (*swap_rb8)(const uint8_t*, uint8_t*, size_t);
+    void (*premultiply8)(const uint8_t*, uint8_t*, size_t);
+  };
+
+  /// SSE2 has no byte shuffles, RGB expansion stays scalar there
+  static const PixelKernels pixel_kernels[] = {
+    {rgba8_to_rgba32f_scalar, rgba32f_to_rgba8_scalar, rgb8_to_rgba8_scalar, swap_rb8_scalar, premultiply8_scalar},
+    #ifdef PMGD_SIMD_X86
+    {rgba8_to_rgba32f_sse2, rgba32f_to_rgba8_sse2, rgb8_to_rgba8_scalar, swap_rb8_sse2, premultiply8_sse2},
+    {rgba8_to_rgba32f_avx2, rgba32f_to_rgba8_avx2, rgb8_to_rgba8_avx2, swap_rb8_avx2, premultiply8_avx2},
+    #endif
+  };
+
+  int simd_detect(){
+    #ifdef PMGD_SIMD_X86
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx2")) return simd_level::AVX2;
+      if(__builtin_cpu_supports("sse2")) return simd_level::SSE2;
+    #endif
+    return simd_level::SCALAR;
+  }
+
+  static std::atomic<int> & simd_current(){
+    static std::atomic<int> level = simd_detect();
+    return level;
+  }
+
+  int simd_get_level(){
+    return simd_current();
+  }
+
+  int simd_set_level(int level){
+    level = std::clamp(level, int(simd_level::SCALAR), simd_detect());
+    simd_current() = level;
+    return level;
+  }
+
+  const char * simd_level_name(int level){
+    if(level == simd_level::AVX2) return "AVX2";
+    if(level == simd_level::SSE2) return "SSE2";
+    return "SCALAR";
+  }
+
+  static inline const PixelKernels & kernels(){
+    return pixel_kernels[simd_get_level()];
+  }
+
+  // ======= row kernels ====================================================================
+  void pixel_rgba8_to_rgba32f(const uint8_t * src, float * dst, size_t n){ kernels().rgba8_to_rgba32f(src, dst, n); }
+  void pixel_rgba32f_to_rgba8(const float * src, uint8_t * dst, size_t n){ kernels().rgba32f_to_rgba8(src, dst, n); }
+  void pixel_rgb8_to_rgba8(const uint8_t * src, uint8_t * dst, size_t n){ kernels().rgb8_to_rgba8(src, dst, n); }
+  void pixel_swap_rb8(const uint8_t * src, uint8_t * dst, size_t n){ kernels().swap_rb8(src, dst, n); }
+  void pixel_premultiply8(const uint8_t * src, uint8_t * dst, size_t n){ kernels().premultiply8(src, dst, n); }
+
+  void pixel_premultiply32f(const float * src, float * dst, size_t n){
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      float a = src[3];
+      dst[0] = src[0] * a;
+      dst[1] = src[1] * a;
+      dst[2] = src[2] * a;
+      dst[3] = a;
+    }
+  }
+
+  /// 8 bit sRGB -> linear float, every value
+  static const float * srgb_to_linear_lut(){
+    static const std::vector<float> lut = [](){
+      std::vector<float> answer(256);
+      for(int i = 0; i < 256; ++i){
+        float c = i / 255.f;
+        answer[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+      }
+      return answer;
+    }();
+    return lut.data();
+  }
+
+  /// linear float -> 8 bit sRGB, 1 / 2^14 steps keep 8 bit values exact after the round trip
+  static const int SRGB_LUT_BITS = 14;
+  static const uint8_t * linear_to_srgb_lut(){
+    static const std::vector<uint8_t> lut = [](){
+      int n = 1 << SRGB_LUT_BITS;
+      std::vector<uint8_t> answer(n + 1);
+      for(int i = 0; i <= n; ++i){
+        float c = float(i) / n;
+        c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.f / 2.4f) - 0.055f;
+        answer[i] = (uint8_t)std::nearbyint(pixel_clamp01(c) * 255.f);
+      }
+      return answer;
+    }();
+    return lut.data();
+  }
+
+  void pixel_srgb8_to_linear32f(const uint8_t * src, float * dst, size_t n){
+    const float * lut = srgb_to_linear_lut();
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      dst[0] = lut[src[0]];
+      dst[1] = lut[src[1]];
+      dst[2] = lut[src[2]];
+      dst[3] = src[3] * (1.f / 255.f);
+    }
+  }
+
+  void pixel_linear32f_to_srgb8(const float * src, uint8_t * dst, size_t n){
+    const uint8_t * lut = linear_to_srgb_lut();
+    const float k = float(1 << SRGB_LUT_BITS);
+    for(size_t i = 0; i < n; ++i, src += 4, dst += 4){
+      dst[0] = lut[pixel_round(pixel_clamp01(src[0]) * k)];
+      dst[1] = lut[pixel_round(pixel_clamp01(src[1]) * k)];
+      dst[2] = lut[pixel_round(pixel_clamp01(src[2]) * k)];
+      dst[3] = pixel_round(pixel_clamp01(src[3]) * 255.f);
+    }
+  }
+
+  // ======= image conversions ====================================================================
+  static bool is_pixel_format(const ImageView & view, int format, int type){
+    return view.format == format and view.type == type and view.Packed();
+  }
+
+  /// fn(src_row, dst_row) for every row of the views of the same size
+  template<typename F> static int for_rows(const ImageView & src, const ImageView & dst, F fn){
+    if(not src.Valid() or not dst.Valid() or src.w != dst.w or src.h != dst.h) return PM_ERROR_INCORRECT_ARGUMENTS;
+    for(int y = 0; y < src.h; ++y) fn(src.Row(y), dst.Row(y));
+    return PM_SUCCESS;
+  }
+
+  int convert_pixels(const ImageView & src, const ImageView & dst){
+    using namespace image_format;
+    const int U8 = image_type::UNSIGNED_CHAR, F32 = image_type::FLOAT;
+    size_t n = src.w;
+
+    if(src.format == dst.format and src.type == dst.type and src.channels == dst.channels and src.Packed() and dst.Packed()){
+      size_t row = n * src.PixelBytes();
+      return for_rows(src, dst, [row](uint8_t * s, uint8_t * d){ memmove(d, s, row); });
+    }
+    if(is_pixel_format(src, RGBA, U8) and is_pixel_format(dst, RGBA, F32))
+      return for_rows(src, dst, [n](uint8_t * s, uint8_t * d){ pixel_rgba8_to_rgba32f(s, (float*)d, n); });
+    if(is_pixel_format(src, RGBA, F32) and is_pixel_format(dst, RGBA, U8))
+      return for_rows(src, dst, [n](uint8_t * s, uint8_t * d){ pixel_rgba32f_to_rgba8((const float*)s, d, n); });
+    if(is_pixel_format(src, RGB, U8) and (is_pixel_format(dst, RGBA, U8) or is_pixel_format(dst, BGRA, U8))){
+      bool swap = dst.format == BGRA;
+      return for_rows(src, dst, [n, swap](uint8_t * s, uint8_t * d){
+        pixel_rgb8_to_rgba8(s, d, n);
+        if(swap) pixel_swap_rb8(d, d, n);
+      });
+    }
+    bool rgba_bgra = is_pixel_format(src, RGBA, U8) and is_pixel_format(dst, BGRA, U8);
+    bool bgra_rgba = is_pixel_format(src, BGRA, U8) and is_pixel_format(dst, RGBA, U8);
+    if(rgba_bgra or bgra_rgba)
+      return for_rows(src, dst, [n](uint8_t * s, uint8_t * d){ pixel_swap_rb8(s, d, n); });
+    return PM_ERROR_INCORRECT_ARGUMENTS;
+  }
+
+  std::shared_ptr<Image> convert_image(const ImageView & src, int format, int type){
+    auto answer = std::make_shared<Image>(src.w, src.h, format, type);
+    if(convert_pixels(src, ImageView(*answer)) != PM_SUCCESS) return nullptr;
+    return answer;
+  }
+
+  int premultiply_alpha(const ImageView & img){
+    bool u8 = img.type == image_type::UNSIGNED_CHAR and (img.format == image_format::RGBA or img.format == image_format::BGRA);
+    bool f32 = img.type == image_type::FLOAT and img.format == image_format::RGBA;
+    if(not img.Packed() or not (u8 or f32)) return PM_ERROR_INCORRECT_ARGUMENTS;
+    size_t n = img.w;
+    if(u8) return for_rows(img, img, [n](uint8_t * s, uint8_t * d){ pixel_premultiply8(s, d, n); });
+    return for_rows(img, img, [n](uint8_t * s, uint8_t * d){ pixel_premultiply32f((const float*)s, (float*)d, n); });
+  }
+
+  int srgb_to_linear(const ImageView & src, const ImageView & dst){
+    if(not is_pixel_format(src, image_format::RGBA, image_type::UNSIGNED_CHAR) or not is_pixel_format(dst, image_format::RGBA, image_type::FLOAT))
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    size_t n = src.w;
+    return for_rows(src, dst, [n](uint8_t * s, uint8_t * d){ pixel_srgb8_to_linear32f(s, (float*)d, n); });
+  }
+
+  int linear_to_srgb(const ImageView & src, const ImageView & dst){
+    if(not is_pixel_format(src, image_format::RGBA, image_type::FLOAT) or not is_pixel_format(dst, image_format::RGBA, image_type::UNSIGNED_CHAR))
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    size_t n = src.w;
+    return for_rows(src, dst, [n](uint8_t * s, uint8_t * d){ pixel_linear32f_to_srgb8((const float*)s, d, n); });
+  }
+};
@@ -0,0 +1,72 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_PIXEL_HH
+#define PMGDLIB_PIXEL_HH 1
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_image.h"
+
+/// kernels for x86 are compiled with target attributes, PMGD_SIMD_X86 is not defined on other platforms
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define PMGD_SIMD_X86 1
+  #include <immintrin.h>
+  #define PMGD_TARGET_SSE2 __attribute__((target("sse2")))
+  #define PMGD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace pmgd {
+  // ======= CPU dispatch ====================================================================
+  //! kernels are compiled for every level with target attributes and selected at runtime,
+  //! so the library is built for the baseline CPU and still uses AVX2 where it is available
+  namespace simd_level {
+    enum {
+      SCALAR = 0,
+      SSE2,
+      AVX2
+    };
+  };
+
+  //! best level supported by the CPU
+  int simd_detect();
+  //! level used by the kernels, simd_detect() until changed
+  int simd_get_level();
+  //! use lower level, e.g. to compare kernels in tests & benchmarks, clamped to simd_detect(), return the level set
+  int simd_set_level(int level);
+  const char * simd_level_name(int level);
+
+  // ======= row kernels ====================================================================
+  //! n is the number of pixels, 8 bit values are [0, 255], float values are [0, 1]
+  void pixel_rgba8_to_rgba32f(const uint8_t * src, float * dst, size_t n);
+  //! clamped to [0, 1] and rounded to nearest
+  void pixel_rgba32f_to_rgba8(const float * src, uint8_t * dst, size_t n);
+  //! alpha = 255
+  void pixel_rgb8_to_rgba8(const uint8_t * src, uint8_t * dst, size_t n);
+  //! RGBA <-> BGRA, src == dst is allowed
+  void pixel_swap_rb8(const uint8_t * src, uint8_t * dst, size_t n);
+  //! color * alpha rounded to nearest, src == dst is allowed
+  void pixel_premultiply8(const uint8_t * src, uint8_t * dst, size_t n);
+  void pixel_premultiply32f(const float * src, float * dst, size_t n);
+  //! color through lookup tables, alpha is linear in both
+  void pixel_srgb8_to_linear32f(const uint8_t * src, float * dst, size_t n);
+  void pixel_linear32f_to_srgb8(const float * src, uint8_t * dst, size_t n);
+
+  // ======= image conversions ====================================================================
+  //! convert src into dst of the same size, row by row so padded and vertically flipped views work,
+  //! supported: RGBA8 <-> RGBA32F, RGB8 -> RGBA8, RGBA8 <-> BGRA8 and copies of the same format & type,
+  //! PM_ERROR_INCORRECT_ARGUMENTS for other pairs and views with gaps between pixels
+  int convert_pixels(const ImageView & src, const ImageView & dst);
+  //! converted copy in pooled storage, nullptr if the conversion is not supported
+  std::shared_ptr<Image> convert_image(const ImageView & src, int format, int type = image_type::UNSIGNED_CHAR);
+
+  //! color * alpha in place, 8 bit RGBA & BGRA and RGBA32F
+  int premultiply_alpha(const ImageView & img);
+
+  //! sRGB RGBA8 -> linear RGBA32F and back
+  int srgb_to_linear(const ImageView & src, const ImageView & dst);
+  int linear_to_srgb(const ImageView & src, const ImageView & dst);
+};
+
+#endif
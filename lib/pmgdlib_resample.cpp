@@ -0,0 +1,254 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <functional>
+
+#include "pmgdlib_resample.h"
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  int resample_filter_from_string(const std::string & name){
+    if(name == "BOX") return resample_filter::BOX;
+    if(name == "BILINEAR") return resample_filter::BILINEAR;
+    if(name == "LANCZOS3") return resample_filter::LANCZOS3;
+    return resample_filter::NONE;
+  }
+
+  // ======= filter weights ====================================================================
+  /// every dst pixel of the axis is the sum of taps src pixels starting from first
+  struct ResampleAxis {
+    int taps = 0;
+    std::vector<int> first;
+    std::vector<float> weights;   /// taps per dst pixel
+  };
+
+  static double resample_support(int filter){
+    if(filter == resample_filter::BOX) return 0.5;
+    if(filter == resample_filter::BILINEAR) return 1;
+    return 3;
+  }
+
+  static double resample_kernel(int filter, double x){
+    if(filter == resample_filter::BOX) return (x >= -0.5 and x < 0.5) ? 1 : 0;
+    x = std::fabs(x);
+    if(filter == resample_filter::BILINEAR) return std::max(0., 1 - x);
+    if(x < 1e-9) return 1;
+    if(x >= 3) return 0;
+    const double pi = 3.14159265358979323846;
+    return 3 * std::sin(pi * x) * std::sin(pi * x / 3) / (pi * pi * x * x);
+  }
+
+  /// filter is stretched by the scale when downscaling, weights of pixels beyond the edges go to the edge pixels
+  static ResampleAxis resample_axis(int src_size, int dst_size, int filter){
+    double scale = double(src_size) / dst_size, fscale = std::max(1., scale);
+    double support = resample_support(filter) * fscale;
+
+    std::vector<int> lo(dst_size);
+    std::vector<std::vector<double>> taps(dst_size);
+    ResampleAxis axis;
+    for(int i = 0; i < dst_size; ++i){
+      double center = (i + 0.5) * scale;
+      int j0 = int(std::floor(center - support)), j1 = int(std::ceil(center + support));
+      int a = std::clamp(j0, 0, src_size - 1), b = std::clamp(j1, 0, src_size - 1);
+      std::vector<double> & w = taps[i];
+      w.assign(b - a + 1, 0.);
+      double sum = 0;
+      for(int j = j0; j <= j1; ++j){
+        double v = resample_kernel(filter, (j + 0.5 - center) / fscale);
+        if(std::fabs(v) < 1e-7) continue;
+        w[std::clamp(j, 0, src_size - 1) - a] += v;
+        sum += v;
+      }
+      if(sum == 0){
+        w.assign(1, 1.);
+        a = std::clamp(int(center), 0, src_size - 1);
+        sum = 1;
+      }
+      /// trim zero weights, e.g. at integer positions of Lanczos
+      size_t f = 0, l = w.size();
+      while(f + 1 < l and w[f] == 0) ++f;
+      while(l > f + 1 and w[l - 1] == 0) --l;
+      w = std::vector<double>(w.begin() + f, w.begin() + l);
+      for(auto & v : w) v /= sum;
+      lo[i] = a + f;
+      axis.taps = std::max(axis.taps, int(w.size()));
+    }
+
+    axis.first.resize(dst_size);
+    axis.weights.assign(size_t(dst_size) * axis.taps, 0.f);
+    for(int i = 0; i < dst_size; ++i){
+      axis.first[i] = std::clamp(lo[i], 0, src_size - axis.taps);
+      float * w = axis.weights.data() + size_t(i) * axis.taps + lo[i] - axis.first[i];
+      for(size_t k = 0; k < taps[i].size(); ++k) w[k] = taps[i][k];
+    }
+    return axis;
+  }
+
+  // ======= scalar kernels ====================================================================
+  /// horizontal pass of one row of float pixels with channels channels, SIMD kernels sum in the same order
+  static void resample_row_scalar(const float * src, float * out, const ResampleAxis & axis, int n, int channels, int x = 0){
+    for(; x < n; ++x){
+      const float * w = axis.weights.data() + size_t(x) * axis.taps;
+      const float * p = src + size_t(axis.first[x]) * channels;
+      for(int c = 0; c < channels; ++c){
+        float acc = 0;
+        for(int k = 0; k < axis.taps; ++k) acc += w[k] * p[k * channels + c];
+        out[x * channels + c] = acc;
+      }
+    }
+  }
+
+  static void resample_row4_scalar(const float * src, float * out, const ResampleAxis & axis, int n){
+    resample_row_scalar(src, out, axis, n, 4);
+  }
+
+  /// vertical pass, out = sum of weighted rows, n floats
+  static void resample_column_tail(const float * const * rows, const float * w, int taps, float * out, size_t n, size_t i){
+    for(; i < n; ++i){
+      float acc = 0;
+      for(int k = 0; k < taps; ++k) acc += w[k] * rows[k][i];
+      out[i] = acc;
+    }
+  }
+
+  static void resample_column_scalar(const float * const * rows, const float * w, int taps, float * out, size_t n){
+    resample_column_tail(rows, w, taps, out, n, 0);
+  }
+
+  #ifdef PMGD_SIMD_X86
+    // ======= SSE2 kernels ====================================================================
+    /// pixel is one register of 4 floats
+    PMGD_TARGET_SSE2 static void resample_row4_sse2(const float * src, float * out, const ResampleAxis & axis, int n){
+      for(int x = 0; x < n; ++x){
+        const float * w = axis.weights.data() + size_t(x) * axis.taps;
+        const float * p = src + size_t(axis.first[x]) * 4;
+        __m128 acc = _mm_setzero_ps();
+        for(int k = 0; k < axis.taps; ++k) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(p + 4 * k)));
+        _mm_storeu_ps(out + 4 * x, acc);
+      }
+    }
+
+    PMGD_TARGET_SSE2 static void resample_column_sse2(const float * const * rows, const float * w, int taps, float * out, size_t n){
+      size_t i = 0;
+      for(; i + 4 <= n; i += 4){
+        __m128 acc = _mm_setzero_ps();
+        for(int k = 0; k < taps; ++k) acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w[k]), _mm_loadu_ps(rows[k] + i)));
+        _mm_storeu_ps(out + i, acc);
+      }
+      resample_column_tail(rows, w, taps, out, n, i);
+    }
+
+    // ======= AVX2 kernels ====================================================================
+    /// two dst pixels per register, one in every 128 bit lane
+    PMGD_TARGET_AVX2 static void resample_row4_avx2(const float * src, float * out, const ResampleAxis & axis, int n){
+      int x = 0;
+      for(; x + 2 <= n; x += 2){
+        const float * w0 = axis.weights.data() + size_t(x) * axis.taps, * w1 = w0 + axis.taps;
+        const float * p0 = src + size_t(axis.first[x]) * 4, * p1 = src + size_t(axis.first[x + 1]) * 4;
+        __m256 acc = _mm256_setzero_ps();
+        for(int k = 0; k < axis.taps; ++k){
+          __m256 p = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p0 + 4 * k)), _mm_loadu_ps(p1 + 4 * k), 1);
+          __m256 w = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(w0[k])), _mm_set1_ps(w1[k]), 1);
+          acc = _mm256_add_ps(acc, _mm256_mul_ps(w, p));
+        }
+        _mm256_storeu_ps(out + 4 * x, acc);
+      }
+      resample_row_scalar(src, out, axis, n, 4, x);
+    }
+
+    PMGD_TARGET_AVX2 static void resample_column_avx2(const float * const * rows, const float * w, int taps, float * out, size_t n){
+      size_t i = 0;
+      for(; i + 8 <= n; i += 8){
+        __m256 acc = _mm256_setzero_ps();
+        for(int k = 0; k < taps; ++k) acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(w[k]), _mm256_loadu_ps(rows[k] + i)));
+        _mm256_storeu_ps(out + i, acc);
+      }
+      resample_column_tail(rows, w, taps, out, n, i);
+    }
+  #endif
+
+  // ======= CPU dispatch ====================================================================
+  struct ResampleKernels {
+    void (*row4)(const float*, float*, const ResampleAxis&, int);
+    void (*column)(const float* const*, const float*, int, float*, size_t);
+  };
+
+  static const ResampleKernels resample_kernels[] = {
+    {resample_row4_scalar, resample_column_scalar},
+    #ifdef PMGD_SIMD_X86
+    {resample_row4_sse2, resample_column_sse2},
+    {resample_row4_avx2, resample_column_avx2},
+    #endif
+  };
+
+  static inline const ResampleKernels & kernels(){
+    return resample_kernels[simd_get_level()];
+  }
+
+  // ======= resampling ====================================================================
+  /// 4 channel rows are filtered with premultiplied alpha, so colors of transparent pixels do not bleed into neighbours
+  static void resample_premultiply(float * p, int w){
+    for(int x = 0; x < w; ++x)
+      for(int c = 0; c < 3; ++c) p[4 * x + c] *= p[4 * x + 3];
+  }
+
+  /// back to straight alpha as in make_mips(), alpha ringing of the filters is clamped, transparent pixels are black
+  static void resample_unpremultiply(float * p, int w){
+    for(int x = 0; x < w; ++x){
+      float a = std::clamp(p[4 * x + 3], 0.f, 1.f);
+      float k = a > 0 ? 1.f / a : 0.f;
+      for(int c = 0; c < 3; ++c) p[4 * x + c] = std::max(0.f, p[4 * x + c] * k);
+      p[4 * x + 3] = a;
+    }
+  }
+
+  int resample_image(const ImageView & src, const ImageView & dst, int filter){
+    if(not src.Valid() or not dst.Valid() or not src.Packed() or not dst.Packed()) return PM_ERROR_INCORRECT_ARGUMENTS;
+    if(src.format != dst.format or src.type != dst.type) return PM_ERROR_INCORRECT_ARGUMENTS;
+    bool u8 = src.type == image_type::UNSIGNED_CHAR;
+    if(u8 and src.format != image_format::RGBA and src.format != image_format::BGRA) return PM_ERROR_INCORRECT_ARGUMENTS;
+    if(not u8 and src.type != image_type::FLOAT) return PM_ERROR_INCORRECT_ARGUMENTS;
+    if(filter < resample_filter::BOX or filter > resample_filter::LANCZOS3) return PM_ERROR_INCORRECT_ARGUMENTS;
+
+    int channels = src.channels;
+    ResampleAxis ax = resample_axis(src.w, dst.w, filter), ay = resample_axis(src.h, dst.h, filter);
+    const ResampleKernels & kern = kernels();
+
+    /// horizontal pass of the source rows used by the vertical one, 8 bit rows are filtered as floats in [0, 1]
+    int row0 = ay.first.front(), row1 = ay.first.back() + ay.taps;
+    size_t tmp_stride = size_t(dst.w) * channels;
+    std::vector<float> tmp(tmp_stride * (row1 - row0));
+    bool alpha = channels == 4;
+    parallel_rows(0, row1 - row0, src.w + dst.w * ax.taps, [&](int y0, int y1){
+      std::vector<float> line(alpha ? size_t(src.w) * 4 : 0);
+      for(int y = y0; y < y1; ++y){
+        const float * in = (const float*)src.Row(row0 + y);
+        if(alpha){
+          if(u8) pixel_rgba8_to_rgba32f(src.Row(row0 + y), line.data(), src.w);
+          else std::copy(in, in + line.size(), line.data());
+          resample_premultiply(line.data(), src.w);
+          in = line.data();
+        }
+        float * out = tmp.data() + y * tmp_stride;
+        if(channels == 4) kern.row4(in, out, ax, dst.w);
+        else resample_row_scalar(in, out, ax, dst.w, channels);
+      }
+    });
+
+    parallel_rows(0, dst.h, dst.w * ay.taps, [&](int y0, int y1){
+      std::vector<const float*> rows(ay.taps);
+      std::vector<float> line(u8 ? tmp_stride : 0);
+      for(int y = y0; y < y1; ++y){
+        for(int k = 0; k < ay.taps; ++k) rows[k] = tmp.data() + (ay.first[y] - row0 + k) * tmp_stride;
+        float * out = u8 ? line.data() : (float*)dst.Row(y);
+        kern.column(rows.data(), ay.weights.data() + size_t(y) * ay.taps, ay.taps, out, tmp_stride);
+        if(alpha) resample_unpremultiply(out, dst.w);
+        if(u8) pixel_rgba32f_to_rgba8(line.data(), dst.Row(y), dst.w);
+      }
+    });
+    return PM_SUCCESS;
+  }
+};
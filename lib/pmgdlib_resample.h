@@ -0,0 +1,31 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_RESAMPLE_HH
+#define PMGDLIB_RESAMPLE_HH 1
+
+#include <string>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_image.h"
+
+namespace pmgd {
+  // ======= resampling ====================================================================
+  namespace resample_filter {
+    enum {
+      NONE = -1,
+      BOX,       /// average of the covered pixels
+      BILINEAR,  /// tent, widened by the scale factor when downscaling
+      LANCZOS3   /// 3 lobes windowed sinc, sharpest
+    };
+  };
+
+  //! "BOX", "BILINEAR", "LANCZOS3", anything else - NONE
+  int resample_filter_from_string(const std::string & name);
+
+  //! scale src to the size of dst with a separable filter, pixel centers are aligned and edges are clamped,
+  //! views have the same format & type with packed pixels: 8 bit RGBA / BGRA or float of any format,
+  //! weights are computed once per axis, rows are filtered in parallel on thread_pool() with SSE2 / AVX2 kernels selected with simd_get_level(),
+  //! 4 channel pixels are filtered with premultiplied alpha and stored back with straight alpha, as make_mips() does
+  int resample_image(const ImageView & src, const ImageView & dst, int filter = resample_filter::LANCZOS3);
+};
+
+#endif
@@ -0,0 +1,85 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <filesystem>
+
+#include "pmgdlib_resources.h"
+
+namespace pmgd {
+  // ======= ResourceCache ====================================================================
+  std::string resource_version(const std::string & path){
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if(ec) return "";
+    auto size = std::filesystem::file_size(path, ec);
+    if(ec) return "";
+    return std::to_string(mtime.time_since_epoch().count()) + ":" + std::to_string(size);
+  }
+
+  std::shared_ptr<void> ResourceCache::Get(const std::string & key){
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if(it == entries.end()) return nullptr;
+    std::shared_ptr<void> answer = it->second.lock();
+    if(answer == nullptr) entries.erase(it);
+    else n_hits++;
+    return answer;
+  }
+
+  std::shared_ptr<void> ResourceCache::GetOrLoad(const std::string & key, const Loader & load){
+    std::promise<std::shared_ptr<void>> promise;
+    std::shared_future<std::shared_ptr<void>> in_flight;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = entries.find(key);
+      if(it != entries.end()){
+        std::shared_ptr<void> answer = it->second.lock();
+        if(answer != nullptr){
+          n_hits++;
+          return answer;
+        }
+        entries.erase(it);
+      }
+
+      auto lit = loading.find(key);
+      if(lit != loading.end()){
+        n_hits++;
+        in_flight = lit->second;
+      } else {
+        loading[key] = promise.get_future().share();
+        n_loads++;
+      }
+    }
+    if(in_flight.valid()) return in_flight.get();
+
+    msg_debug("load", quote(key));
+    std::shared_ptr<void> answer;
+    try {
+      answer = load();
+    } catch(...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      loading.erase(key);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(answer != nullptr) entries[key] = answer;
+    loading.erase(key);
+    promise.set_value(answer);
+    return answer;
+  }
+
+  int ResourceCache::Size(){
+    std::lock_guard<std::mutex> lock(mutex);
+    for(auto it = entries.begin(); it != entries.end();){
+      if(it->second.expired()) it = entries.erase(it);
+      else ++it;
+    }
+    return entries.size();
+  }
+
+  void ResourceCache::Clear(){
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+  }
+};
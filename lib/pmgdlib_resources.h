@@ -0,0 +1,57 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_RESOURCES_HH
+#define PMGDLIB_RESOURCES_HH 1
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <functional>
+#include <unordered_map>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_string.h"
+
+namespace pmgd {
+  // ======= ResourceCache ====================================================================
+  //! version of the file at path as "mtime:size", empty if the file can't be stat'ed (e.g. virtual paths)
+  std::string resource_version(const std::string & path);
+
+  //! content-addressed storage of loaded resources shared between all users,
+  //! key is kind + path + file version so modified files are loaded again,
+  //! entries are weak - resource is alive while anybody holds it and loaded again after the last user is gone
+  class ResourceCache : public BaseMsg {
+    using Loader = std::function<std::shared_ptr<void>()>;
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<void>> entries;
+    std::unordered_map<std::string, std::shared_future<std::shared_ptr<void>>> loading;
+    int n_hits = 0, n_loads = 0;
+
+    public:
+    //! "kind:path@version"
+    static std::string Key(const std::string & kind, const std::string & path){
+      return kind + ":" + path + "@" + resource_version(path);
+    }
+
+    //! alive resource or nullptr
+    std::shared_ptr<void> Get(const std::string & key);
+    template<typename T> std::shared_ptr<T> Get(const std::string & key){ return std::static_pointer_cast<T>(Get(key)); }
+
+    //! alive resource or the result of load(), thread-safe,
+    //! concurrent calls with the same key wait for the single load, nullptr results are not stored
+    std::shared_ptr<void> GetOrLoad(const std::string & key, const Loader & load);
+    template<typename T, typename F> std::shared_ptr<T> GetOrLoad(const std::string & key, F && load){
+      return std::static_pointer_cast<T>(GetOrLoad(key, [&load]() -> std::shared_ptr<void> { return load(); }));
+    }
+
+    //! number of alive resources, expired entries are dropped
+    int Size();
+    int Hits() const { return n_hits; }
+    int Loads() const { return n_loads; }
+    void Clear();
+  };
+};
+
+#endif
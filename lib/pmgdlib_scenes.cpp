@@ -0,0 +1,161 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <set>
+#include <chrono>
+
+#include "pmgdlib_scenes.h"
+
+namespace pmgd {
+  // ======= SceneMachine ====================================================================
+  std::vector<SceneTransitionRule> get_cfg_scene_transitions(std::shared_ptr<Config> cfg){
+    std::vector<SceneTransitionRule> answer;
+    for(auto item : cfg->Get("transition")){
+      SceneTransitionRule rule;
+      rule.from = item->Attribute("from", "*");
+      rule.to = item->Attribute("to", "*");
+      rule.wait_prefetch = item->AttributeI("wait_prefetch", 1);
+      rule.cool_previous = item->AttributeI("cool_previous", 1);
+      rule.frames = item->AttributeI("frames", 0);
+      answer.push_back(rule);
+    }
+    return answer;
+  }
+
+  SceneMachine::SceneMachine(std::shared_ptr<NdMap<ProtoObject>> ndmap_, std::shared_ptr<ProtoCache> cache_, std::vector<NdKey> namespaces_){
+    ndmap = ndmap_;
+    cache = cache_;
+    namespaces = namespaces_;
+  }
+
+  const SceneTransitionRule & SceneMachine::Rule(const std::string & from, const std::string & to) const {
+    for(auto it = rules.rbegin(); it != rules.rend(); ++it){
+      if(it->from != "*" and it->from != from) continue;
+      if(it->to != "*" and it->to != to) continue;
+      return *it;
+    }
+    return default_rule;
+  }
+
+  std::shared_ptr<ProtoObject> SceneMachine::FindScene(const std::string & id){
+    return ndmap->GetOne(namespaces, NdKey("scene", id));
+  }
+
+  std::vector<std::shared_ptr<ProtoObject>> SceneMachine::SceneObjects(std::shared_ptr<ProtoObject> scene){
+    std::vector<std::shared_ptr<ProtoObject>> answer;
+    std::set<ProtoObject*> added;
+    auto add = [&](std::shared_ptr<ProtoObject> po){
+      if(po == nullptr or added.count(po.get())) return;
+      added.insert(po.get());
+      answer.push_back(po);
+    };
+
+    /// nested objects
+    std::vector<const ConfigItem*> stack = {scene->cfg_item};
+    while(stack.size()){
+      const ConfigItem* item = stack.back();
+      stack.pop_back();
+      add(ndmap->GetOne(cfg_item_key(item)));
+      for(auto & group : item->nested) for(auto nested : group.second) stack.push_back(nested);
+    }
+
+    /// dependencies, answer grows while iterating
+    std::shared_ptr<ProtoBuilder> builder = cache->Builder();
+    for(int i = 0; i < answer.size(); ++i)
+      for(auto dep : builder->Dependencies(answer[i])) add(dep);
+    return answer;
+  }
+
+  int SceneMachine::Prefetch(const std::string & id){
+    if(id == active_id or prefetches.count(id)) return PM_SUCCESS;
+    std::shared_ptr<ProtoObject> scene = FindScene(id);
+    if(scene == nullptr){
+      msg_warning("can't find scene", quote(id));
+      return PM_ERROR_404;
+    }
+
+    msg_debug("prefetch scene", quote(id));
+    PrefetchJob & pf = prefetches[id];
+    pf.objects = SceneObjects(scene);
+    for(auto po : pf.objects) cache->Pin(po);
+    pf.job = cache->StartWarmUp(pf.objects);
+    return PM_SUCCESS;
+  }
+
+  void SceneMachine::CancelPrefetch(const std::string & id){
+    auto it = prefetches.find(id);
+    if(it == prefetches.end()) return;
+    for(auto po : it->second.objects) cache->Unpin(po);
+    prefetches.erase(it);
+    if(next_id == id) next_id = "";
+  }
+
+  float SceneMachine::Progress(const std::string & id){
+    if(id == active_id) return 1.f;
+    auto it = prefetches.find(id);
+    if(it != prefetches.end()) return it->second.job->Progress();
+
+    std::shared_ptr<ProtoObject> scene = FindScene(id);
+    if(scene == nullptr) return 0.f;
+    auto objects = SceneObjects(scene);
+    int n_warm = 0;
+    for(auto po : objects) n_warm += po->IsWarm();
+    return objects.size() ? float(n_warm) / objects.size() : 1.f;
+  }
+
+  int SceneMachine::Switch(const std::string & id){
+    if(id == active_id){
+      next_id = "";
+      return PM_SUCCESS;
+    }
+    int ret = Prefetch(id);
+    if(ret != PM_SUCCESS) return ret;
+    msg_info("switch scene", quote(active_id), "->", quote(id));
+    next_id = id;
+    return PM_SUCCESS;
+  }
+
+  void SceneMachine::Activate(const std::string id){
+    PrefetchJob pf = prefetches[id];
+    prefetches.erase(id);
+    for(auto po : pf.objects) if(po->IsWarm()) cache->Touch(po);
+
+    const SceneTransitionRule & rule = Rule(active_id, id);
+    for(auto po : active_objects){
+      cache->Unpin(po);
+      if(rule.cool_previous and not po->pins) cache->CoolDown(po);
+    }
+
+    std::string from = active_id;
+    prev_id = active_id;
+    active_id = id;
+    next_id = "";
+    active_objects = pf.objects;
+    active_scene = FindScene(id);
+    transition = rule;
+    transition_frame = 0;
+    if(on_switch) on_switch(from, id);
+  }
+
+  void SceneMachine::Update(){
+    if(InTransition()) transition_frame++;
+
+    /// make stage of prefetched scenes, the next scene goes first
+    auto start = std::chrono::steady_clock::now();
+    auto left = [&](){ return frame_budget_ms - std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(); };
+    std::vector<std::string> ids;
+    if(next_id.size()) ids.push_back(next_id);
+    for(auto & it : prefetches) if(it.first != next_id) ids.push_back(it.first);
+
+    for(auto & id : ids){
+      PrefetchJob & pf = prefetches[id];
+      if(pf.job->Done()) continue;
+      bool force = id == next_id and not Rule(active_id, id).wait_prefetch;
+      if(force) pf.job->Step();
+      else if(left() > 0) pf.job->Step(left());
+      if(on_progress) on_progress(id, pf.job->Progress());
+    }
+    cache->Evict();
+
+    if(next_id.size() and prefetches[next_id].job->Done()) Activate(next_id);
+  }
+};
@@ -0,0 +1,93 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef PMGDLIB_SCENES_HH
+#define PMGDLIB_SCENES_HH 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+
+#include "pmgdlib_config.h"
+#include "pmgdlib_storage.h"
+#include "pmgdlib_factory.h"
+
+namespace pmgd {
+  // ======= SceneMachine ====================================================================
+  //! how to switch from one scene to another, "*" matches any scene
+  struct SceneTransitionRule {
+    std::string from = "*", to = "*";
+    bool wait_prefetch = true; /// keep the current scene until the next one is warm, otherwise build the rest in one frame
+    bool cool_previous = true; /// cool objects of the previous scene which are not used by the next one
+    int frames = 0;            /// transition length after the switch, see TransitionProgress()
+  };
+
+  //! rules from <transition from="menu" to="level_1" frames="30" wait_prefetch="1" cool_previous="0"/> items
+  std::vector<SceneTransitionRule> get_cfg_scene_transitions(std::shared_ptr<Config> cfg);
+
+  //! active scene and background prefetch of the next ones:
+  //! prepare stage of scene objects runs on worker threads, make stage takes frame_budget_ms per Update(),
+  //! switch to the prefetched scene is done in the next Update(),
+  //! objects of active & prefetched scenes are pinned in ProtoCache
+  class SceneMachine : public BaseMsg {
+    struct PrefetchJob {
+      std::shared_ptr<ProtoBuildJob> job;
+      std::vector<std::shared_ptr<ProtoObject>> objects;
+    };
+
+    std::shared_ptr<NdMap<ProtoObject>> ndmap;
+    std::shared_ptr<ProtoCache> cache;
+    std::vector<NdKey> namespaces;
+    std::vector<SceneTransitionRule> rules;
+    SceneTransitionRule default_rule;
+
+    std::map<std::string, PrefetchJob> prefetches;
+    std::string active_id, prev_id, next_id;
+    std::shared_ptr<ProtoObject> active_scene = nullptr;
+    std::vector<std::shared_ptr<ProtoObject>> active_objects;
+    SceneTransitionRule transition;
+    int transition_frame = 0;
+
+    std::shared_ptr<ProtoObject> FindScene(const std::string & id);
+    void Activate(const std::string id); /// by value, could be called with next_id
+
+    public:
+    //! time of the owner thread per Update() to make prefetched objects
+    double frame_budget_ms = 4;
+
+    std::function<void(const std::string & id, float progress)> on_progress = nullptr;
+    std::function<void(const std::string & from, const std::string & to)> on_switch = nullptr;
+
+    SceneMachine(std::shared_ptr<NdMap<ProtoObject>> ndmap_, std::shared_ptr<ProtoCache> cache_, std::vector<NdKey> namespaces_);
+
+    //! later rules have priority
+    void AddRule(const SceneTransitionRule & rule){ rules.push_back(rule); }
+    const SceneTransitionRule & Rule(const std::string & from, const std::string & to) const;
+
+    //! scene proto object with nested objects and their dependencies
+    std::vector<std::shared_ptr<ProtoObject>> SceneObjects(std::shared_ptr<ProtoObject> scene);
+
+    //! start building scene objects in background
+    int Prefetch(const std::string & id);
+    void CancelPrefetch(const std::string & id);
+
+    //! 0 - cold, 1 - ready to switch
+    float Progress(const std::string & id);
+
+    //! request switch to scene, done by Update() according to the transition rule
+    int Switch(const std::string & id);
+
+    //! call once per frame on the thread owning accelerator context
+    void Update();
+
+    const std::string & Active() const { return active_id; }
+    const std::string & Next() const { return next_id; }
+    std::shared_ptr<Scene> ActiveScene() const { return active_scene ? std::static_pointer_cast<Scene>(active_scene->object) : nullptr; }
+
+    bool InTransition() const { return transition_frame < transition.frames; }
+    float TransitionProgress() const { return transition.frames ? std::min(1.f, float(transition_frame) / transition.frames) : 1.f; }
+  };
+};
+
+#endif
@@ -0,0 +1,364 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "pmgdlib_soft.h"
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= quad setup ====================================================================
+  SoftQuad soft_quad(const TextureDrawData & data){
+    const v2 & pos = data.pos, & tpos = data.tpos, & tsize = data.tsize;
+    v2 size = data.size;
+    if(data.flip_x) size.x *= -1;
+    if(data.flip_y) size.y *= -1;
+    v2 perp = v2(-size.x, size.y);
+    if(data.angle){
+      size = size.Rotated(data.angle);
+      perp = perp.Rotated(data.angle);
+    }
+
+    SoftQuad q;
+    q.x[0] = pos.x - size.x; q.y[0] = pos.y + size.y; q.u[0] = tpos.x;           q.v[0] = tpos.y;
+    q.x[1] = pos.x - perp.x; q.y[1] = pos.y + perp.y; q.u[1] = tpos.x + tsize.x; q.v[1] = tpos.y;
+    q.x[2] = pos.x + size.x; q.y[2] = pos.y - size.y; q.u[2] = tpos.x + tsize.x; q.v[2] = tpos.y + tsize.y;
+    q.x[3] = pos.x + perp.x; q.y[3] = pos.y - perp.y; q.u[3] = tpos.x;           q.v[3] = tpos.y + tsize.y;
+    q.z = pos.z;
+    return q;
+  }
+
+  /// quad parameters s, t in [0, 1) along edges 0-1 & 0-3 and texel coordinates are affine in pixel coordinates: a * x + b * y + c
+  struct SoftSpan {
+    float s[3], t[3], tx[3], ty[3];
+    const uint8_t * tex;
+    int tex_stride; /// in pixels, negative for flipped views
+    float tw1, th1; /// last texel
+  };
+
+  struct SoftBox {
+    int x0, y0, x1, y1;
+  };
+
+  typedef void (*soft_span_fn)(const SoftSpan & sp, uint8_t * row, int x0, int x1, float fy);
+
+  /// round(x / 255) for x in [0, 255 * 255]
+  static inline uint32_t soft_div255(uint32_t x){
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+  }
+
+  static inline float soft_clamp(float v, float hi){ return std::min(std::max(v, 0.f), hi); }
+
+  // ======= span kernels ====================================================================
+  /// all kernels evaluate a * fx + (b * fy + c) in the same order, so they cover the same pixels
+  static void soft_span_scalar(const SoftSpan & sp, uint8_t * row, int x0, int x1, float fy){
+    float rs = sp.s[1] * fy + sp.s[2], rt = sp.t[1] * fy + sp.t[2];
+    float rx = sp.tx[1] * fy + sp.tx[2], ry = sp.ty[1] * fy + sp.ty[2];
+    for(int x = x0; x < x1; ++x){
+      float fx = float(x) + 0.5f;
+      float s = sp.s[0] * fx + rs, t = sp.t[0] * fx + rt;
+      if(not (s >= 0.f and s < 1.f and t >= 0.f and t < 1.f)) continue;
+      int ix = soft_clamp(sp.tx[0] * fx + rx, sp.tw1), iy = soft_clamp(sp.ty[0] * fx + ry, sp.th1);
+      const uint8_t * src = sp.tex + (ptrdiff_t(iy) * sp.tex_stride + ix) * 4;
+      uint8_t * dst = row + x * 4;
+      uint32_t a = src[3], ia = 255 - a;
+      for(int c = 0; c < 4; ++c) dst[c] = soft_div255(src[c] * a + dst[c] * ia);
+    }
+  }
+
+  #ifdef PMGD_SIMD_X86
+    /// 4 or 8 pixels of 16 bit channels: src * a + dst * (255 - a), then round(x / 255)
+    PMGD_TARGET_SSE2 static inline __m128i soft_blend_sse2(__m128i src, __m128i dst){
+      const __m128i zero = _mm_setzero_si128(), c255 = _mm_set1_epi16(255), c128 = _mm_set1_epi16(128);
+      __m128i answer[2];
+      for(int h = 0; h < 2; ++h){
+        __m128i s = h ? _mm_unpackhi_epi8(src, zero) : _mm_unpacklo_epi8(src, zero);
+        __m128i d = h ? _mm_unpackhi_epi8(dst, zero) : _mm_unpacklo_epi8(dst, zero);
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+        __m128i x = _mm_add_epi16(_mm_mullo_epi16(s, a), _mm_mullo_epi16(d, _mm_sub_epi16(c255, a)));
+        x = _mm_add_epi16(x, c128);
+        answer[h] = _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+      }
+      return _mm_packus_epi16(answer[0], answer[1]);
+    }
+
+    PMGD_TARGET_SSE2 static void soft_span_sse2(const SoftSpan & sp, uint8_t * row, int x0, int x1, float fy){
+      const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+      const __m128 tw1 = _mm_set1_ps(sp.tw1), th1 = _mm_set1_ps(sp.th1);
+      const __m128 as = _mm_set1_ps(sp.s[0]), at = _mm_set1_ps(sp.t[0]), ax = _mm_set1_ps(sp.tx[0]), ay = _mm_set1_ps(sp.ty[0]);
+      const __m128 rs = _mm_set1_ps(sp.s[1] * fy + sp.s[2]), rt = _mm_set1_ps(sp.t[1] * fy + sp.t[2]);
+      const __m128 rx = _mm_set1_ps(sp.tx[1] * fy + sp.tx[2]), ry = _mm_set1_ps(sp.ty[1] * fy + sp.ty[2]);
+      const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+      const __m128i lane_ids = _mm_setr_epi32(0, 1, 2, 3);
+      alignas(16) int32_t ix[4], iy[4];
+      alignas(16) uint32_t texels[4], pixels[4];
+      for(int x = x0; x < x1; x += 4){
+        int n = std::min(4, x1 - x);
+        __m128 fx = _mm_add_ps(_mm_set1_ps(float(x)), lanes);
+        __m128 s = _mm_add_ps(_mm_mul_ps(as, fx), rs), t = _mm_add_ps(_mm_mul_ps(at, fx), rt);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(s, zero), _mm_cmplt_ps(s, one)), _mm_and_ps(_mm_cmpge_ps(t, zero), _mm_cmplt_ps(t, one)));
+        __m128i mask = _mm_and_si128(_mm_castps_si128(inside), _mm_cmplt_epi32(lane_ids, _mm_set1_epi32(n)));
+        if(_mm_movemask_epi8(mask) == 0) continue;
+
+        __m128 tx = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(ax, fx), rx), zero), tw1);
+        __m128 ty = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(ay, fx), ry), zero), th1);
+        _mm_store_si128((__m128i*)ix, _mm_cvttps_epi32(tx));
+        _mm_store_si128((__m128i*)iy, _mm_cvttps_epi32(ty));
+        for(int i = 0; i < 4; ++i) memcpy(texels + i, sp.tex + (ptrdiff_t(iy[i]) * sp.tex_stride + ix[i]) * 4, 4);
+
+        uint8_t * dst = row + x * 4;
+        __m128i d;
+        if(n == 4) d = _mm_loadu_si128((const __m128i*)dst);
+        else {
+          memcpy(pixels, dst, n * 4);
+          d = _mm_load_si128((const __m128i*)pixels);
+        }
+        __m128i out = soft_blend_sse2(_mm_load_si128((const __m128i*)texels), d);
+        out = _mm_or_si128(_mm_and_si128(mask, out), _mm_andnot_si128(mask, d));
+        if(n == 4) _mm_storeu_si128((__m128i*)dst, out);
+        else {
+          _mm_store_si128((__m128i*)pixels, out);
+          memcpy(dst, pixels, n * 4);
+        }
+      }
+    }
+
+    PMGD_TARGET_AVX2 static void soft_span_avx2(const SoftSpan & sp, uint8_t * row, int x0, int x1, float fy){
+      const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+      const __m256 tw1 = _mm256_set1_ps(sp.tw1), th1 = _mm256_set1_ps(sp.th1);
+      const __m256 as = _mm256_set1_ps(sp.s[0]), at = _mm256_set1_ps(sp.t[0]), ax = _mm256_set1_ps(sp.tx[0]), ay = _mm256_set1_ps(sp.ty[0]);
+      const __m256 rs = _mm256_set1_ps(sp.s[1] * fy + sp.s[2]), rt = _mm256_set1_ps(sp.t[1] * fy + sp.t[2]);
+      const __m256 rx = _mm256_set1_ps(sp.tx[1] * fy + sp.tx[2]), ry = _mm256_set1_ps(sp.ty[1] * fy + sp.ty[2]);
+      const __m256 lanes = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+      const __m256i lane_ids = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+      const __m256i stride = _mm256_set1_epi32(sp.tex_stride);
+      const __m256i c255 = _mm256_set1_epi16(255), c128 = _mm256_set1_epi16(128), izero = _mm256_setzero_si256();
+      for(int x = x0; x < x1; x += 8){
+        __m256 fx = _mm256_add_ps(_mm256_set1_ps(float(x)), lanes);
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(as, fx), rs), t = _mm256_add_ps(_mm256_mul_ps(at, fx), rt);
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(s, zero, _CMP_GE_OQ), _mm256_cmp_ps(s, one, _CMP_LT_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(t, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, one, _CMP_LT_OQ)));
+        __m256i tail = _mm256_cmpgt_epi32(_mm256_set1_epi32(x1 - x), lane_ids);
+        __m256i mask = _mm256_and_si256(_mm256_castps_si256(inside), tail);
+        if(_mm256_testz_si256(mask, mask)) continue;
+
+        __m256 tx = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(ax, fx), rx), zero), tw1);
+        __m256 ty = _mm256_min_ps(_mm256_max_ps(_mm256_add_ps(_mm256_mul_ps(ay, fx), ry), zero), th1);
+        __m256i idx = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(ty), stride), _mm256_cvttps_epi32(tx));
+        __m256i src = _mm256_mask_i32gather_epi32(izero, (const int*)sp.tex, idx, mask, 4);
+
+        int * dst = (int*)(row + x * 4);
+        __m256i d = _mm256_maskload_epi32(dst, tail);
+        __m256i lo = _mm256_unpacklo_epi8(src, izero), hi = _mm256_unpackhi_epi8(src, izero);
+        __m256i dlo = _mm256_unpacklo_epi8(d, izero), dhi = _mm256_unpackhi_epi8(d, izero);
+        __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, 0xFF), 0xFF);
+        __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, 0xFF), 0xFF);
+        lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(lo, alo), _mm256_mullo_epi16(dlo, _mm256_sub_epi16(c255, alo))), c128);
+        hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(hi, ahi), _mm256_mullo_epi16(dhi, _mm256_sub_epi16(c255, ahi))), c128);
+        lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+        hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+        _mm256_maskstore_epi32(dst, mask, _mm256_packus_epi16(lo, hi));
+      }
+    }
+  #endif
+
+  static soft_span_fn soft_span_kernel(){
+    #ifdef PMGD_SIMD_X86
+      int level = simd_get_level();
+      if(level >= simd_level::AVX2) return soft_span_avx2;
+      if(level >= simd_level::SSE2) return soft_span_sse2;
+    #endif
+    return soft_span_scalar;
+  }
+
+  // ======= tiles ====================================================================
+  static bool soft_rgba8(const ImageView & view){
+    return view.Valid() and view.format == image_format::RGBA and view.type == image_type::UNSIGNED_CHAR and view.step == 4 and view.stride % 4 == 0;
+  }
+
+  int soft_draw_quads(const ImageView & target, const ImageView & texture, const std::vector<SoftQuad> & quads, int tile){
+    if(not soft_rgba8(target) or not soft_rgba8(texture) or tile <= 0) return PM_ERROR_INCORRECT_ARGUMENTS;
+    const float W = target.w, H = target.h;
+    const float tw = texture.w, th = texture.h;
+
+    std::vector<SoftSpan> spans;
+    std::vector<SoftBox> boxes;
+    spans.reserve(quads.size());
+    boxes.reserve(quads.size());
+    for(auto & q : quads){
+      float px[4], py[4];
+      for(int i = 0; i < 4; ++i){
+        px[i] = (q.x[i] + 1.f) * 0.5f * W;
+        py[i] = (1.f - q.y[i]) * 0.5f * H;
+      }
+      float e1x = px[1] - px[0], e1y = py[1] - py[0], e2x = px[3] - px[0], e2y = py[3] - py[0];
+      float det = e1x * e2y - e1y * e2x;
+      if(not (std::fabs(det) > 1e-6f)) continue;
+
+      int x0 = std::max(0.f, std::floor(*std::min_element(px, px + 4))), x1 = std::min(W, std::ceil(*std::max_element(px, px + 4)));
+      int y0 = std::max(0.f, std::floor(*std::min_element(py, py + 4))), y1 = std::min(H, std::ceil(*std::max_element(py, py + 4)));
+      if(x0 >= x1 or y0 >= y1) continue;
+
+      SoftSpan sp;
+      sp.s[0] =  e2y / det; sp.s[1] = -e2x / det; sp.s[2] = -(px[0] * sp.s[0] + py[0] * sp.s[1]);
+      sp.t[0] = -e1y / det; sp.t[1] =  e1x / det; sp.t[2] = -(px[0] * sp.t[0] + py[0] * sp.t[1]);
+      float du1 = q.u[1] - q.u[0], du3 = q.u[3] - q.u[0], dv1 = q.v[1] - q.v[0], dv3 = q.v[3] - q.v[0];
+      for(int k = 0; k < 3; ++k){
+        sp.tx[k] = tw * (du1 * sp.s[k] + du3 * sp.t[k]);
+        sp.ty[k] = th * (dv1 * sp.s[k] + dv3 * sp.t[k]);
+      }
+      sp.tx[2] += tw * q.u[0];
+      sp.ty[2] += th * q.v[0];
+      sp.tex = texture.data;
+      sp.tex_stride = texture.stride / 4;
+      sp.tw1 = tw - 1;
+      sp.th1 = th - 1;
+      spans.push_back(sp);
+      boxes.push_back(SoftBox{x0, y0, x1, y1});
+    }
+    if(spans.empty()) return PM_SUCCESS;
+
+    /// bins keep the order of quads, so every pixel is blended in the order given whatever tile it is in
+    int tiles_x = (target.w + tile - 1) / tile, tiles_y = (target.h + tile - 1) / tile;
+    std::vector<std::vector<int>> bins(tiles_x * tiles_y);
+    for(int i = 0; i < boxes.size(); ++i){
+      const SoftBox & b = boxes[i];
+      for(int ty = b.y0 / tile; ty <= (b.y1 - 1) / tile; ++ty)
+        for(int tx = b.x0 / tile; tx <= (b.x1 - 1) / tile; ++tx)
+          bins[ty * tiles_x + tx].push_back(i);
+    }
+
+    soft_span_fn span = soft_span_kernel();
+    parallel_for(thread_pool(), 0, bins.size(), [&](int i_start, int i_end){
+      for(int i = i_start; i < i_end; ++i){
+        int tx0 = (i % tiles_x) * tile, ty0 = (i / tiles_x) * tile;
+        int tx1 = std::min(target.w, tx0 + tile), ty1 = std::min(target.h, ty0 + tile);
+        for(int q : bins[i]){
+          const SoftBox & b = boxes[q];
+          int x0 = std::max(tx0, b.x0), x1 = std::min(tx1, b.x1);
+          int y0 = std::max(ty0, b.y0), y1 = std::min(ty1, b.y1);
+          for(int y = y0; y < y1; ++y) span(spans[q], target.Row(y), x0, x1, float(y) + 0.5f);
+        }
+      }
+    });
+    return PM_SUCCESS;
+  }
+
+  void soft_clear(const ImageView & target, const rgb & color){
+    if(not soft_rgba8(target)) return;
+    uint8_t c[4] = {uint8_t(soft_clamp(color.r, 1.f) * 255.f + 0.5f), uint8_t(soft_clamp(color.g, 1.f) * 255.f + 0.5f),
+                    uint8_t(soft_clamp(color.b, 1.f) * 255.f + 0.5f), uint8_t(soft_clamp(color.a, 1.f) * 255.f + 0.5f)};
+    for(int y = 0; y < target.h; ++y){
+      uint8_t * row = target.Row(y);
+      for(int x = 0; x < target.w; ++x) memcpy(row + x * 4, c, 4);
+    }
+  }
+
+  SoftContext & soft_context(){
+    static SoftContext context;
+    return context;
+  }
+
+  // ======= Texture & FrameBuffer ====================================================================
+  TextureSoft::TextureSoft(std::shared_ptr<Image> img){
+    /// own copy, as GL texture is not changed with the image
+    if(img) image = convert_image(ImageView(img), image_format::RGBA, image_type::UNSIGNED_CHAR);
+    if(not image) msg_warning("can't make texture from image, unsupported format");
+  }
+
+  int TextureSoft::Upload(const ImageView & view, int x, int y){
+    if(not image or x < 0 or y < 0) return PM_ERROR_INCORRECT_ARGUMENTS;
+    ImageView dst = ImageView(image).Sub(x, y, view.w, view.h);
+    return convert_pixels(view.Sub(0, 0, dst.w, dst.h), dst);
+  }
+
+  FrameBufferSoft::FrameBufferSoft(int size_x, int size_y) : FrameBuffer(size_x, size_y) {
+    image = std::make_shared<Image>(size_x, size_y);
+    Clear();
+  }
+
+  // ======= drawers ====================================================================
+  unsigned int ArrayDrawerSoft::Add(TextureDrawData * quad_data){
+    unsigned int id = FindFreePosition();
+    Set(id, quad_data);
+    return id;
+  }
+
+  void ArrayDrawerSoft::Set(const unsigned int & id, TextureDrawData * quad_data){
+    if(id >= quads.size()) return;
+    quads[id] = soft_quad(*quad_data);
+    used[id] = true;
+  }
+
+  void ArrayDrawerSoft::SetPos(const unsigned int & id, TextureDrawData * quad_data){
+    /// as ArrayDrawerGl::SetPos, no rotation & flips
+    if(id >= quads.size()) return;
+    const v2 & pos = quad_data->pos, & size = quad_data->size;
+    SoftQuad & q = quads[id];
+    q.x[0] = pos.x - size.x; q.y[0] = pos.y + size.y;
+    q.x[1] = pos.x + size.x; q.y[1] = pos.y + size.y;
+    q.x[2] = pos.x + size.x; q.y[2] = pos.y - size.y;
+    q.x[3] = pos.x - size.x; q.y[3] = pos.y - size.y;
+  }
+
+  void ArrayDrawerSoft::SetText(const unsigned int & id, TextureDrawData * quad_data){
+    if(id >= quads.size()) return;
+    const v2 & tpos = quad_data->tpos, & tsize = quad_data->tsize;
+    SoftQuad & q = quads[id];
+    q.u[0] = tpos.x;           q.v[0] = tpos.y;
+    q.u[1] = tpos.x + tsize.x; q.v[1] = tpos.y;
+    q.u[2] = tpos.x + tsize.x; q.v[2] = tpos.y + tsize.y;
+    q.u[3] = tpos.x;           q.v[3] = tpos.y + tsize.y;
+  }
+
+  void ArrayDrawerSoft::Move(const unsigned int & id, const v2 & shift){
+    if(id >= quads.size()) return;
+    for(int i = 0; i < 4; ++i){
+      quads[id].x[i] += shift.x;
+      quads[id].y[i] += shift.y;
+    }
+  }
+
+  void ArrayDrawerSoft::Clean(){
+    std::fill(used.begin(), used.end(), false);
+    last_quad_id = -1;
+    while(free_positions.size()) free_positions.pop();
+  }
+
+  void ArrayDrawerSoft::Remove(const unsigned int & id){
+    if(id >= quads.size() or not used[id]) return;
+    used[id] = false;
+    free_positions.push(id);
+  }
+
+  void ArrayDrawerSoft::Draw(){
+    SoftContext & context = soft_context();
+    if(not context.target.Valid() or not context.texture.Valid()) return;
+    std::vector<SoftQuad> visible;
+    for(int i = 0; i < quads.size(); ++i)
+      if(used[i]) visible.push_back(quads[i]);
+    std::stable_sort(visible.begin(), visible.end(), [](const SoftQuad & a, const SoftQuad & b){ return a.z > b.z; });
+    soft_draw_quads(context.target, context.texture, visible);
+  }
+
+  void TextureDrawerSoft::Draw(){
+    if(not texture) return;
+    texture->Bind();
+    SoftContext & context = soft_context();
+    if(context.target.Valid()) soft_draw_quads(context.target, context.texture, {soft_quad(data)});
+    texture->Unbind();
+  }
+
+  // ======= object maker ====================================================================
+  int AccelFactorySoft::InitAccel(const SysOptions & opts){
+    screen = std::make_shared<Image>(opts.screen_width, opts.screen_height);
+    soft_clear(ImageView(screen), rgb(0.f, 0.5f, 0.5f, 1.f));
+    SoftContext & context = soft_context();
+    context.screen = ImageView(screen);
+    context.target = context.screen;
+    return PM_SUCCESS;
+  }
+};
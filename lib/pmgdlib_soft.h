@@ -0,0 +1,131 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+#ifndef PMGDLIB_SOFT_HH
+#define PMGDLIB_SOFT_HH 1
+
+#include <vector>
+#include <memory>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_core.h"
+#include "pmgdlib_core_render.h"
+#include "pmgdlib_image.h"
+
+namespace pmgd {
+  // ======= software rasterizer ====================================================================
+  //! textured quad as GL gets it: vertexes in normalized device coordinates [-1, 1] with y up,
+  //! 0 - top left, 1 - top right, 2 - bottom right, 3 - bottom left, the quad is a parallelogram spanned by 0-1 and 0-3,
+  //! u, v are normalized texture coordinates with v = 0 at the first image row
+  struct SoftQuad {
+    float x[4], y[4], u[4], v[4];
+    float z = 0;
+  };
+
+  //! corners of the TextureDrawData quad in the layout of draw_textured_quad()
+  SoftQuad soft_quad(const TextureDrawData & data);
+
+  //! rasterize quads into RGBA8 target with RGBA8 texture sampled nearest & clamped to edge,
+  //! blending is GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA for all channels, quads are drawn in the order given:
+  //!   quads are binned into tile x tile screen tiles which are rasterized in parallel on thread_pool(),
+  //!   spans are filled by SSE2 / AVX2 kernels selected with simd_get_level()
+  int soft_draw_quads(const ImageView & target, const ImageView & texture, const std::vector<SoftQuad> & quads, int tile = 64);
+
+  //! fill RGBA8 view with color
+  void soft_clear(const ImageView & target, const rgb & color);
+
+  //! what drawers draw to & with, like the bound GL frame buffer and texture
+  struct SoftContext {
+    ImageView target;   /// frame buffer or screen
+    ImageView screen;
+    ImageView texture;
+  };
+  SoftContext & soft_context();
+
+  // ======= Texture & FrameBuffer ====================================================================
+  class TextureSoft : public Texture {
+    std::shared_ptr<Image> image;   /// RGBA8 copy if the source is another format
+
+    public:
+    TextureSoft(std::shared_ptr<Image> img);
+    virtual void Bind(){ soft_context().texture = ImageView(image); }
+    virtual void Unbind(){ soft_context().texture = ImageView(); }
+    virtual int Upload(const ImageView & view, int x = 0, int y = 0);
+    std::shared_ptr<Image> GetImage() const { return image; }
+  };
+
+  class FrameBufferSoft : public FrameBuffer {
+    std::shared_ptr<Image> image;
+
+    public:
+    FrameBufferSoft(int size_x, int size_y);
+    virtual void Target(){ soft_context().target = ImageView(image); }
+    virtual void Untarget(){ soft_context().target = soft_context().screen; }
+    virtual void Clear(){ soft_clear(ImageView(image), clear_color); }
+    virtual void BindTexture(){ soft_context().texture = ImageView(image); }
+    virtual void UnbindTexture(){ soft_context().texture = ImageView(); }
+    std::shared_ptr<Image> GetImage() const { return image; }
+  };
+
+  // ======= drawers ====================================================================
+  //! quads of the drawers are drawn with the bound texture to the current target of soft_context(),
+  //! there is no depth buffer, quads are sorted by z so the far ones are drawn first as with GL_LEQUAL depth test
+  class ArrayDrawerSoft : public ArrayDrawer {
+    std::vector<SoftQuad> quads;
+    std::vector<bool> used;
+
+    virtual bool IsFreeIndex(unsigned int quad_index){ return not used[quad_index]; }
+
+    public:
+    ArrayDrawerSoft(unsigned int max_quads_number) : ArrayDrawer(max_quads_number), quads(max_quads_number), used(max_quads_number, false) {}
+
+    virtual unsigned int Add(TextureDrawData * quad_data);
+    virtual void Set(const unsigned int & id, TextureDrawData * quad_data);
+    virtual void SetPos(const unsigned int & id, TextureDrawData * quad_data);
+    virtual void SetText(const unsigned int & id, TextureDrawData * quad_data);
+    virtual void Move(const unsigned int & id, const v2 & shift);
+    virtual void Clean();
+    virtual void Remove(const unsigned int & id);
+    virtual void Draw();
+  };
+
+  class SimpleDrawerSoft : public SimpleDrawer {
+    ArrayDrawerSoft array;
+
+    public:
+    SimpleDrawerSoft(unsigned int max_quads_number = 1024) : array(max_quads_number) {}
+    virtual unsigned int Add(TextureDrawData * quad_data){ return array.Add(quad_data); }
+    virtual void Remove(const unsigned int & id){ array.Remove(id); }
+    virtual void Clean(){ array.Clean(); }
+    virtual void Draw(){ array.Draw(); }
+  };
+
+  class TextureDrawerSoft : public TextureDrawer {
+    public:
+    virtual void Draw();
+  };
+
+  // ======= object maker ====================================================================
+  //! CPU backend for headless rendering, e.g. thumbnails & tests on servers without GPU,
+  //! the screen is an RGBA8 image of screen_width x screen_height
+  class AccelFactorySoft : public AccelFactory {
+    std::shared_ptr<Image> screen;
+
+    public:
+    virtual int InitAccel(const SysOptions & opts);
+    virtual std::shared_ptr<Texture> MakeTexture(std::shared_ptr<Image> img){
+      return std::make_shared<TextureSoft>(img);
+    }
+    virtual std::shared_ptr<FrameBuffer> MakeFrameBuffer(const int & size_x, const int & size_y){
+      return std::make_shared<FrameBufferSoft>(size_x, size_y);
+    }
+    virtual std::shared_ptr<TextureDrawer> MakeTextureDrawer(){
+      return std::make_shared<TextureDrawerSoft>();
+    }
+    virtual std::shared_ptr<SimpleDrawer> MakeSimpleDrawer(){
+      return std::make_shared<SimpleDrawerSoft>();
+    }
+    std::shared_ptr<Image> GetScreen() const { return screen; }
+  };
+};
+
+#endif
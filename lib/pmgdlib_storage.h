@@ -82,6 +82,17 @@ namespace pmgd {
       AddIds<T>(name);
       return PM_SUCCESS;
     }
+
+    //! same as Add but overwrite existing object with the same name
+    template<typename T>
+    int Replace(const std::string & name, std::shared_ptr<T> obj){
+      const std::string id = add_type_prefix<T>(name);
+      auto ptr = data.find(id);
+      if(ptr == data.end()) return Add(name, obj);
+      msg_debug("replace", quote(id));
+      ptr->second = std::static_pointer_cast<void>(obj);
+      return PM_SUCCESS;
+    }
   };
 
   //! internal tree to be used by NdMap 
@@ -162,6 +173,29 @@ namespace pmgd {
       loc->data = std::static_pointer_cast<void>(data);
     }
 
+    //! drop data stored at the exact key, tree nodes are kept
+    int Remove(const NdKey & key){
+      NdMapTree * loc = &head;
+      for(unsigned int i = 0; i < key.size() and loc != nullptr; ++i)
+        loc = loc->Get(key.at(i));
+      if(loc == nullptr or loc->data == nullptr) return PM_ERROR_404;
+      loc->data = nullptr;
+      return PM_SUCCESS;
+    }
+
+    //! all stored data at any depth
+    std::vector<std::shared_ptr<T>> All(){
+      std::vector<std::shared_ptr<T>> answer;
+      std::vector<NdMapTree*> stack = {&head};
+      while(stack.size()){
+        NdMapTree* it = stack.back();
+        stack.pop_back();
+        if(it->data != nullptr) answer.push_back(std::static_pointer_cast<T>(it->data));
+        for(auto node : it->nodes) stack.push_back(node.second);
+      }
+      return answer;
+    }
+
     std::vector<std::shared_ptr<T>> Get(const NdKey & key){
       std::vector<NdMapTree*>* heads = GetHeads(key);
 
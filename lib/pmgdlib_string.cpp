@@ -107,6 +107,14 @@ namespace pmgd {
     return def_answer;
   }
 
+  uint64_t hash_fnv1a(std::string_view data, uint64_t hash){
+    for(unsigned char c : data){
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
   // Special functions ============================================================================================================================
   std::string quote(const std::string & str, std::string qt){
     return qt + str + qt;
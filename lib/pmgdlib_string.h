@@ -6,7 +6,9 @@
 #define PMGDLIB_STRING_HH 1
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <cstdint>
 
 namespace pmgd {
 
@@ -42,6 +44,9 @@ namespace pmgd {
 
   bool bool_from_string(std::string val, bool def_answer = true);
 
+  //! 64 bit FNV-1a hash, fast & stable between runs, not cryptographic
+  uint64_t hash_fnv1a(std::string_view data, uint64_t hash = 14695981039346656037ull);
+
   // Special functions ============================================================================================================================
   std::string quote(const std::string & str, std::string qt = "\"");
 
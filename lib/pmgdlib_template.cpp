@@ -0,0 +1,389 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <cmath>
+#include <cstdlib>
+#include <charconv>
+#include <mutex>
+
+#include "pmgdlib_template.h"
+
+namespace pmgd {
+  // ======= helpers ====================================================================
+  static std::string_view strip_view(std::string_view str){
+    while(str.size() and std::isspace((unsigned char)str.front())) str.remove_prefix(1);
+    while(str.size() and std::isspace((unsigned char)str.back())) str.remove_suffix(1);
+    return str;
+  }
+
+  static bool is_name_start(char c){ return std::isalpha((unsigned char)c) or c == '_'; }
+  static bool is_name_char(char c){ return std::isalnum((unsigned char)c) or c == '_'; }
+
+  static void append_number(std::string & out, double value){
+    char buffer[32];
+    std::to_chars_result res;
+    if(value == std::floor(value) and std::fabs(value) < 1e15) res = std::to_chars(buffer, buffer + sizeof(buffer), (long long)value);
+    else res = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::general, 9);
+    out.append(buffer, res.ptr - buffer);
+  }
+
+  bool is_template(std::string_view raw){
+    return raw.find("${") != std::string_view::npos or raw.find("{%") != std::string_view::npos;
+  }
+
+  // ======= TemplateProgram ====================================================================
+  int TemplateProgram::Slot(const std::string & name){
+    auto it = slots.find(name);
+    if(it != slots.end()) return it->second;
+    int slot = slot_names.size();
+    slot_names.push_back(name);
+    slot_external.push_back(false);
+    if(name.size()) slots[name] = slot;
+    return slot;
+  }
+
+  int TemplateProgram::CompileExpr(std::string_view src, int & expr){
+    /// shunting-yard into RPN, operator precedence: NEG > MUL DIV MOD > ADD SUB
+    auto precedence = [](int op){
+      if(op == template_expr_op::NEG) return 3;
+      if(op == template_expr_op::ADD or op == template_expr_op::SUB) return 1;
+      return 2;
+    };
+
+    int start = expr_ops.size();
+    std::vector<int> ops; /// -1 for '('
+    int depth = 0, max_depth = 0;
+    bool expect_operand = true;
+
+    auto emit = [&](int op){
+      ExprOp eop;
+      eop.code = op;
+      expr_ops.push_back(eop);
+      depth -= (op == template_expr_op::NEG) ? 0 : 1;
+    };
+
+    for(size_t i = 0; i < src.size(); ){
+      char c = src[i];
+      if(std::isspace((unsigned char)c)){ ++i; continue; }
+
+      if(expect_operand){
+        if(c == '('){ ops.push_back(-1); ++i; continue; }
+        if(c == '-'){ ops.push_back(template_expr_op::NEG); ++i; continue; }
+        if(c == '+'){ ++i; continue; }
+
+        ExprOp eop;
+        if(is_name_start(c)){
+          size_t j = i;
+          while(j < src.size() and is_name_char(src[j])) ++j;
+          std::string name(src.substr(i, j - i));
+          eop.code = template_expr_op::VAR;
+          eop.slot = Slot(name);
+          i = j;
+        } else {
+          const char * begin = src.data() + i;
+          char * end = nullptr;
+          eop.code = template_expr_op::CONST;
+          eop.value = strtod(begin, &end);
+          if(end == begin){
+            msg_warning("template expression", quote(std::string(src)), "unexpected symbol", quote(std::string(1, c)));
+            return PM_ERROR_INCORRECT_ARGUMENTS;
+          }
+          i += end - begin;
+        }
+        expr_ops.push_back(eop);
+        max_depth = std::max(max_depth, ++depth);
+        expect_operand = false;
+        continue;
+      }
+
+      if(c == ')'){
+        while(ops.size() and ops.back() != -1){ emit(ops.back()); ops.pop_back(); }
+        if(not ops.size()){
+          msg_warning("template expression", quote(std::string(src)), "unbalanced parentheses");
+          return PM_ERROR_INCORRECT_ARGUMENTS;
+        }
+        ops.pop_back();
+        ++i;
+        continue;
+      }
+
+      int op = -1;
+      if(c == '+') op = template_expr_op::ADD;
+      else if(c == '-') op = template_expr_op::SUB;
+      else if(c == '*') op = template_expr_op::MUL;
+      else if(c == '/') op = template_expr_op::DIV;
+      else if(c == '%') op = template_expr_op::MOD;
+      if(op < 0){
+        msg_warning("template expression", quote(std::string(src)), "unexpected symbol", quote(std::string(1, c)));
+        return PM_ERROR_INCORRECT_ARGUMENTS;
+      }
+      while(ops.size() and ops.back() != -1 and precedence(ops.back()) >= precedence(op)){ emit(ops.back()); ops.pop_back(); }
+      ops.push_back(op);
+      expect_operand = true;
+      ++i;
+    }
+
+    while(ops.size()){
+      if(ops.back() == -1){
+        msg_warning("template expression", quote(std::string(src)), "unbalanced parentheses");
+        return PM_ERROR_INCORRECT_ARGUMENTS;
+      }
+      emit(ops.back());
+      ops.pop_back();
+    }
+
+    if(expect_operand or depth != 1){
+      msg_warning("template expression", quote(std::string(src)), "is incomplete");
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    }
+    if(max_depth > MAX_EXPR_DEPTH){
+      msg_warning("template expression", quote(std::string(src)), "is too deep");
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    }
+
+    expr = exprs.size();
+    exprs.push_back({start, (int)expr_ops.size()});
+    return PM_SUCCESS;
+  }
+
+  double TemplateProgram::Eval(int expr, const double * values) const {
+    double stack[MAX_EXPR_DEPTH];
+    int top = -1;
+    for(int i = exprs[expr].first, i_max = exprs[expr].second; i < i_max; ++i){
+      const ExprOp & op = expr_ops[i];
+      switch(op.code){
+        case template_expr_op::CONST: stack[++top] = op.value; break;
+        case template_expr_op::VAR:   stack[++top] = values[op.slot]; break;
+        case template_expr_op::NEG:   stack[top] = -stack[top]; break;
+        case template_expr_op::ADD:   stack[top-1] += stack[top]; --top; break;
+        case template_expr_op::SUB:   stack[top-1] -= stack[top]; --top; break;
+        case template_expr_op::MUL:   stack[top-1] *= stack[top]; --top; break;
+        case template_expr_op::DIV:   stack[top-1] /= stack[top]; --top; break;
+        case template_expr_op::MOD:   stack[top-1] = std::fmod(stack[top-1], stack[top]); --top; break;
+      }
+    }
+    return stack[0];
+  }
+
+  int TemplateProgram::Compile(std::string_view raw){
+    literals.clear(); code.clear(); expr_ops.clear(); exprs.clear();
+    slot_names.clear(); slot_external.clear(); slots.clear();
+
+    std::vector<int> loops;
+    std::vector<bool> assigned;
+    auto line_of = [&raw](size_t pos){ return 1 + std::count(raw.begin(), raw.begin() + pos, '\n'); };
+
+    /// variables read before any assignment are external
+    auto mark_reads = [&](int expr){
+      for(int i = exprs[expr].first; i < exprs[expr].second; ++i){
+        int slot = expr_ops[i].slot;
+        if(slot < 0) continue;
+        if(assigned.size() <= slot) assigned.resize(slot + 1, false);
+        if(not assigned[slot]) slot_external[slot] = true;
+      }
+    };
+    auto mark_assigned = [&](int slot){
+      if(assigned.size() <= slot) assigned.resize(slot + 1, false);
+      assigned[slot] = true;
+    };
+
+    size_t pos = 0;
+    while(pos < raw.size()){
+      size_t tag = std::min(raw.find("${", pos), raw.find("{%", pos));
+      size_t text_end = std::min(tag, raw.size());
+      if(text_end > pos){
+        Instr instr;
+        instr.code = template_op::TEXT;
+        instr.offset = literals.size();
+        instr.size = text_end - pos;
+        literals.append(raw.substr(pos, text_end - pos));
+        code.push_back(instr);
+      }
+      if(tag == std::string_view::npos) break;
+
+      bool is_expr = raw[tag] == '$';
+      size_t close = raw.find(is_expr ? "}" : "%}", tag + 2);
+      if(close == std::string_view::npos){
+        msg_warning("template tag at line", line_of(tag), "is not closed");
+        return PM_ERROR_INCORRECT_ARGUMENTS;
+      }
+      std::string_view body = strip_view(raw.substr(tag + 2, close - tag - 2));
+      pos = close + (is_expr ? 1 : 2);
+
+      Instr instr;
+      if(is_expr){
+        instr.code = template_op::EXPR;
+        if(CompileExpr(body, instr.expr) != PM_SUCCESS){
+          msg_warning("template error at line", line_of(tag));
+          return PM_ERROR_INCORRECT_ARGUMENTS;
+        }
+        mark_reads(instr.expr);
+        const std::pair<int, int> & range = exprs[instr.expr];
+        if(range.second - range.first == 1 and expr_ops[range.first].code == template_expr_op::VAR)
+          instr.slot = expr_ops[range.first].slot;
+        code.push_back(instr);
+        continue;
+      }
+
+      size_t word_end = 0;
+      while(word_end < body.size() and is_name_char(body[word_end])) ++word_end;
+      std::string_view word = body.substr(0, word_end);
+      std::string_view rest = strip_view(body.substr(word_end));
+
+      if(word == "endfor"){
+        if(not loops.size()){
+          msg_warning("template {% endfor %} without {% for %} at line", line_of(tag));
+          return PM_ERROR_INCORRECT_ARGUMENTS;
+        }
+        instr.code = template_op::ENDFOR;
+        instr.jump = loops.back();
+        code[loops.back()].jump = code.size();
+        loops.pop_back();
+        code.push_back(instr);
+        continue;
+      }
+
+      /// set & for statements start with variable name
+      size_t name_end = 0;
+      while(name_end < rest.size() and is_name_char(rest[name_end])) ++name_end;
+      std::string name(rest.substr(0, name_end));
+      std::string_view tail = strip_view(rest.substr(name_end));
+      if(not name.size() or not is_name_start(name[0])){
+        msg_warning("template statement", quote(std::string(body)), "requires variable name at line", line_of(tag));
+        return PM_ERROR_INCORRECT_ARGUMENTS;
+      }
+
+      int ret = PM_SUCCESS;
+      if(word == "set" and tail.size() and tail[0] == '='){
+        instr.code = template_op::SET;
+        ret = CompileExpr(tail.substr(1), instr.expr);
+        if(ret == PM_SUCCESS) mark_reads(instr.expr);
+        instr.slot = Slot(name);
+        mark_assigned(instr.slot);
+      } else if(word == "for" and tail.substr(0, 2) == "in" and tail.size() > 2 and not is_name_char(tail[2])){
+        tail = tail.substr(2);
+        size_t range = tail.find("..");
+        size_t step = tail.find(" step", range);
+        if(range == std::string_view::npos){
+          msg_warning("template {% for %} requires from..to range at line", line_of(tag));
+          return PM_ERROR_INCORRECT_ARGUMENTS;
+        }
+        instr.code = template_op::FOR;
+        ret = CompileExpr(tail.substr(0, range), instr.expr);
+        if(ret == PM_SUCCESS) ret = CompileExpr(tail.substr(range + 2, step == std::string_view::npos ? std::string_view::npos : step - range - 2), instr.expr_to);
+        if(ret == PM_SUCCESS and step != std::string_view::npos) ret = CompileExpr(tail.substr(step + 5), instr.expr_step);
+        if(ret == PM_SUCCESS){
+          mark_reads(instr.expr);
+          mark_reads(instr.expr_to);
+          if(instr.expr_step >= 0) mark_reads(instr.expr_step);
+        }
+        instr.slot = Slot(name);
+        mark_assigned(instr.slot);
+        /// internal slots to keep "to" and "step" values of the loop
+        instr.offset = Slot("");
+        Slot("");
+        loops.push_back(code.size());
+      } else {
+        msg_warning("unknown template statement", quote(std::string(body)), "at line", line_of(tag));
+        return PM_ERROR_INCORRECT_ARGUMENTS;
+      }
+
+      if(ret != PM_SUCCESS){
+        msg_warning("template error at line", line_of(tag));
+        return ret;
+      }
+      code.push_back(instr);
+    }
+
+    if(loops.size()){
+      msg_warning("template {% for %} without {% endfor %}");
+      return PM_ERROR_INCORRECT_ARGUMENTS;
+    }
+    return PM_SUCCESS;
+  }
+
+  void TemplateProgram::Expand(const std::map<std::string, std::string> & vars, std::string & out) const {
+    std::vector<double> values(slot_names.size(), 0.);
+    std::vector<const std::string*> strings(slot_names.size(), nullptr);
+    for(int slot = 0; slot < slot_names.size(); ++slot){
+      if(not slot_external[slot]) continue;
+      auto it = vars.find(slot_names[slot]);
+      if(it == vars.end()){
+        msg_warning("template variable", quote(slot_names[slot]), "is not defined, use 0");
+        continue;
+      }
+      values[slot] = atof(it->second.c_str());
+      strings[slot] = &(it->second);
+    }
+
+    out.reserve(out.size() + literals.size());
+    for(int pc = 0, pc_max = code.size(); pc < pc_max; ){
+      const Instr & instr = code[pc];
+      switch(instr.code){
+        case template_op::TEXT:
+          out.append(literals, instr.offset, instr.size);
+          ++pc;
+          break;
+        case template_op::EXPR:
+          if(instr.slot >= 0 and strings[instr.slot] != nullptr) out += *strings[instr.slot];
+          else append_number(out, Eval(instr.expr, values.data()));
+          ++pc;
+          break;
+        case template_op::SET:
+          values[instr.slot] = Eval(instr.expr, values.data());
+          strings[instr.slot] = nullptr;
+          ++pc;
+          break;
+        case template_op::FOR: {
+          double from = Eval(instr.expr, values.data());
+          double to = Eval(instr.expr_to, values.data());
+          double step = instr.expr_step >= 0 ? Eval(instr.expr_step, values.data()) : 1.;
+          values[instr.slot] = from;
+          values[instr.offset] = to;
+          values[instr.offset + 1] = step;
+          strings[instr.slot] = nullptr;
+          bool run = step > 0 ? from < to : (step < 0 ? from > to : false);
+          if(step == 0) msg_warning("template loop", quote(slot_names[instr.slot]), "with zero step, skip");
+          pc = run ? pc + 1 : instr.jump + 1;
+          break;
+        }
+        case template_op::ENDFOR: {
+          const Instr & loop = code[instr.jump];
+          double & value = values[loop.slot];
+          double to = values[loop.offset], step = values[loop.offset + 1];
+          value += step;
+          bool run = step > 0 ? value < to : value > to;
+          pc = run ? instr.jump + 1 : pc + 1;
+          break;
+        }
+      }
+    }
+  }
+
+  std::string TemplateProgram::Expand(const std::map<std::string, std::string> & vars) const {
+    std::string out;
+    Expand(vars, out);
+    return out;
+  }
+
+  // ======= cache ====================================================================
+  std::shared_ptr<const TemplateProgram> compile_template(const std::string & raw){
+    /// raw -> program, cleared when too large, reloads of changed configs add new entries
+    static std::mutex mutex;
+    static std::unordered_map<std::string, std::shared_ptr<const TemplateProgram>> cache;
+    const size_t MAX_CACHE_SIZE = 64;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = cache.find(raw);
+      if(it != cache.end()) return it->second;
+    }
+
+    auto program = std::make_shared<TemplateProgram>();
+    if(program->Compile(raw) != PM_SUCCESS) return nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(cache.size() >= MAX_CACHE_SIZE) cache.clear();
+    cache[raw] = program;
+    return program;
+  }
+};
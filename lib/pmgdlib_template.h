@@ -0,0 +1,96 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef PMGDLIB_TEMPLATE_HH
+#define PMGDLIB_TEMPLATE_HH 1
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_string.h"
+
+namespace pmgd {
+  //! Config templates, text substitution applied to raw config before parsing:
+  //!   ${expr}                          - value of expression, e.g. ${x * 32 + 16}, ${name}
+  //!   {% set name = expr %}            - assign variable
+  //!   {% for i in from..to [step s] %} - repeat text for i in [from, to)
+  //!   {% endfor %}
+  //! expression is + - * / % and unary - over numbers, variables and parentheses,
+  //! variables without {% set %} are taken from the Expand() arguments
+  namespace template_op {
+    enum {
+      TEXT = 0,
+      EXPR,
+      SET,
+      FOR,
+      ENDFOR,
+    };
+  };
+
+  namespace template_expr_op {
+    enum {
+      CONST = 0,
+      VAR,
+      ADD,
+      SUB,
+      MUL,
+      DIV,
+      MOD,
+      NEG,
+    };
+  };
+
+  //! template compiled into instruction list, variables are resolved into slots at compile time
+  class TemplateProgram : public BaseMsg {
+    struct ExprOp {
+      int code;
+      int slot = -1;
+      double value = 0;
+    };
+
+    struct Instr {
+      int code;
+      int slot = -1;                  /// SET, FOR - target variable; EXPR - variable for ${name} or -1
+      int expr = -1, expr_to = -1, expr_step = -1;
+      int offset = 0, size = 0;       /// TEXT - literal; FOR - offset is slot of internal "to", "step" values
+      int jump = -1;                  /// FOR - ENDFOR index; ENDFOR - FOR index
+    };
+
+    static const int MAX_EXPR_DEPTH = 64;
+
+    std::string literals;
+    std::vector<Instr> code;
+    std::vector<ExprOp> expr_ops;
+    std::vector<std::pair<int, int>> exprs; /// [start, end) in expr_ops
+    std::vector<std::string> slot_names;    /// "" for internal loop slots
+    std::vector<bool> slot_external;
+    std::unordered_map<std::string, int> slots;
+
+    int Slot(const std::string & name);
+    int CompileExpr(std::string_view src, int & expr);
+    double Eval(int expr, const double * values) const;
+
+    public:
+    //! PM_SUCCESS or PM_ERROR_INCORRECT_ARGUMENTS for invalid template
+    int Compile(std::string_view raw);
+
+    //! expand template into <out>, vars are used for variables not defined in template
+    void Expand(const std::map<std::string, std::string> & vars, std::string & out) const;
+    std::string Expand(const std::map<std::string, std::string> & vars) const;
+
+    int Size() const { return code.size(); }
+  };
+
+  //! return true if raw has any template tags
+  bool is_template(std::string_view raw);
+
+  //! compile template or get it from the cache of previously compiled templates, nullptr on errors
+  std::shared_ptr<const TemplateProgram> compile_template(const std::string & raw);
+};
+
+#endif
@@ -0,0 +1,106 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <atomic>
+#include <algorithm>
+
+#include "pmgdlib_thread.h"
+
+namespace pmgd {
+  // ======= ThreadPool ====================================================================
+  ThreadPool::ThreadPool(int n_threads){
+    if(n_threads <= 0) n_threads = std::max(1u, std::thread::hardware_concurrency());
+    for(int i = 0; i < n_threads; ++i)
+      workers.emplace_back([this](){ this->Work(); });
+  }
+
+  ThreadPool::~ThreadPool(){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stop = true;
+    }
+    cv_task.notify_all();
+    for(auto & worker : workers) worker.join();
+  }
+
+  void ThreadPool::Work(){
+    while(true){
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv_task.wait(lock, [this](){ return stop or tasks.size(); });
+        if(stop and not tasks.size()) return;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        n_active++;
+      }
+
+      task();
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        n_active--;
+        if(not n_active and not tasks.size()) cv_done.notify_all();
+      }
+    }
+  }
+
+  void ThreadPool::Wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cv_done.wait(lock, [this](){ return not n_active and not tasks.size(); });
+  }
+
+  ThreadPool & thread_pool(){
+    static ThreadPool pool;
+    return pool;
+  }
+
+  // ======= parallel_for ====================================================================
+  void parallel_for(ThreadPool & pool, int begin, int end, const std::function<void(int, int)> & fn, int grain){
+    if(end <= begin) return;
+    grain = std::max(1, grain);
+    int n_chunks = (end - begin + grain - 1) / grain;
+    if(n_chunks == 1){
+      fn(begin, end);
+      return;
+    }
+
+    /// chunks are taken by the caller and by helpers, the caller waits only for helpers which are running:
+    /// helpers queued behind busy workers, e.g. when parallel_for is called from a pool task, start late,
+    /// find the loop closed and return without touching fn
+    struct State {
+      std::atomic<int> next = 0;
+      std::mutex mutex;
+      std::condition_variable cv;
+      int n_running = 0;
+      bool closed = false;
+    };
+    auto state = std::make_shared<State>();
+    auto chunks = [state, n_chunks, begin, end, grain, &fn](){
+      for(int chunk = state->next++; chunk < n_chunks; chunk = state->next++){
+        int i_start = begin + chunk * grain;
+        fn(i_start, std::min(end, i_start + grain));
+      }
+    };
+    auto helper = [state, chunks](){
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if(state->closed) return;
+        state->n_running++;
+      }
+      chunks();
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if(--state->n_running == 0) state->cv.notify_all();
+    };
+
+    int n_helpers = std::min(pool.Size(), n_chunks - 1);
+    for(int i = 0; i < n_helpers; ++i) pool.Submit(helper);
+    chunks();
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->cv.wait(lock, [&state](){ return state->n_running == 0; });
+  }
+
+  void parallel_rows(int y0, int y1, int w, const std::function<void(int, int)> & fn){
+    parallel_for(thread_pool(), y0, y1, fn, std::max(1, (1 << 16) / std::max(1, w)));
+  }
+};
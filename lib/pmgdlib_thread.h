@@ -0,0 +1,66 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef PMGDLIB_THREAD_HH
+#define PMGDLIB_THREAD_HH 1
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+
+namespace pmgd {
+  //! fixed size pool of worker threads executing tasks in FIFO order
+  class ThreadPool : public BaseMsg {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv_task, cv_done;
+    int n_active = 0;
+    bool stop = false;
+
+    void Work();
+
+    public:
+    //! n_threads <= 0 means std::thread::hardware_concurrency()
+    ThreadPool(int n_threads = 0);
+    ~ThreadPool();
+
+    //! put task to the queue, result is available via std::future
+    template<typename F>
+    auto Submit(F && f) -> std::future<decltype(f())> {
+      using R = decltype(f());
+      auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+      std::future<R> answer = task->get_future();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace_back([task](){ (*task)(); });
+      }
+      cv_task.notify_one();
+      return answer;
+    }
+
+    //! block until the queue is empty and all workers are idle
+    void Wait();
+
+    int Size() const { return workers.size(); }
+  };
+
+  //! pool shared by the library, created on first call
+  ThreadPool & thread_pool();
+
+  //! call fn(i_start, i_end) for chunks of [begin, end) on the pool, calling thread takes chunks too
+  void parallel_for(ThreadPool & pool, int begin, int end, const std::function<void(int, int)> & fn, int grain = 1);
+
+  //! parallel_for() over image rows [y0, y1) of w pixels on thread_pool(), about 64K pixels per band,
+  //! so small images stay on the calling thread
+  void parallel_rows(int y0, int y1, int w, const std::function<void(int, int)> & fn);
+};
+
+#endif
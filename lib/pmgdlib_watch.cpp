@@ -0,0 +1,107 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#include <filesystem>
+#include <sys/stat.h>
+
+#ifdef __linux__
+  #include <sys/inotify.h>
+  #include <unistd.h>
+  #include <errno.h>
+#endif
+
+#include "pmgdlib_watch.h"
+
+namespace pmgd {
+  // ======= FileWatcher ====================================================================
+  FileWatcher::FileWatcher(){
+    #ifdef __linux__
+      fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if(fd < 0) msg_warning("inotify_init1() failed, fallback to mtime polling");
+    #endif
+  }
+
+  FileWatcher::~FileWatcher(){
+    #ifdef __linux__
+      if(fd >= 0) close(fd);
+    #endif
+  }
+
+  std::string FileWatcher::Normalize(const std::string & path){
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::absolute(path, ec);
+    if(ec) p = path;
+    return p.lexically_normal().string();
+  }
+
+  FileWatcher::FileStamp FileWatcher::Stamp(const std::string & path) const {
+    FileStamp stamp;
+    struct stat st;
+    if(stat(path.c_str(), &st) != 0) return stamp;
+    stamp.mtime = (long long)st.st_mtime;
+    stamp.size = (long long)st.st_size;
+    return stamp;
+  }
+
+  int FileWatcher::Add(const std::string & path){
+    std::string file = Normalize(path);
+    if(files.count(file)) return PM_ERROR_DUPLICATE;
+    files.insert(file);
+    stamps[file] = Stamp(file);
+
+    #ifdef __linux__
+      if(fd >= 0){
+        std::string dir = std::filesystem::path(file).parent_path().string();
+        int wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(wd < 0){
+          msg_warning("inotify_add_watch() failed for", quote(dir), "errno =", errno);
+          return PM_ERROR_IO;
+        }
+        dirs[wd] = dir;
+      }
+    #endif
+
+    msg_debug("watch", quote(file));
+    return PM_SUCCESS;
+  }
+
+  int FileWatcher::Remove(const std::string & path){
+    std::string file = Normalize(path);
+    if(not files.erase(file)) return PM_ERROR_404;
+    stamps.erase(file);
+    /// directory watch is kept, events for not watched files are ignored
+    return PM_SUCCESS;
+  }
+
+  std::vector<std::string> FileWatcher::Poll(){
+    std::set<std::string> changed;
+
+    #ifdef __linux__
+    if(fd >= 0){
+      alignas(struct inotify_event) char buffer[4096];
+      while(true){
+        ssize_t len = read(fd, buffer, sizeof(buffer));
+        if(len <= 0) break;
+        for(char * ptr = buffer; ptr < buffer + len; ){
+          const struct inotify_event * event = (const struct inotify_event *) ptr;
+          ptr += sizeof(struct inotify_event) + event->len;
+          if(not event->len) continue;
+
+          auto dir = dirs.find(event->wd);
+          if(dir == dirs.end()) continue;
+          std::string file = (std::filesystem::path(dir->second) / event->name).string();
+          if(files.count(file)) changed.insert(file);
+        }
+      }
+      return std::vector<std::string>(changed.begin(), changed.end());
+    }
+    #endif
+
+    for(auto & it : stamps){
+      FileStamp stamp = Stamp(it.first);
+      if(stamp.mtime == it.second.mtime and stamp.size == it.second.size) continue;
+      it.second = stamp;
+      changed.insert(it.first);
+    }
+    return std::vector<std::string>(changed.begin(), changed.end());
+  }
+};
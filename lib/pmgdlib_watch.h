@@ -0,0 +1,56 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef PMGDLIB_WATCH_HH
+#define PMGDLIB_WATCH_HH 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "pmgdlib_defs.h"
+#include "pmgdlib_msg.h"
+#include "pmgdlib_string.h"
+
+namespace pmgd {
+  //! FileWatcher report files which were written since the previous Poll()
+  //! on linux inotify is used to watch the file directories (editors often replace files by rename),
+  //! on other systems file modification time is checked on every Poll()
+  class FileWatcher : public BaseMsg {
+    struct FileStamp {
+      long long mtime = 0;
+      long long size = 0;
+    };
+
+    std::set<std::string> files;
+    std::map<std::string, FileStamp> stamps;
+
+    #ifdef __linux__
+      int fd = -1;
+      std::map<int, std::string> dirs;
+    #endif
+
+    FileStamp Stamp(const std::string & path) const;
+
+    public:
+    FileWatcher();
+    ~FileWatcher();
+    /// owns the inotify descriptor
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher & operator=(const FileWatcher &) = delete;
+
+    //! start to watch the file
+    int Add(const std::string & path);
+
+    //! stop to watch the file
+    int Remove(const std::string & path);
+
+    //! non-blocking, return normalized paths of changed files
+    std::vector<std::string> Poll();
+
+    //! path in the form returned by Poll()
+    static std::string Normalize(const std::string & path);
+  };
+};
+
+#endif
@@ -0,0 +1,136 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_BLEND_HH
+#define TEST_BLEND_HH 1
+
+#include "pmgdlib_blend.h"
+#include "pmgdlib_pixel.h"
+
+#include <random>
+
+TEST(pmlib_blend, modes) {
+  /// half transparent red over opaque blue, transparent over transparent, opaque over anything
+  std::vector<uint8_t> src = {255, 0, 0, 128,  9, 9, 9, 0,  1, 2, 3, 255};
+  std::vector<uint8_t> dst = {0, 0, 255, 255,  7, 7, 7, 0,  50, 60, 70, 80};
+  blend_row_over(src.data(), dst.data(), 3);
+  EXPECT_EQ(dst, std::vector<uint8_t>({128, 0, 127, 255,  0, 0, 0, 0,  1, 2, 3, 255}));
+
+  /// 100 + 200 * 127 / 255 and saturation
+  src = {100, 50, 0, 128,  200, 200, 200, 10};
+  dst = {200, 200, 200, 200,  255, 255, 255, 255};
+  blend_row_over_premul(src.data(), dst.data(), 2);
+  EXPECT_EQ(dst, std::vector<uint8_t>({200, 150, 100, 228,  255, 255, 255, 255}));
+
+  src = {100, 200, 0, 128};
+  dst = {10, 100, 250, 0};
+  blend_row_add(src.data(), dst.data(), 1);
+  EXPECT_EQ(dst, std::vector<uint8_t>({60, 200, 250, 64}));
+
+  auto img = std::make_shared<Image>(1, 1);
+  memcpy(img->data, std::vector<uint8_t>({200, 200, 200, 100}).data(), 4);
+  EXPECT_EQ(tint_image(ImageView(img), ImageView(img), rgb(1.f, 0.5f, 0.f, 1.f)), PM_SUCCESS);
+  EXPECT_EQ(std::vector<uint8_t>((uint8_t*)img->data, (uint8_t*)img->data + 4), std::vector<uint8_t>({200, 100, 0, 100}));
+
+  /// BGRA color channels are swapped
+  auto bgra = std::make_shared<Image>(1, 1, image_format::BGRA);
+  memset(bgra->data, 200, 4);
+  EXPECT_EQ(tint_image(ImageView(bgra), ImageView(bgra), rgb(1.f, 0.5f, 0.f, 1.f)), PM_SUCCESS);
+  EXPECT_EQ(std::vector<uint8_t>((uint8_t*)bgra->data, (uint8_t*)bgra->data + 4), std::vector<uint8_t>({0, 100, 200, 200}));
+
+  Image wrong(1, 1, image_format::RGBA, image_type::FLOAT);
+  auto big = std::make_shared<Image>(2, 1);
+  EXPECT_EQ(blend_image(wrong, ImageView(img)), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(blend_image(ImageView(big), ImageView(img)), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(blend_image(ImageView(bgra), ImageView(img)), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(blit_scaled(wrong, ImageView(img), 0, 0, 1, 1), PM_ERROR_INCORRECT_ARGUMENTS);
+}
+
+TEST(pmlib_blend, simd) {
+  /// every level gives the bytes of the scalar kernels
+  std::mt19937 rng(11);
+  auto random_image = [&](int w, int h){
+    auto img = std::make_shared<Image>(w, h);
+    for(int i = 0; i < img->Bytes(); ++i) ((uint8_t*)img->data)[i] = rng() % 256;
+    /// plenty of transparent & opaque pixels
+    for(int i = 0; i < w * h; i += 3) ((uint8_t*)img->data)[i * 4 + 3] = i % 2 ? 0 : 255;
+    return img;
+  };
+  auto src = random_image(37, 23), back = random_image(101, 67);
+
+  auto render = [&](int mode, int filter, bool flip){
+    auto img = std::make_shared<Image>(101, 67);
+    memcpy(img->data, back->data, back->Bytes());
+    ImageView source = flip ? ImageView(src).FlipX().FlipY() : ImageView(src);
+    EXPECT_EQ(blit_scaled(source, ImageView(img), -5, 3, 97, 71, filter, mode), PM_SUCCESS);
+    EXPECT_EQ(blit_scaled(source, ImageView(img), 50, -10, 20, 30, filter, mode), PM_SUCCESS);
+    EXPECT_EQ(blend_image(ImageView(back), ImageView(img), mode), PM_SUCCESS);
+    EXPECT_EQ(tint_image(ImageView(img), ImageView(img), rgb(0.9f, 0.3f, 0.6f, 0.7f)), PM_SUCCESS);
+    return img;
+  };
+
+  for(int mode : {blend_mode::COPY, blend_mode::OVER, blend_mode::OVER_PREMUL, blend_mode::ADD}){
+    for(int filter : {blit_filter::NEAREST, blit_filter::BILINEAR}){
+      for(bool flip : {false, true}){
+        simd_set_level(simd_level::SCALAR);
+        auto ref = render(mode, filter, flip);
+        for_simd_levels([&](int level){
+          auto img = render(mode, filter, flip);
+          EXPECT_EQ(memcmp(img->data, ref->data, ref->Bytes()), 0) << simd_level_name(level) << " " << mode << " " << filter << " " << flip;
+        });
+      }
+    }
+  }
+}
+
+TEST(pmlib_blend, blit) {
+  auto src = std::make_shared<Image>(7, 5);
+  for(int i = 0; i < src->Bytes(); ++i) ((uint8_t*)src->data)[i] = i;
+  ImageView sv(src);
+
+  /// 1:1 blit is an exact copy with both filters
+  for(int filter : {blit_filter::NEAREST, blit_filter::BILINEAR}){
+    auto dst = std::make_shared<Image>(7, 5);
+    EXPECT_EQ(blit_scaled(sv, ImageView(dst), 0, 0, 7, 5, filter, blend_mode::COPY), PM_SUCCESS);
+    EXPECT_EQ(memcmp(dst->data, src->data, src->Bytes()), 0) << filter;
+  }
+
+  /// clipped rectangle, pixels outside of it are untouched
+  auto dst = std::make_shared<Image>(6, 4);
+  memset(dst->data, 1, dst->Bytes());
+  EXPECT_EQ(blit_scaled(sv, ImageView(dst), -3, -2, 7, 5, blit_filter::NEAREST, blend_mode::COPY), PM_SUCCESS);
+  ImageView dv(dst);
+  EXPECT_EQ(memcmp(dv.Pixel(0, 0), sv.Pixel(3, 2), 16), 0);
+  EXPECT_EQ(memcmp(dv.Pixel(0, 2), sv.Pixel(3, 4), 16), 0);
+  EXPECT_EQ(dv.Pixel(4, 0)[0], 1);
+  EXPECT_EQ(dv.Pixel(0, 3)[0], 1);
+  EXPECT_EQ(blit_scaled(sv, ImageView(dst), 6, 0, 7, 5), PM_SUCCESS);
+
+  /// nearest 2x upscale & mirrored source
+  auto up = std::make_shared<Image>(14, 10);
+  ImageView uv(up);
+  EXPECT_EQ(blit_scaled(sv, uv, 0, 0, 14, 10, blit_filter::NEAREST, blend_mode::COPY), PM_SUCCESS);
+  EXPECT_EQ(memcmp(uv.Pixel(13, 9), sv.Pixel(6, 4), 4), 0);
+  EXPECT_EQ(memcmp(uv.Pixel(5, 2), sv.Pixel(2, 1), 4), 0);
+  EXPECT_EQ(blit_scaled(sv.FlipX(), uv, 0, 0, 14, 10, blit_filter::NEAREST, blend_mode::COPY), PM_SUCCESS);
+  EXPECT_EQ(memcmp(uv.Pixel(0, 0), sv.Pixel(6, 0), 4), 0);
+  EXPECT_EQ(memcmp(uv.Pixel(13, 9), sv.Pixel(0, 4), 4), 0);
+
+  /// bilinear keeps constant color, half pixel between two columns is their mean
+  auto flat = std::make_shared<Image>(3, 3);
+  for(int i = 0; i < 9; ++i) memcpy((uint8_t*)flat->data + i * 4, std::vector<uint8_t>({10, 20, 30, 40}).data(), 4);
+  auto big = std::make_shared<Image>(17, 13);
+  EXPECT_EQ(blit_scaled(ImageView(flat), ImageView(big), 0, 0, 17, 13, blit_filter::BILINEAR, blend_mode::COPY), PM_SUCCESS);
+  for(int i = 0; i < 17 * 13; ++i) EXPECT_EQ(memcmp((uint8_t*)big->data + i * 4, flat->data, 4), 0) << i;
+
+  auto pair = std::make_shared<Image>(2, 1);
+  memcpy(pair->data, std::vector<uint8_t>({0, 0, 0, 255,  100, 200, 255, 255}).data(), 8);
+  auto line = std::make_shared<Image>(4, 1);
+  EXPECT_EQ(blit_scaled(ImageView(pair), ImageView(line), 0, 0, 4, 1, blit_filter::BILINEAR, blend_mode::COPY), PM_SUCCESS);
+  /// centers at 0.25, 0.75, 1.25, 1.75 of the source map to -0.25, 0.25, 0.75, 1.25 pixels
+  EXPECT_EQ(ImageView(line).Pixel(0, 0)[0], 0);
+  EXPECT_EQ(ImageView(line).Pixel(1, 0)[0], 25);
+  EXPECT_EQ(ImageView(line).Pixel(2, 0)[0], 75);
+  EXPECT_EQ(ImageView(line).Pixel(3, 0)[0], 100);
+}
+
+#endif
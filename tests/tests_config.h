@@ -31,6 +31,227 @@ TEST(pmlib_config, config) {
   cfg_1.Merge(datas[0]);
   EXPECT_EQ(cfg_1.Attribute("art1"), "val1");
   EXPECT_EQ(cfg_1.Attribute("id"), "0");
+
+  ConfigItem cfg_2;
+  cfg_2.Merge(&cfg_1);
+  EXPECT_EQ(cfg_2.Get("data with id").size(), 10);
+}
+
+TEST(pmlib_config, schema) {
+  Config cfg;
+  auto add_item = [](ConfigItem* father, std::string type, std::map<std::string, std::string> attributes){
+    ConfigItem* item = new ConfigItem();
+    item->type = type;
+    for(auto & it : attributes) item->AddAttribute(it.first, it.second);
+    father->Add(type, item);
+    return item;
+  };
+
+  ConfigItem* scene = add_item(&cfg, "scene", {{"id", "s1"}});
+  add_item(scene, "layer", {{"id", "l1"}, {"texture", "t1"}});
+  add_item(scene, "layer", {{"id", "l2"}, {"texture", ""}});
+  add_item(&cfg, "layer", {{"id", "l3"}});
+  add_item(&cfg, "scene", {});
+
+  std::vector<std::string> processed;
+  auto proccessor = [&processed](const ConfigItem* c){ processed.push_back(c->Attribute("id")); return PM_SUCCESS; };
+  cfg.AddProcessingRule("scene", ConfigSchema({"id"}), proccessor);
+  cfg.AddProcessingRule("layer", ConfigSchema({"texture", "id"}, {"scene"}), proccessor);
+  cfg.verbose_lvl = verbose::SILENCE;
+
+  std::vector<ConfigViolation> violations;
+  EXPECT_EQ(cfg.ValidateItems(violations), PM_ERROR_SCHEMA);
+  /// l2 without texture, l3 without texture and father, second scene without id
+  EXPECT_EQ(violations.size(), 4);
+  int n_mandatory = 0, n_depth = 0;
+  for(auto & v : violations){
+    n_mandatory += v.kind == cfg_violation::MANDATORY;
+    n_depth += v.kind == cfg_violation::DEPTH;
+  }
+  EXPECT_EQ(n_mandatory, 3);
+  EXPECT_EQ(n_depth, 1);
+
+  std::vector<const ConfigItem*> processed_stack;
+  EXPECT_EQ(cfg.ProcessItems(processed_stack), PM_ERROR_SCHEMA);
+  EXPECT_EQ(processed, std::vector<std::string>({"s1", "l1"}));
+
+  processed.clear();
+  EXPECT_EQ(cfg.ProcessSubtree(scene, processed_stack), PM_ERROR_SCHEMA);
+  EXPECT_EQ(processed, std::vector<std::string>({"s1", "l1"}));
+}
+
+TEST(pmlib_config, json_loader) {
+  std::string raw = R"(
+    {
+      "texture": [
+        {"id": "t1", "path": "data/t1.png", "size": 64},
+        {"id": "t\u00e9\n2", "path": "a\\b\"c", "mipmaps": true, "filter": null}
+      ],
+      "scene": {"id": "s1", "layer": [{"id": "l1"}], "empty": {}}
+    }
+  )";
+  auto cfg = load_cfg(raw, "json_cfg");
+  EXPECT_TRUE(cfg->valid);
+  EXPECT_EQ(cfg->type, "cfg");
+  EXPECT_EQ(cfg->Attribute("id"), "json_cfg");
+
+  auto textures = cfg->Get("texture");
+  ASSERT_EQ(textures.size(), 2);
+  EXPECT_EQ(textures[0]->type, "texture");
+  EXPECT_EQ(textures[0]->Attribute("path"), "data/t1.png");
+  EXPECT_EQ(textures[0]->AttributeI("size"), 64);
+  EXPECT_EQ(textures[1]->Attribute("id"), "t\xC3\xA9\n2");
+  EXPECT_EQ(textures[1]->Attribute("path"), "a\\b\"c");
+  EXPECT_EQ(textures[1]->Attribute("mipmaps"), "true");
+  EXPECT_FALSE(textures[1]->HasAttribute("filter"));
+
+  auto scenes = cfg->Get("scene");
+  ASSERT_EQ(scenes.size(), 1);
+  EXPECT_EQ(scenes[0]->father, cfg.get());
+  EXPECT_EQ(scenes[0]->Get("layer").size(), 1);
+  EXPECT_EQ(scenes[0]->Get("layer")[0]->Attribute("id"), "l1");
+  EXPECT_EQ(scenes[0]->Get("empty").size(), 1);
+
+  auto cfg_tmpl = load_cfg("{% for i in 0..3 %}{% endfor %}{\"a\": {\"x\": ${x}}}", "tmpl", {{"x", "5"}});
+  EXPECT_EQ(cfg_tmpl->Get("a")[0]->Attribute("x"), "5");
+
+  /// surrogate pair is one code point, unpaired surrogates are replaced by U+FFFD
+  auto cfg_utf = load_cfg(R"({"a": {"pair": "\ud83d\ude00", "high": "\ud83dx", "low": "\ude00", "end": "\ud83d"}})", "utf");
+  auto utf = cfg_utf->Get("a")[0];
+  EXPECT_EQ(utf->Attribute("pair"), "\xF0\x9F\x98\x80");
+  EXPECT_EQ(utf->Attribute("high"), "\xEF\xBF\xBDx");
+  EXPECT_EQ(utf->Attribute("low"), "\xEF\xBF\xBD");
+  EXPECT_EQ(utf->Attribute("end"), "\xEF\xBF\xBD");
+
+  for(std::string invalid : {"{\"a\": [1, 2]}", "{\"a\": \"b\"", "{\"a\" \"b\"}", "{\"a\": tru}", "{} {}"}){
+    JsonConfigLoaderImp loader;
+    loader.verbose_lvl = verbose::SILENCE;
+    auto cfg_invalid = std::make_shared<Config>();
+    loader.ToCfg(invalid, cfg_invalid, "invalid");
+    EXPECT_FALSE(cfg_invalid->valid) << invalid;
+    EXPECT_EQ(load_cfg(invalid, "invalid"), nullptr) << invalid;
+  }
+}
+
+TEST(pmlib_config, diff_cfg) {
+  auto make_cfg = [](std::string texture_path, bool with_shader){
+    Config* cfg = new Config();
+    cfg->type = "cfg";
+    cfg->AddAttribute("id", "default");
+
+    ConfigItem* texture = new ConfigItem();
+    texture->type = "texture";
+    texture->AddAttribute("id", "t1");
+    texture->AddAttribute("image_path", texture_path);
+    cfg->Add("texture", texture);
+
+    if(with_shader){
+      ConfigItem* shader = new ConfigItem();
+      shader->type = "shader";
+      shader->AddAttribute("id", "s1");
+      cfg->Add("shader", shader);
+    }
+
+    ConfigItem* scene = new ConfigItem();
+    scene->type = "scene";
+    scene->AddAttribute("id", "main");
+    cfg->Add("scene", scene);
+
+    ConfigItem* drawer = new ConfigItem();
+    drawer->type = "drawer";
+    drawer->AddAttribute("texture", "t1");
+    scene->Add("drawer", drawer);
+    return cfg;
+  };
+
+  Config* cfg_old = make_cfg("a.png", true);
+  Config* cfg_new = make_cfg("b.png", false);
+
+  ConfigItem* drawer = cfg_new->Get("scene")[0]->Get("drawer")[0];
+  NdKey key = cfg_item_key(drawer);
+  EXPECT_EQ(key.size(), 5);
+  EXPECT_EQ(key.at(3), "drawer");
+  EXPECT_EQ(key.at(4), "#0");
+
+  std::vector<ConfigChange> changes;
+  diff_cfg(cfg_old, cfg_new, changes);
+  EXPECT_EQ(changes.size(), 2);
+  for(auto change : changes){
+    if(change.kind == cfg_change::MODIFIED){
+      EXPECT_EQ(change.new_item->Attribute("image_path"), "b.png");
+      EXPECT_EQ(change.key.at(2), "t1");
+    } else {
+      EXPECT_EQ(change.kind, cfg_change::REMOVED);
+      EXPECT_EQ(change.old_item->type, "shader");
+    }
+  }
+
+  changes.clear();
+  diff_cfg(cfg_new, cfg_old, changes, true);
+  int n_same = 0, n_added = 0;
+  for(auto change : changes){
+    if(change.kind == cfg_change::SAME) n_same++;
+    if(change.kind == cfg_change::ADDED) n_added++;
+  }
+  EXPECT_EQ(n_same, 3);
+  EXPECT_EQ(n_added, 1);
+}
+
+class IoTxtMemory : public IoTxt {
+  public:
+  std::map<std::string, std::string> files;
+  virtual std::string Read(const std::string & path) { return files[path]; };
+  virtual TxtView View(const std::string & path) {
+    auto it = files.find(path);
+    if(it == files.end()) return TxtView();
+    auto str = std::make_shared<const std::string>(it->second);
+    return TxtView{*str, str};
+  };
+};
+
+TEST(pmlib_config, load_cfg_file) {
+  auto io = std::make_shared<IoTxtMemory>();
+  io->files["data/main.xml"] = R"(
+    <include path="textures.xml"/>
+    <include path="sub/shaders.xml"/>
+    <sys screen_width="800"/>
+    <texture id="t2" image_path="main.png"/>
+  )";
+  io->files["data/textures.xml"] = R"(
+    <sys screen_width="640" screen_height="480"/>
+    <texture id="t1" image_path="t1.png"/>
+    <texture id="t2" image_path="t2.png"/>
+  )";
+  io->files["data/sub/shaders.xml"] = R"(
+    <include path="../textures.xml"/>
+    <shader id="s1" vert="def.vert" frag="def.frag"/>
+  )";
+
+  std::vector<std::string> paths;
+  auto cfg = load_cfg_file("data/main.xml", "default", io, &paths);
+  EXPECT_EQ(paths.size(), 3);
+  EXPECT_EQ(cfg->Get("include").size(), 0);
+  EXPECT_EQ(cfg->Get("shader").size(), 1);
+
+  /// included file goes first, the including one replaces its item with the same id
+  auto textures = cfg->Get("texture");
+  EXPECT_EQ(textures.size(), 2);
+  EXPECT_EQ(textures[0]->Attribute("image_path"), "t1.png");
+  EXPECT_EQ(textures[1]->Attribute("image_path"), "main.png");
+  EXPECT_EQ(get_cfg_sys_options(cfg).screen_width, 800);
+  EXPECT_EQ(get_cfg_sys_options(cfg).screen_height, 480);
+
+  /// reload of the unchanged tree has no changes
+  auto again = load_cfg_file("data/main.xml", "default", io);
+  std::vector<ConfigChange> changes;
+  diff_cfg(cfg.get(), again.get(), changes);
+  EXPECT_EQ(changes.size(), 0);
+
+  /// missing include fails the load
+  io->files["data/main.xml"] += R"(<include path="missing.xml"/>)";
+  paths.clear();
+  EXPECT_EQ(load_cfg_file("data/main.xml", "default", io, &paths), nullptr);
+  EXPECT_EQ(paths.size(), 4);
 }
 
 #ifdef USE_TINYXML2
@@ -46,4 +46,35 @@ TEST(pmlib_core, scene_to_render) {
   // output Render pipeline
 }
 
+TEST(pmlib_core, tex_atlas) {
+  TexAtlas atlas;
+  int a = atlas.Add("a", v2(0, 0), v2(0.5, 0.5));
+  EXPECT_EQ(a, 0);
+  EXPECT_EQ(atlas.Add("a", v2(0.5, 0.5), v2(0.1, 0.1)), a);
+  EXPECT_EQ(atlas.Handle("a"), a);
+  EXPECT_EQ(atlas.Handle("b"), -1);
+  EXPECT_EQ(atlas.Get("b"), nullptr);
+  EXPECT_EQ(atlas.Get(5), nullptr);
+  EXPECT_FLOAT_EQ(atlas.Tile(a).tpos.x, 0);
+  EXPECT_FLOAT_EQ(atlas.Get("a")->tsize.y, 0.5);
+
+  TexGrid grid = atlas.AddGrid(v2(0.5, 0), v2(0.125, 0.25), 4, 2, "walk");
+  ASSERT_TRUE(grid.Valid());
+  EXPECT_EQ(atlas.Size(), 9);
+  EXPECT_FALSE(atlas.AddGrid(v2(0, 0), v2(1, 1), 1, 1, "walk").Valid());
+  EXPECT_EQ(atlas.GetGrid("walk").first, grid.first);
+  EXPECT_FALSE(atlas.GetGrid("run").Valid());
+  for(int y = 0; y < 2; ++y){
+    for(int x = 0; x < 4; ++x){
+      int h = grid.Handle(x, y);
+      EXPECT_EQ(atlas.Handle(atlas.GenItemKey("walk", x, y)), h);
+      EXPECT_FLOAT_EQ(atlas.Tile(h).tpos.x, 0.5 + 0.125 * x);
+      EXPECT_FLOAT_EQ(atlas.Tile(h).tpos.y, 0.25 * y);
+      EXPECT_FLOAT_EQ(atlas.Tile(h).tsize.x, 0.125);
+    }
+  }
+  TexGrid sheet = atlas.AddGrid(v2(0, 0), v2(0.5, 0.5), 2, 2);
+  EXPECT_EQ(atlas.Get(atlas.GenItemKey(1, 1)), &atlas.Tile(sheet.Handle(1, 1)));
+}
+
 #endif
\ No newline at end of file
@@ -5,6 +5,15 @@
 
 #include "pmgdlib_core.h"
 #include "pmgdlib_factory.h"
+#include "pmgdlib_thread.h"
+
+#include <set>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <limits>
 
 TEST(pmlib_data, io_load_dummy) {
   SysOptions bo;
@@ -13,6 +22,104 @@ TEST(pmlib_data, io_load_dummy) {
   EXPECT_EQ(txt_data, "dummy data");
 }
 
+TEST(pmlib_data, io_mmap) {
+  SysOptions bo;
+  bo.io = "MMAP";
+  auto bk = get_backend(bo);
+  EXPECT_NE(std::dynamic_pointer_cast<IoTxtMmap>(bk->txt_imp), nullptr);
+
+  std::string dir = std::filesystem::temp_directory_path().string();
+  std::string path = dir + "/pmgdlib_io_mmap.json";
+  std::string raw = "{\"texture\": [{\"id\": \"t1\"}, {\"id\": \"t2\"}]}";
+  EXPECT_EQ(bk->txt_imp->Write(path, raw), PM_SUCCESS);
+
+  /// view outlives the backend call and keeps the mapping
+  TxtView txt = bk->ViewTxt(path);
+  EXPECT_EQ(txt.data, raw);
+  EXPECT_NE(txt.owner, nullptr);
+  EXPECT_EQ(bk->ReadTxt(path), raw);
+  auto cfg = load_cfg_file(path, "mmap", bk->txt_imp);
+  EXPECT_EQ(cfg->Get("texture").size(), 2);
+
+  std::string empty_path = dir + "/pmgdlib_io_mmap_empty.txt";
+  EXPECT_EQ(bk->txt_imp->Write(empty_path, ""), PM_SUCCESS);
+  EXPECT_TRUE(MappedFile(empty_path).Valid());
+  EXPECT_EQ(bk->ViewTxt(empty_path).data, "");
+
+  MappedFile missing(dir + "/pmgdlib_io_mmap_missing.txt");
+  EXPECT_FALSE(missing.Valid());
+  EXPECT_EQ(missing.Size(), 0);
+  std::filesystem::remove(path);
+  std::filesystem::remove(empty_path);
+}
+
+TEST(pmlib_data, pack) {
+  std::string dir = std::filesystem::temp_directory_path().string();
+  std::string path = dir + "/pmgdlib_test.pack";
+
+  PackBuilder builder;
+  builder.verbose_lvl = verbose::SILENCE;
+  for(int i = 0; i < 500; ++i) EXPECT_EQ(builder.Add("data/f" + std::to_string(i) + ".txt", "file " + std::to_string(i)), PM_SUCCESS);
+  EXPECT_EQ(builder.Add("data/shaders/../cfg.xml", "<cfg/>"), PM_SUCCESS);
+  EXPECT_EQ(builder.Add("data/cfg.xml", "<dup/>"), PM_ERROR_DUPLICATE);
+  EXPECT_EQ(builder.Add("data/empty.txt", ""), PM_SUCCESS);
+  std::string big;
+  for(int i = 0; i < 10000; ++i) big += "<texture id=\"t" + std::to_string(i) + "\"/>\n";
+  EXPECT_EQ(builder.Add("data/big.xml", big, pack_codec::LZ), PM_SUCCESS);
+  EXPECT_EQ(builder.Add("data/small.txt", "abc", pack_codec::LZ), PM_SUCCESS);
+  EXPECT_EQ(builder.Write(path), PM_SUCCESS);
+
+  auto pack = std::make_shared<PackArchive>(path);
+  EXPECT_TRUE(pack->Valid());
+  EXPECT_EQ(pack->Size(), 504);
+
+  /// compressed entry is decoded, not compressible one is stored as is
+  const PackEntry * big_entry = pack->Find("data/big.xml");
+  EXPECT_EQ(big_entry->codec, pack_codec::LZ);
+  EXPECT_LT(big_entry->size, big.size() / 2);
+  EXPECT_EQ(pack->Data(*big_entry).data, big);
+  EXPECT_EQ(pack->Find("data/small.txt")->codec, pack_codec::RAW);
+  for(int i = 0; i < 500; i += 7){
+    const PackEntry * entry = pack->Find("data/f" + std::to_string(i) + ".txt");
+    EXPECT_NE(entry, nullptr);
+    if(entry){ EXPECT_EQ(pack->Data(*entry).data, "file " + std::to_string(i)); }
+  }
+  EXPECT_EQ(pack->Find("data/f500.txt"), nullptr);
+
+  /// reads are views into the mapping, paths are normalized, missing paths go to fallback
+  IoTxtPack io(pack, std::make_shared<IoTxt>());
+  TxtView txt = io.View("./data/cfg.xml");
+  EXPECT_EQ(txt.data, "<cfg/>");
+  EXPECT_EQ(txt.data.data(), pack->Stored(*pack->Find("data/cfg.xml")).data());
+  EXPECT_EQ(io.Read("data/empty.txt"), "");
+  EXPECT_EQ(io.Read("data/missing.txt"), "dummy data");
+
+  SysOptions bo;
+  bo.io = "PACK";
+  bo.pack = path;
+  EXPECT_EQ(get_backend(bo)->ReadTxt("data/f42.txt"), "file 42");
+
+  /// not a pack
+  std::string broken = dir + "/pmgdlib_test_broken.pack";
+  IoTxtMmap().Write(broken, "PMGDPACK but too short");
+  PackArchive broken_pack(broken);
+  EXPECT_FALSE(broken_pack.Valid());
+  EXPECT_EQ(broken_pack.Find("data/cfg.xml"), nullptr);
+
+  /// entry with size wrapping offset + size around is rejected
+  std::string bytes = IoTxtMmap().Read(path);
+  PackEntry * forged = reinterpret_cast<PackEntry*>(bytes.data() + sizeof(PackHeader));
+  forged->size = std::numeric_limits<uint64_t>::max() - forged->offset + 2;
+  std::string corrupt = dir + "/pmgdlib_test_corrupt.pack";
+  IoTxtMmap().Write(corrupt, bytes);
+  PackArchive corrupt_pack(corrupt);
+  EXPECT_FALSE(corrupt_pack.Valid());
+  EXPECT_EQ(corrupt_pack.Find("data/f0.txt"), nullptr);
+  std::filesystem::remove(path);
+  std::filesystem::remove(broken);
+  std::filesystem::remove(corrupt);
+}
+
 TEST(pmlib_data, data_container) {
   DataContainer dc;
   std::string val = "123";
@@ -31,6 +138,503 @@ TEST(pmlib_data, data_container) {
   EXPECT_EQ(*y2, atoi(val.c_str()));
 }
 
+//! backend parts to test builders without real image files & accelerator
+class IoImageTest : public IoImage {
+  public:
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> n_reads = 0;
+  int delay_ms = 0;
+  virtual std::shared_ptr<Image> Read(const std::string & path) {
+    { std::lock_guard<std::mutex> lock(mutex); threads.insert(std::this_thread::get_id()); }
+    n_reads++;
+    if(delay_ms) std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    return get_test_image(image_type::UNSIGNED_CHAR);
+  };
+  std::shared_ptr<Image> written;
+  virtual int Write(const std::string & path, std::shared_ptr<Image> image) {
+    written = image;
+    return PM_SUCCESS;
+  };
+};
+
+class TextureTest : public Texture {
+  public:
+  virtual void Bind(){}
+  virtual void Unbind(){}
+};
+
+class ShaderTest : public Shader {
+  public:
+  virtual int LoadVert(const std::string & text){ return PM_SUCCESS; }
+  virtual int LoadFrag(const std::string & text){ return PM_SUCCESS; }
+  virtual int CreateProgram(){ return PM_SUCCESS; }
+  virtual int AddUniform(const std::string name){ return 0; }
+  virtual int GetUniform(const std::string name){ return 0; }
+  virtual void UpdateUniform1f(const int & pos, const float & val){}
+  virtual void EnableTexture(const int & pos, const int index){}
+};
+
+class SimpleDrawerTest : public SimpleDrawer {
+  public:
+  virtual unsigned int Add(TextureDrawData * quad_data){ return 0; }
+  virtual void Remove(const unsigned int & id){}
+  virtual void Clean(){}
+};
+
+class AccelFactoryTest : public AccelFactory {
+  public:
+  std::vector<std::string> made;
+  std::vector<const void*> made_objects; /// in the order of made, not owned to keep resource caches as they are
+  std::set<std::thread::id> threads;
+  template<typename T> std::shared_ptr<T> Made(std::string type){
+    auto obj = std::make_shared<T>();
+    made.push_back(type);
+    made_objects.push_back(obj.get());
+    threads.insert(std::this_thread::get_id());
+    return obj;
+  }
+  virtual std::shared_ptr<Texture> MakeTexture(std::shared_ptr<Image> img) { return Made<TextureTest>("texture"); }
+  virtual std::shared_ptr<Shader> MakeShader(const std::string & vert_txt, const std::string & frag_txt) { return Made<ShaderTest>("shader"); }
+  virtual std::shared_ptr<SimpleDrawer> MakeSimpleDrawer(){ return Made<SimpleDrawerTest>("drawer"); }
+  //! position of the object in made, -1 if it is not made here
+  int Order(std::shared_ptr<void> obj){
+    auto it = std::find(made_objects.begin(), made_objects.end(), obj.get());
+    return it == made_objects.end() ? -1 : it - made_objects.begin();
+  }
+};
+
+//! backend with the test io & accelerator, "default" config and map of its ProtoObjects
+struct ProtoFixture {
+  std::shared_ptr<Backend> back = std::make_shared<Backend>();
+  std::shared_ptr<IoImageTest> io = std::make_shared<IoImageTest>();
+  std::shared_ptr<AccelFactoryTest> accel = std::make_shared<AccelFactoryTest>();
+  std::shared_ptr<NdMap<ProtoObject>> ndmap = std::make_shared<NdMap<ProtoObject>>();
+  Config cfg;
+  std::map<std::string, ConfigItem*> items; /// by id
+
+  ProtoFixture(){
+    back->img_imp = io;
+    back->accel_imp = accel;
+    cfg.type = "cfg";
+    cfg.AddAttribute("id", "default");
+  }
+
+  //! add item nested into father (cfg by default) and its ProtoObject into ndmap
+  std::shared_ptr<ProtoObject> Add(std::string type, std::string id, std::map<std::string, std::string> attrs, ConfigItem* father = nullptr){
+    ConfigItem* item = new ConfigItem();
+    item->type = type;
+    item->AddAttribute("id", id);
+    for(auto & it : attrs) item->AddAttribute(it.first, it.second);
+    (father ? father : &cfg)->Add(type, item);
+    items[id] = item;
+    auto po = std::make_shared<ProtoObject>(item);
+    ndmap->Add(cfg_item_key(item), po);
+    return po;
+  }
+};
+
+TEST(pmlib_data, proto_builder) {
+  /// images are decoded on workers, textures & drawers are made on this thread
+  ProtoFixture fx;
+  auto io = fx.io;
+  auto accel = fx.accel;
+  io->delay_ms = 1;
+  std::vector<std::shared_ptr<ProtoObject>> objects;
+
+  /// drawers go first and refer to textures, which are not in the list and should be built as dependencies
+  for(int i = 0; i < 16; ++i) objects.push_back(fx.Add("drawer", "d" + std::to_string(i), {{"texture", "t" + std::to_string(i)}}));
+  std::vector<std::shared_ptr<ProtoObject>> textures;
+  for(int i = 0; i < 16; ++i) textures.push_back(fx.Add("texture", "t" + std::to_string(i), {{"image_path", "t" + std::to_string(i) + ".png"}}));
+
+  ProtoBuilder pb(fx.back, fx.ndmap);
+  EXPECT_EQ(pb.BuildObjects({NdKey("default")}, objects), PM_SUCCESS);
+  for(auto po : objects) EXPECT_TRUE(po->IsWarm());
+  for(auto po : textures) EXPECT_TRUE(po->IsWarm());
+  EXPECT_EQ(accel->made.size(), 32);
+  EXPECT_EQ(accel->threads, std::set<std::thread::id>({std::this_thread::get_id()}));
+  EXPECT_FALSE(io->threads.count(std::this_thread::get_id()) and io->threads.size() == 1);
+
+  /// every drawer is made after its texture
+  for(int i = 0; i < 16; ++i){
+    int t = accel->Order(textures[i]->object), d = accel->Order(objects[i]->object);
+    EXPECT_GE(t, 0) << i;
+    EXPECT_LT(t, d) << i;
+  }
+
+  /// cycles are reported
+  auto a = fx.Add("drawer", "a", {{"drawer", "b"}});
+  auto b = fx.Add("drawer", "b", {{"drawer", "a"}});
+  pb.verbose_lvl = verbose::SILENCE;
+  EXPECT_EQ(pb.BuildObjects({NdKey("default")}, {a}), PM_ERROR);
+  EXPECT_FALSE(a->IsWarm());
+
+  /// builder destroyed with the prepare stage in flight waits for running tasks, the rest are dropped
+  io->delay_ms = 20;
+  int n_reads = io->n_reads, n_tasks = 4 * thread_pool().Size();
+  std::vector<std::shared_ptr<ProtoObject>> late;
+  for(int i = 0; i < n_tasks; ++i) late.push_back(fx.Add("texture", "late" + std::to_string(i), {{"image_path", "late" + std::to_string(i) + ".png"}}));
+  auto builder = std::make_shared<ProtoBuilder>(fx.back, fx.ndmap);
+  auto job = builder->StartBuild({NdKey("default")}, late);
+  builder.reset();
+  thread_pool().Wait();
+  EXPECT_LE(io->n_reads - n_reads, thread_pool().Size());
+  for(auto po : late) EXPECT_FALSE(po->IsWarm());
+}
+
+TEST(pmlib_data, proto_cache) {
+  ProtoFixture fx;
+  auto io = fx.io;
+  std::vector<std::shared_ptr<ProtoObject>> textures;
+  for(int i = 0; i < 5; ++i) textures.push_back(fx.Add("texture", "t" + std::to_string(i), {{"image_path", "t" + std::to_string(i) + ".png"}}));
+
+  /// 4x4 RGBA8 test image is 64 bytes, 3 textures fit
+  ProtoCache cache(std::make_shared<ProtoBuilder>(fx.back, fx.ndmap), {NdKey("default")});
+  cache.verbose_lvl = verbose::SILENCE;
+  cache.SetBudget(200);
+  for(auto po : textures) EXPECT_NE(cache.Get<Texture>(po), nullptr);
+  EXPECT_EQ(cache.Used(), 192);
+  EXPECT_EQ(cache.Size(), 3);
+  EXPECT_FALSE(textures[0]->IsWarm());
+  EXPECT_FALSE(textures[1]->IsWarm());
+  EXPECT_TRUE(textures[4]->IsWarm());
+
+  /// touched object survives, cooled object is rebuilt on demand
+  cache.Get(textures[2]);
+  cache.Pin(textures[3]);
+  EXPECT_NE(cache.Get(textures[0]), nullptr);
+  EXPECT_EQ(io->n_reads, 6);
+  EXPECT_TRUE(textures[2]->IsWarm());
+  EXPECT_TRUE(textures[3]->IsWarm());
+  EXPECT_FALSE(textures[4]->IsWarm());
+  EXPECT_GT(textures[0]->last_use, textures[2]->last_use);
+
+  cache.CoolDown(textures[0]);
+  EXPECT_EQ(cache.Used(), 128);
+  EXPECT_EQ(textures[0]->bytes, 0);
+
+  /// pinned and the most recently used objects stay over the budget
+  cache.SetBudget(1);
+  EXPECT_TRUE(textures[2]->IsWarm());
+  EXPECT_TRUE(textures[3]->IsWarm());
+  cache.Unpin(textures[3]);
+  cache.Evict();
+  EXPECT_TRUE(textures[2]->IsWarm());
+  EXPECT_FALSE(textures[3]->IsWarm());
+  EXPECT_EQ(cache.Used(), 64);
+
+  /// object of a background warm up is taken from the job and is not built again
+  io->delay_ms = 5;
+  cache.SetBudget(0);
+  auto job = cache.StartWarmUp({textures[0], textures[1]});
+  EXPECT_NE(cache.Get(textures[1]), nullptr);
+  EXPECT_GE(job->Made(), 1);
+  EXPECT_FALSE(textures[4]->IsWarm());
+  auto object = textures[1]->object;
+  EXPECT_TRUE(job->Step());
+  EXPECT_EQ(job->Made(), 2);
+  EXPECT_EQ(textures[1]->object, object);
+  EXPECT_TRUE(textures[0]->IsWarm());
+  EXPECT_EQ(cache.Size(), 3);
+}
+
+TEST(pmlib_data, resource_cache) {
+  /// textures & shaders with the same sources are loaded and made once and live while used
+  ProtoFixture fx;
+  auto io = fx.io;
+  auto accel = fx.accel;
+  io->delay_ms = 1;
+  std::vector<std::shared_ptr<ProtoObject>> objects;
+  for(int i = 0; i < 8; ++i) objects.push_back(fx.Add("texture", "t" + std::to_string(i), {{"image_path", i % 2 ? "a.png" : "b.png"}}));
+  for(int i = 0; i < 4; ++i) objects.push_back(fx.Add("shader", "s" + std::to_string(i), {{"vert", "v.glsl"}, {"frag", "f.glsl"}}));
+
+  ProtoBuilder pb(fx.back, fx.ndmap);
+  EXPECT_EQ(pb.BuildObjects({NdKey("default")}, objects), PM_SUCCESS);
+  EXPECT_EQ(io->n_reads, 2);
+  EXPECT_EQ(accel->made.size(), 3);
+  EXPECT_EQ(objects[0]->object, objects[2]->object);
+  EXPECT_NE(objects[0]->object, objects[1]->object);
+  EXPECT_EQ(objects[8]->object, objects[11]->object);
+
+  /// resource is released with its last user and loaded again
+  for(int i = 0; i < 8; i += 2) objects[i]->Cool();
+  EXPECT_EQ(pb.resources->Size(), 2); /// a.png texture & shader, sources are released after the make stage
+  EXPECT_EQ(pb.BuildObjects({NdKey("default")}, {objects[0]}), PM_SUCCESS);
+  EXPECT_EQ(io->n_reads, 3);
+  EXPECT_EQ(accel->made.size(), 4);
+
+  /// concurrent loads of the same key wait for the single load
+  ResourceCache rc;
+  std::atomic<int> n_loads = 0;
+  std::vector<std::shared_ptr<int>> values(16);
+  parallel_for(thread_pool(), 0, 16, [&](int begin, int end){
+    for(int i = begin; i < end; ++i){
+      values[i] = rc.GetOrLoad<int>("k", [&](){
+        n_loads++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return std::make_shared<int>(42);
+      });
+    }
+  });
+  EXPECT_EQ(n_loads, 1);
+  for(auto & value : values) EXPECT_EQ(value, values[0]);
+}
+
+TEST(pmlib_data, io_queue) {
+  auto back = std::make_shared<Backend>();
+  auto io = std::make_shared<IoImageTest>();
+  back->img_imp = io;
+  IoQueue queue(back, 1);
+
+  /// the only worker is blocked, so the order of the rest is decided by priorities
+  std::promise<void> gate, started;
+  std::shared_future<void> opened = gate.get_future().share();
+  auto blocker = queue.Submit<int>([opened, &started](){ started.set_value(); opened.wait(); return 1; });
+  started.get_future().wait();
+
+  std::mutex mutex;
+  std::vector<std::string> order;
+  int n_done = 0;
+  auto job = [&](std::string name){
+    return std::function<int()>([&, name](){ std::lock_guard<std::mutex> lock(mutex); order.push_back(name); return 1; });
+  };
+  auto done = [&](const int & value){ n_done += value; };
+  auto a = queue.Submit<int>(job("a"), 0, done);
+  auto b = queue.Submit<int>(job("b"), 5, done);
+  auto c = queue.Submit<int>(job("c"), 0, done);
+  EXPECT_TRUE(queue.Cancel(c.id));
+  EXPECT_FALSE(queue.Cancel(c.id));
+  EXPECT_EQ(c.result.get(), 0);
+  EXPECT_TRUE(queue.SetPriority(a.id, 10));
+  EXPECT_EQ(queue.Pending(), 2);
+
+  gate.set_value();
+  queue.Wait();
+  EXPECT_EQ(order, std::vector<std::string>({"a", "b"}));
+  EXPECT_FALSE(queue.Cancel(a.id));
+  EXPECT_TRUE(a.Ready());
+
+  /// callbacks wait for Poll() on the owner thread
+  EXPECT_EQ(n_done, 0);
+  EXPECT_EQ(queue.Poll(), 2);
+  EXPECT_EQ(n_done, 2);
+
+  auto images = queue.ReadImage(std::vector<std::string>{"a.png", "b.png", "c.png"});
+  for(auto & image : images) EXPECT_NE(image.result.get(), nullptr);
+  EXPECT_EQ(io->n_reads, 3);
+  EXPECT_EQ(queue.ReadTxt("any").result.get().data, "dummy data");
+}
+
+TEST(pmlib_data, image_batch) {
+  auto back = std::make_shared<Backend>();
+  auto io = std::make_shared<IoImageTest>();
+  back->img_imp = io;
+  std::vector<int> order;
+  EXPECT_EQ(back->ReadImages({"a.png", "b.png"}, [&](int i, std::shared_ptr<Image> img){ order.push_back(i); }), 2);
+  EXPECT_EQ(order, std::vector<int>({0, 1}));
+
+  #ifdef USE_STB
+    /// every image is delivered once on this thread, memory limit allows one image at a time
+    IoImageStb stb;
+    std::string dir = std::filesystem::temp_directory_path().string();
+    std::vector<std::string> paths;
+    for(int i = 0; i < 16; ++i){
+      paths.push_back(dir + "/pmgdlib_batch_" + std::to_string(i) + ".png");
+      EXPECT_EQ(stb.Write(paths.back(), get_test_image(image_type::UNSIGNED_CHAR)), PM_SUCCESS);
+    }
+    paths.push_back(dir + "/pmgdlib_batch_missing.png");
+
+    for(size_t max_bytes : {size_t(1), size_t(0)}){
+      std::vector<int> seen(paths.size(), 0);
+      std::set<std::thread::id> threads;
+      int n = stb.ReadBatch(paths, [&](int i, std::shared_ptr<Image> img){
+        seen[i]++;
+        threads.insert(std::this_thread::get_id());
+        if(i < 16) EXPECT_EQ(img->w, 4);
+        else EXPECT_EQ(img, nullptr);
+      }, max_bytes);
+      EXPECT_EQ(n, 16);
+      EXPECT_EQ(seen, std::vector<int>(paths.size(), 1));
+      EXPECT_EQ(threads, std::set<std::thread::id>({std::this_thread::get_id()}));
+    }
+    for(int i = 0; i < 16; ++i) std::filesystem::remove(paths[i]);
+  #endif
+}
+
+TEST(pmlib_data, pixel_pool) {
+  PixelPool pool(1 << 20);
+  void * first = nullptr;
+  {
+    auto buffer = pool.Acquire(1000);
+    first = buffer.get();
+    EXPECT_EQ(size_t(first) % PixelPool::ALIGNMENT, 0);
+    EXPECT_EQ(pool.Cached(), 0);
+  }
+  /// released buffer is kept and reused by the same size class
+  EXPECT_EQ(pool.Cached(), 1024);
+  EXPECT_EQ(pool.Acquire(600).get(), first);
+  EXPECT_EQ(pool.Allocs(), 1);
+  EXPECT_EQ(pool.Reuses(), 1);
+  pool.Acquire(5000);
+  EXPECT_EQ(pool.Allocs(), 2);
+  EXPECT_EQ(pool.Cached(), 1024 + 8192);
+
+  /// over the limit buffers are freed
+  pool.Acquire(2 << 20);
+  EXPECT_EQ(pool.Cached(), 1024 + 8192);
+  pool.Trim();
+  EXPECT_EQ(pool.Cached(), 0);
+
+  /// images own pooled storage, foreign data is freed by the deleter
+  Image img(16, 8, image_format::RGBA, image_type::FLOAT);
+  EXPECT_NE(img.owner, nullptr);
+  EXPECT_EQ(size_t(img.data) % PixelPool::ALIGNMENT, 0);
+  auto copy = get_test_image()->Clone();
+  EXPECT_EQ(memcmp(copy->data, get_test_image()->data, copy->Bytes()), 0);
+  int n_freed = 0;
+  {
+    Image foreign(new char[64], 4, 4, image_format::RGBA, image_type::UNSIGNED_CHAR, [&](void * p){ delete[] (char*)p; n_freed++; });
+  }
+  EXPECT_EQ(n_freed, 1);
+}
+
+TEST(pmlib_data, image_view) {
+  /// 8 x 4 image, pixel (x, y) = {x, y, x + y, 255}
+  auto img = std::make_shared<Image>(8, 4);
+  for(int y = 0; y < 4; ++y)
+    for(int x = 0; x < 8; ++x){
+      uint8_t * p = (uint8_t*)img->data + (y * 8 + x) * 4;
+      p[0] = x; p[1] = y; p[2] = x + y; p[3] = 255;
+    }
+
+  ImageView view(img);
+  EXPECT_TRUE(view.Contiguous());
+  EXPECT_EQ(view.owner.get(), img.get());
+
+  ImageView sub = view.Sub(2, 1, 3, 2);
+  EXPECT_EQ(sub.w, 3);
+  EXPECT_EQ(sub.h, 2);
+  EXPECT_EQ(*sub.At<uint8_t>(0, 0), 2);
+  EXPECT_EQ(*sub.At<uint8_t>(2, 1, 1), 2);
+  EXPECT_TRUE(sub.Packed());
+  EXPECT_FALSE(sub.Contiguous());
+  EXPECT_EQ(view.Sub(6, 3, 5, 5).w, 2);
+  EXPECT_EQ(view.Sub(6, 3, 5, 5).h, 1);
+
+  ImageView flip = sub.FlipX().FlipY();
+  EXPECT_EQ(*flip.At<uint8_t>(0, 0, 0), 4);
+  EXPECT_EQ(*flip.At<uint8_t>(0, 0, 1), 2);
+  EXPECT_EQ(*flip.At<uint8_t>(2, 1, 0), 2);
+
+  ImageView blue = sub.Channel(2);
+  EXPECT_EQ(blue.PixelBytes(), 1);
+  uint8_t packed[6];
+  blue.CopyTo(packed);
+  EXPECT_EQ(std::vector<uint8_t>(packed, packed + 6), std::vector<uint8_t>({3, 4, 5, 4, 5, 6}));
+  EXPECT_EQ(blue.ToImage(), nullptr);
+
+  auto tiles = view.Grid(3, 2);
+  ASSERT_EQ(tiles.size(), 4);
+  EXPECT_EQ(*tiles[3].At<uint8_t>(0, 0, 0), 3);
+  EXPECT_EQ(*tiles[3].At<uint8_t>(0, 0, 1), 2);
+
+  /// writes pack views which are not plain images
+  auto io = std::make_shared<IoImageTest>();
+  IO back;
+  back.img_imp = io;
+  EXPECT_EQ(back.WriteImage("sub.png", flip), PM_SUCCESS);
+  ASSERT_NE(io->written, nullptr);
+  EXPECT_EQ(io->written->w, 3);
+  EXPECT_EQ(((uint8_t*)io->written->data)[0], 4);
+
+  /// every pixel of the view with row padding is written, in memory and through stb
+  auto same_pixels = [&sub](std::shared_ptr<Image> image){
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(image->w, sub.w);
+    ASSERT_EQ(image->h, sub.h);
+    for(int y = 0; y < sub.h; ++y) EXPECT_EQ(memcmp((uint8_t*)image->data + y * sub.w * 4, sub.Row(y), sub.w * 4), 0) << y;
+  };
+  EXPECT_EQ(back.WriteImage("sub.png", sub), PM_SUCCESS);
+  same_pixels(io->written);
+
+  #ifdef USE_STB
+    std::string path = std::filesystem::temp_directory_path().string() + "/pmgdlib_view.png";
+    IoImageStb stb;
+    EXPECT_EQ(stb.WriteView(path, sub), PM_SUCCESS);
+    same_pixels(stb.Read(path));
+    std::filesystem::remove(path);
+  #endif
+}
+
+TEST(pmlib_data, image_disk_cache) {
+  std::string tmp = std::filesystem::temp_directory_path().string();
+  std::string dir = tmp + "/pmgdlib_img_cache";
+  std::filesystem::remove_all(dir);
+  std::vector<std::string> paths;
+  for(int i = 0; i < 3; ++i){
+    paths.push_back(tmp + "/pmgdlib_cache_src_" + std::to_string(i) + ".txt");
+    std::ofstream(paths.back()) << "source " << i;
+  }
+
+  auto io = std::make_shared<IoImageTest>();
+  auto cache = std::make_shared<IoImageDiskCache>(io, dir, 0);
+  auto ref = get_test_image(image_type::UNSIGNED_CHAR);
+
+  /// first read decodes, second read maps the cache file
+  EXPECT_EQ(cache->CachePath(tmp + "/pmgdlib_cache_missing"), "");
+  EXPECT_NE(cache->CachePath(paths[0]), "");
+  EXPECT_NE(cache->Read(paths[0]), nullptr);
+  EXPECT_TRUE(std::filesystem::exists(cache->CachePath(paths[0])));
+  auto img = cache->Read(paths[0]);
+  EXPECT_EQ(io->n_reads, 1);
+  EXPECT_EQ(cache->Hits(), 1);
+  EXPECT_EQ(cache->Misses(), 1);
+  ASSERT_NE(img, nullptr);
+  EXPECT_NE(img->owner, nullptr);
+  EXPECT_EQ(img->w, ref->w);
+  EXPECT_EQ(img->h, ref->h);
+  EXPECT_EQ(memcmp(img->data, ref->data, ref->Bytes()), 0);
+
+  /// batch: one hit, two misses
+  int n = cache->ReadBatch(paths, [&](int i, std::shared_ptr<Image> img){ EXPECT_NE(img, nullptr); });
+  EXPECT_EQ(n, 3);
+  EXPECT_EQ(io->n_reads, 3);
+  EXPECT_EQ(cache->Hits(), 2);
+  size_t file_size = cache->Used() / 3;
+  EXPECT_EQ(file_size, sizeof(DiskImageHeader) + ref->Bytes());
+
+  /// changed source is a new entry
+  std::ofstream(paths[0]) << "changed";
+  cache->Read(paths[0]);
+  EXPECT_EQ(io->n_reads, 4);
+
+  /// limit allows two files, the least recently used go first
+  auto small = std::make_shared<IoImageDiskCache>(io, dir, 2 * file_size);
+  EXPECT_EQ(small->Used(), 4 * file_size);
+  EXPECT_EQ(small->Evict(), 2);
+  EXPECT_EQ(small->Used(), 2 * file_size);
+  small->Read(paths[0]);
+  small->Read(paths[2]);
+  EXPECT_EQ(io->n_reads, 4);
+  small->Read(paths[1]);
+  EXPECT_EQ(io->n_reads, 5);
+  EXPECT_EQ(small->Used(), 2 * file_size);
+
+  /// mip chains are made once and mapped with the image
+  auto with_mips = std::make_shared<IoImageDiskCache>(io, dir, 0, mip_filter::BOX);
+  EXPECT_EQ(with_mips->Read(paths[2])->mips.size(), 2);
+  int before = io->n_reads;
+  auto mapped = with_mips->Read(paths[2]);
+  EXPECT_EQ(io->n_reads, before);
+  ASSERT_EQ(mapped->mips.size(), 2);
+  EXPECT_EQ(mapped->mips[1]->w, 1);
+  EXPECT_EQ(mapped->mips[0]->owner, mapped->owner);
+  EXPECT_EQ(size_t(mapped->mips[0]->data) % 64, 0);
+
+  std::filesystem::remove_all(dir);
+  for(auto & path : paths) std::filesystem::remove(path);
+}
+
 #ifdef USE_STB
 TEST(pmlib_data, stb) {
   SysOptions bo;
@@ -51,6 +655,25 @@ TEST(pmlib_data, stb) {
       }
     }
   }
+
+  /// grey & grey + alpha are decoded as RGBA
+  std::string path = std::filesystem::temp_directory_path().string() + "/pmgdlib_grey.png";
+  for(int n : {1, 2}){
+    std::vector<uint8_t> grey(16 * 16 * n);
+    for(int i = 0; i < grey.size(); ++i) grey[i] = i % n ? 100 : i / n;
+    ASSERT_TRUE(stbi_write_png(path.c_str(), 16, 16, n, grey.data(), 0));
+    std::ifstream file(path, std::ios::binary);
+    std::string raw((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    for(auto decoded : {IoImageStb().Read(path), decode_image_stb(raw.data(), raw.size())}){
+      ASSERT_NE(decoded, nullptr);
+      EXPECT_EQ(decoded->format, image_format::RGBA);
+      EXPECT_EQ(decoded->Bytes(), 16 * 16 * 4);
+      auto clone = decoded->Clone();
+      uint8_t * p = (uint8_t*)clone->data + 4 * 37;
+      EXPECT_EQ(std::vector<uint8_t>(p, p + 4), std::vector<uint8_t>({37, 37, 37, uint8_t(n == 2 ? 100 : 255)})) << n;
+    }
+  }
+  std::filesystem::remove(path);
 }
 #endif // USE_STB
 
@@ -0,0 +1,91 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_LZ_HH
+#define TEST_LZ_HH 1
+
+#include "pmgdlib_lz.h"
+
+#include <random>
+
+TEST(pmlib_lz, block) {
+  std::mt19937 rng(42);
+  auto text = [&](size_t n){
+    std::string answer;
+    const char * words[] = {"texture ", "shader ", "scene ", "<layer id=\"", "\"/>\n"};
+    while(answer.size() < n) answer += words[rng() % 5];
+    answer.resize(n);
+    return answer;
+  };
+
+  for(size_t n : {0, 1, 11, 12, 13, 100, 4096, 100000}){
+    for(std::string raw : {text(n), std::string(n, 'a')}){
+      std::string packed;
+      size_t size = lz_compress_block(raw.data(), raw.size(), packed);
+      EXPECT_EQ(size, packed.size());
+      EXPECT_LE(size, lz_block_bound(n));
+      std::string unpacked(n, '\0');
+      EXPECT_EQ(lz_decompress_block(packed.data(), packed.size(), unpacked.data(), n), int64_t(n));
+      EXPECT_EQ(unpacked, raw);
+      if(n >= 4096){ EXPECT_LT(size, n / 2); }
+    }
+  }
+
+  /// random bytes don't compress but survive
+  std::string noise(5000, '\0');
+  for(auto & c : noise) c = rng();
+  std::string packed;
+  lz_compress_block(noise.data(), noise.size(), packed);
+  std::string unpacked(noise.size(), '\0');
+  EXPECT_EQ(lz_decompress_block(packed.data(), packed.size(), unpacked.data(), unpacked.size()), int64_t(noise.size()));
+  EXPECT_EQ(unpacked, noise);
+
+  /// broken input or small output is reported, not written out of bounds
+  std::string raw = text(1000);
+  packed.clear();
+  lz_compress_block(raw.data(), raw.size(), packed);
+  unpacked.assign(999, '\0');
+  EXPECT_EQ(lz_decompress_block(packed.data(), packed.size(), unpacked.data(), unpacked.size()), -1);
+  for(int i = 0; i < 200; ++i){
+    std::string broken = packed;
+    broken[rng() % broken.size()] = rng();
+    broken.resize(rng() % broken.size());
+    unpacked.assign(1000, '\0');
+    EXPECT_LE(lz_decompress_block(broken.data(), broken.size(), unpacked.data(), unpacked.size()), 1000);
+  }
+}
+
+TEST(pmlib_lz, stream) {
+  std::string raw;
+  for(int i = 0; i < 20000; ++i) raw += "pixel " + std::to_string(i % 977) + ";";
+
+  for(bool parallel : {false, true}){
+    std::string packed = lz_compress(raw, 4096, parallel);
+    EXPECT_LT(packed.size(), raw.size() / 2);
+    EXPECT_EQ(lz_raw_size(packed), raw.size());
+    std::string unpacked;
+    EXPECT_EQ(lz_decompress(packed, unpacked, parallel), PM_SUCCESS);
+    EXPECT_EQ(unpacked, raw);
+  }
+
+  std::string empty;
+  EXPECT_EQ(lz_decompress(lz_compress(""), empty), PM_SUCCESS);
+  EXPECT_EQ(empty, "");
+
+  std::string packed = lz_compress(raw, 4096);
+  std::string unpacked;
+  EXPECT_EQ(lz_raw_size("not a stream"), -1);
+  EXPECT_EQ(lz_decompress("not a stream", unpacked), PM_ERROR);
+  EXPECT_EQ(lz_decompress(std::string_view(packed).substr(0, packed.size() - 1), unpacked), PM_ERROR);
+
+  /// raw size in the header can't be larger than the stored blocks decode to, nothing is allocated for it
+  std::string forged = lz_compress(raw.substr(0, 1000), LZ_BLOCK_SIZE);
+  LzHeader header;
+  memcpy(&header, forged.data(), sizeof(header));
+  header.block_size = header.raw_size = 0x7FFFFFFF;
+  memcpy(forged.data(), &header, sizeof(header));
+  unpacked.clear();
+  EXPECT_EQ(lz_decompress(forged, unpacked), PM_ERROR);
+  EXPECT_EQ(unpacked.size(), 0);
+}
+
+#endif
@@ -7,8 +7,16 @@
 #include "tests_pipeline.h"
 #include "tests_config.h"
 #include "tests_core.h"
+#include "tests_thread.h"
+#include "tests_template.h"
+#include "tests_lz.h"
+#include "tests_pixel.h"
+#include "tests_soft.h"
+#include "tests_blend.h"
 
 #include "tests_data.h"
+#include "tests_scenes.h"
+#include "tests_reload.h"
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
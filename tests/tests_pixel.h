@@ -0,0 +1,432 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_PIXEL_HH
+#define TEST_PIXEL_HH 1
+
+#include "pmgdlib_pixel.h"
+#include "pmgdlib_mip.h"
+#include "pmgdlib_atlas.h"
+#include "pmgdlib_resample.h"
+#include "pmgdlib_thread.h"
+
+#include <random>
+
+/// run fn at every level supported by the CPU, the level is restored after
+template<typename F> void for_simd_levels(F fn){
+  int level = simd_get_level();
+  for(int l = simd_level::SCALAR; l <= simd_detect(); ++l){
+    EXPECT_EQ(simd_set_level(l), l);
+    fn(l);
+  }
+  simd_set_level(level);
+}
+
+TEST(pmlib_pixel, kernels) {
+  std::mt19937 rng(42);
+  for(size_t n : {0, 1, 3, 7, 8, 9, 31, 1000}){
+    std::vector<uint8_t> rgba(n * 4), rgb(n * 3);
+    for(auto & v : rgba) v = rng();
+    for(auto & v : rgb) v = rng();
+    std::vector<float> fl(n * 4);
+    for(auto & v : fl) v = std::uniform_real_distribution<float>(-0.2f, 1.2f)(rng);
+    if(n) fl[0] = NAN;
+
+    std::vector<float> ref_f(n * 4);
+    std::vector<uint8_t> ref_8(n * 4), ref_rgb(n * 4), ref_swap(n * 4), ref_pre(n * 4);
+    simd_set_level(simd_level::SCALAR);
+    pixel_rgba8_to_rgba32f(rgba.data(), ref_f.data(), n);
+    pixel_rgba32f_to_rgba8(fl.data(), ref_8.data(), n);
+    pixel_rgb8_to_rgba8(rgb.data(), ref_rgb.data(), n);
+    pixel_swap_rb8(rgba.data(), ref_swap.data(), n);
+    pixel_premultiply8(rgba.data(), ref_pre.data(), n);
+
+    /// reference values
+    for(size_t i = 0; i < n; ++i){
+      EXPECT_FLOAT_EQ(ref_f[i * 4], rgba[i * 4] / 255.f);
+      EXPECT_EQ(ref_rgb[i * 4 + 2], rgb[i * 3 + 2]);
+      EXPECT_EQ(ref_rgb[i * 4 + 3], 255);
+      EXPECT_EQ(ref_swap[i * 4], rgba[i * 4 + 2]);
+      EXPECT_EQ(ref_pre[i * 4 + 1], int(std::round(rgba[i * 4 + 1] * rgba[i * 4 + 3] / 255.)));
+      EXPECT_EQ(ref_pre[i * 4 + 3], rgba[i * 4 + 3]);
+    }
+    if(n){ EXPECT_EQ(ref_8[0], 0); }
+
+    for_simd_levels([&](int level){
+      std::vector<float> f(n * 4);
+      std::vector<uint8_t> b8(n * 4), brgb(n * 4), bswap(rgba), bpre(n * 4);
+      pixel_rgba8_to_rgba32f(rgba.data(), f.data(), n);
+      pixel_rgba32f_to_rgba8(fl.data(), b8.data(), n);
+      pixel_rgb8_to_rgba8(rgb.data(), brgb.data(), n);
+      pixel_swap_rb8(bswap.data(), bswap.data(), n);
+      pixel_premultiply8(rgba.data(), bpre.data(), n);
+      EXPECT_EQ(f, ref_f) << simd_level_name(level) << " " << n;
+      EXPECT_EQ(b8, ref_8) << simd_level_name(level) << " " << n;
+      EXPECT_EQ(brgb, ref_rgb) << simd_level_name(level) << " " << n;
+      EXPECT_EQ(bswap, ref_swap) << simd_level_name(level) << " " << n;
+      EXPECT_EQ(bpre, ref_pre) << simd_level_name(level) << " " << n;
+    });
+  }
+}
+
+TEST(pmlib_pixel, convert) {
+  /// every 8 bit value survives RGBA8 -> float -> RGBA8 and sRGB -> linear -> sRGB
+  auto img = std::make_shared<Image>(64, 4);
+  for(int i = 0; i < 256 * 4; ++i) ((uint8_t*)img->data)[i] = i / 4;
+  for_simd_levels([&](int level){
+    auto fl = convert_image(img, image_format::RGBA, image_type::FLOAT);
+    ASSERT_NE(fl, nullptr);
+    EXPECT_EQ(((float*)fl->data)[255 * 4], 1.f);
+    auto back = convert_image(fl, image_format::RGBA, image_type::UNSIGNED_CHAR);
+    EXPECT_EQ(memcmp(back->data, img->data, img->Bytes()), 0);
+  });
+
+  Image linear(64, 4, image_format::RGBA, image_type::FLOAT), srgb(64, 4);
+  EXPECT_EQ(srgb_to_linear(img, linear), PM_SUCCESS);
+  EXPECT_NEAR(((float*)linear.data)[128 * 4], 0.2158605f, 1e-5);
+  EXPECT_EQ(linear_to_srgb(linear, srgb), PM_SUCCESS);
+  EXPECT_EQ(memcmp(srgb.data, img->data, img->Bytes()), 0);
+
+  /// RGB -> BGRA of a flipped sub-view
+  Image rgb(4, 2, image_format::RGB);
+  for(int i = 0; i < 24; ++i) ((uint8_t*)rgb.data)[i] = i;
+  EXPECT_EQ(rgb.Bytes(), 24);
+  auto bgra = convert_image(ImageView(rgb).Sub(1, 0, 2, 2).FlipY(), image_format::BGRA);
+  ASSERT_NE(bgra, nullptr);
+  uint8_t * p = (uint8_t*)bgra->data;
+  EXPECT_EQ(std::vector<uint8_t>(p, p + 8), std::vector<uint8_t>({17, 16, 15, 255, 20, 19, 18, 255}));
+
+  /// unsupported pairs and views with gaps between pixels
+  EXPECT_EQ(convert_image(img, image_format::RGB), nullptr);
+  EXPECT_EQ(convert_pixels(ImageView(*img).FlipX(), ImageView(*img)), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(convert_pixels(ImageView(*img).Sub(0, 0, 2, 2), ImageView(*img)), PM_ERROR_INCORRECT_ARGUMENTS);
+
+  auto pre = get_test_image();
+  ((float*)pre->data)[3] = 0.5f;
+  EXPECT_EQ(premultiply_alpha(pre), PM_SUCCESS);
+  EXPECT_EQ(((float*)pre->data)[0], 0.5f);
+  EXPECT_EQ(((float*)pre->data)[3], 0.5f);
+}
+
+TEST(pmlib_pixel, mips) {
+  EXPECT_EQ(mip_levels(4, 4), 3);
+  EXPECT_EQ(mip_levels(5, 1), 3);
+  EXPECT_EQ(mip_levels(1, 1), 1);
+
+  auto fill = [](std::shared_ptr<Image> img, std::vector<uint8_t> color){
+    for(int i = 0; i < img->w * img->h; ++i) memcpy((uint8_t*)img->data + 4 * i, color.data(), 4);
+  };
+  auto pixel = [](std::shared_ptr<Image> img){
+    uint8_t * p = (uint8_t*)img->data;
+    return std::vector<uint8_t>(p, p + 4);
+  };
+
+  /// flat color stays the same on every level with both filters
+  for(int filter : {mip_filter::BOX, mip_filter::KAISER}){
+    auto img = std::make_shared<Image>(16, 7);
+    fill(img, {200, 100, 50, 255});
+    EXPECT_EQ(make_mips(img, filter), PM_SUCCESS);
+    ASSERT_EQ(img->mips.size(), 4);
+    EXPECT_EQ(img->mips[0]->w, 8);
+    EXPECT_EQ(img->mips[0]->h, 3);
+    EXPECT_EQ(img->mips[3]->w, 1);
+    for(auto & mip : img->mips) EXPECT_EQ(pixel(mip), std::vector<uint8_t>({200, 100, 50, 255}));
+  }
+
+  /// black & white average in linear light, transparent pixels don't darken the color
+  auto checker = std::make_shared<Image>(2, 1);
+  fill(checker, {0, 0, 0, 255});
+  memset(checker->data, 255, 4);
+  EXPECT_EQ(make_mips(checker), PM_SUCCESS);
+  EXPECT_EQ(pixel(checker->mips[0]), std::vector<uint8_t>({188, 188, 188, 255}));
+  EXPECT_EQ(make_mips(checker, mip_filter::BOX, false), PM_SUCCESS);
+  EXPECT_EQ(pixel(checker->mips[0]), std::vector<uint8_t>({128, 128, 128, 255}));
+  fill(checker, {0, 255, 0, 0});
+  memcpy(checker->data, std::vector<uint8_t>({255, 0, 0, 255}).data(), 4);
+  EXPECT_EQ(make_mips(checker), PM_SUCCESS);
+  EXPECT_EQ(pixel(checker->mips[0]), std::vector<uint8_t>({255, 0, 0, 128}));
+
+  EXPECT_EQ(make_mips(checker, mip_filter::NONE), PM_SUCCESS);
+  EXPECT_EQ(checker->mips.size(), 0);
+  auto big = std::make_shared<Image>(64, 64, image_format::RGBA, image_type::FLOAT);
+  EXPECT_EQ(make_mips(big, mip_filter::BOX, true, 3), PM_SUCCESS);
+  EXPECT_EQ(big->mips.size(), 2);
+
+  /// row bands of large levels made from pool tasks, e.g. the disk cache in the ProtoBuilder prepare stage, while every worker is busy
+  auto large = std::make_shared<Image>(512, 512);
+  fill(large, {10, 20, 30, 255});
+  EXPECT_EQ(make_mips(large, mip_filter::KAISER), PM_SUCCESS);
+  std::vector<std::future<int>> tasks;
+  std::vector<std::shared_ptr<Image>> copies;
+  for(int i = 0; i < 2 * thread_pool().Size(); ++i){
+    copies.push_back(std::make_shared<Image>(512, 512));
+    fill(copies.back(), {10, 20, 30, 255});
+    tasks.push_back(thread_pool().Submit([img = copies.back()](){ return make_mips(img, mip_filter::KAISER); }));
+  }
+  for(int i = 0; i < tasks.size(); ++i){
+    ASSERT_EQ(tasks[i].wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    EXPECT_EQ(tasks[i].get(), PM_SUCCESS);
+    ASSERT_EQ(copies[i]->mips.size(), large->mips.size());
+    EXPECT_EQ(memcmp(copies[i]->mips[0]->data, large->mips[0]->data, large->mips[0]->Bytes()), 0);
+  }
+
+  /// every simd level gives the scalar result
+  std::mt19937 rng(3);
+  Image src(37, 19, image_format::RGBA, image_type::FLOAT);
+  for(int i = 0; i < 37 * 19 * 4; ++i) ((float*)src.data)[i] = std::uniform_real_distribution<float>(0, 1)(rng);
+  for(int filter : {mip_filter::BOX, mip_filter::KAISER}){
+    Image ref(18, 9, image_format::RGBA, image_type::FLOAT);
+    simd_set_level(simd_level::SCALAR);
+    EXPECT_EQ(mip_downsample(src, ref, filter), PM_SUCCESS);
+    for_simd_levels([&](int level){
+      Image dst(18, 9, image_format::RGBA, image_type::FLOAT);
+      EXPECT_EQ(mip_downsample(src, dst, filter), PM_SUCCESS);
+      for(int i = 0; i < 18 * 9 * 4; ++i) ASSERT_NEAR(((float*)dst.data)[i], ((float*)ref.data)[i], 1e-6) << simd_level_name(level) << " " << i;
+    });
+  }
+  Image wrong(19, 9, image_format::RGBA, image_type::FLOAT);
+  EXPECT_EQ(mip_downsample(src, wrong), PM_ERROR_INCORRECT_ARGUMENTS);
+}
+
+TEST(pmlib_pixel, atlas) {
+  MaxRectsBin bin(64, 64);
+  std::vector<AtlasRect> used;
+  AtlasRect r;
+  for(int i = 0; i < 16; ++i){
+    EXPECT_TRUE(bin.Insert(16, 16, r));
+    for(auto & u : used) EXPECT_FALSE(u.Intersects(r));
+    EXPECT_TRUE(AtlasRect({0, 0, 64, 64}).Contains(r));
+    used.push_back(r);
+  }
+  EXPECT_FALSE(bin.Insert(1, 1, r));
+  EXPECT_FLOAT_EQ(bin.Occupancy(), 1.f);
+
+  /// sprite i is filled with value i
+  std::mt19937 rng(5);
+  AtlasBuilder builder(128, 128, 2, 1);
+  std::vector<std::shared_ptr<Image>> sprites;
+  for(int i = 0; i < 60; ++i){
+    int w = std::uniform_int_distribution<int>(1, 30)(rng), h = std::uniform_int_distribution<int>(1, 30)(rng);
+    auto img = std::make_shared<Image>(w, h);
+    memset(img->data, i + 1, img->Bytes());
+    sprites.push_back(img);
+    EXPECT_EQ(builder.Add("s" + std::to_string(i), img), PM_SUCCESS);
+  }
+  EXPECT_EQ(builder.Add("s0", sprites[0]), PM_ERROR_DUPLICATE);
+  auto big = std::make_shared<Image>(200, 10);
+  EXPECT_EQ(builder.Add("big", big), PM_SUCCESS);
+  EXPECT_EQ(builder.Build(), 1);
+  EXPECT_EQ(builder.PageOf("big"), -1);
+  EXPECT_EQ(builder.Rect("big"), nullptr);
+  EXPECT_GT(builder.pages.size(), 1);
+
+  for(int i = 0; i < 60; ++i){
+    std::string name = "s" + std::to_string(i);
+    int page = builder.PageOf(name);
+    ASSERT_GE(page, 0);
+    const AtlasRect * rect = builder.Rect(name);
+    EXPECT_EQ(rect->w, sprites[i]->w);
+    EXPECT_EQ(rect->h, sprites[i]->h);
+    /// bleed stays inside the page, padding keeps sprites apart
+    EXPECT_TRUE(AtlasRect({1, 1, 126, 126}).Contains(*rect));
+    for(int j = 0; j < i; ++j){
+      std::string other = "s" + std::to_string(j);
+      if(builder.PageOf(other) != page) continue;
+      AtlasRect o = *builder.Rect(other);
+      EXPECT_FALSE(AtlasRect({rect->x - 2, rect->y - 2, rect->w + 4, rect->h + 4}).Intersects(o)) << name << " " << other;
+    }
+
+    ImageView view(builder.pages[page].image);
+    for(int y = rect->y - 1; y <= rect->y + rect->h; ++y)
+      for(int x = rect->x - 1; x <= rect->x + rect->w; ++x)
+        ASSERT_EQ(view.Pixel(x, y)[0], i + 1) << name << " " << x << " " << y;
+
+    TexTile * tile = builder.pages[page].atlas.Get(name);
+    ASSERT_NE(tile, nullptr);
+    EXPECT_FLOAT_EQ(tile->tpos.x, rect->x / 128.f);
+    EXPECT_FLOAT_EQ(tile->tpos.y, rect->y / 128.f);
+    EXPECT_FLOAT_EQ(tile->tsize.x, rect->w / 128.f);
+    EXPECT_FLOAT_EQ(tile->tsize.y, rect->h / 128.f);
+  }
+
+  /// later sprites go to new pages, sprites which did not fit are tried again, float pages convert 8 bit sprites
+  int n_pages = builder.pages.size();
+  EXPECT_EQ(builder.Add("late", sprites[0]), PM_SUCCESS);
+  EXPECT_EQ(builder.Build(), 1);
+  EXPECT_EQ(builder.PageOf("late"), n_pages);
+
+  AtlasBuilder fbuilder(32, 32);
+  fbuilder.type = image_type::FLOAT;
+  EXPECT_EQ(fbuilder.Add("a", sprites[0]), PM_SUCCESS);
+  EXPECT_EQ(fbuilder.Build(), 0);
+  const AtlasRect * rect = fbuilder.Rect("a");
+  EXPECT_FLOAT_EQ(ImageView(fbuilder.pages[0].image).At<float>(rect->x, rect->y)[0], 1 / 255.f);
+}
+
+/// records uploaded regions
+class TextureRecorder : public Texture {
+  public:
+  std::vector<AtlasRect> uploads;
+  void Bind(){}
+  void Unbind(){}
+  int Upload(const ImageView & view, int x = 0, int y = 0){
+    uploads.push_back(AtlasRect{x, y, view.w, view.h});
+    return PM_SUCCESS;
+  }
+};
+
+class AccelRecorder : public AccelFactory {
+  public:
+  std::vector<std::shared_ptr<TextureRecorder>> textures;
+  std::shared_ptr<Texture> MakeTexture(std::shared_ptr<Image> img){
+    textures.push_back(std::make_shared<TextureRecorder>());
+    return textures.back();
+  }
+};
+
+TEST(pmlib_pixel, dynamic_atlas) {
+  auto accel = std::make_shared<AccelRecorder>();
+  DynamicAtlas atlas(accel, 64, 64, 2);
+  auto glyph = [](int w, int h, int value){
+    auto img = std::make_shared<Image>(w, h);
+    memset(img->data, value, img->Bytes());
+    return img;
+  };
+
+  /// 15 x 15 items with padding take 16 x 16, so 16 items fill a page
+  std::vector<int> handles;
+  for(int i = 0; i < 32; ++i){
+    handles.push_back(atlas.Insert("g" + std::to_string(i), glyph(15, 15, i + 1)));
+    ASSERT_GE(handles.back(), 0);
+  }
+  EXPECT_EQ(atlas.Pages(), 2);
+  EXPECT_EQ(accel->textures.size(), 2);
+  EXPECT_EQ(atlas.Insert("g3", glyph(15, 15, 100)), handles[3]);
+  EXPECT_EQ(atlas.Find("g5"), handles[5]);
+  EXPECT_EQ(atlas.Find("none"), -1);
+
+  for(int i = 0; i < 32; ++i){
+    const TexTile * tile = atlas.Get(handles[i]);
+    ASSERT_NE(tile, nullptr);
+    ImageView page(atlas.PageImage(atlas.PageOf(handles[i])));
+    int x = std::lround(tile->tpos.x * 64), y = std::lround(tile->tpos.y * 64);
+    EXPECT_FLOAT_EQ(tile->tsize.x, 15 / 64.f);
+    EXPECT_EQ(page.Pixel(x, y)[0], i + 1);
+    EXPECT_EQ(page.Pixel(x + 14, y + 14)[3], i + 1);
+  }
+
+  /// only the written regions are uploaded, many of them as the bounding box
+  EXPECT_EQ(atlas.Flush(), PM_SUCCESS);
+  EXPECT_EQ(accel->textures[0]->uploads.size(), 16);
+  EXPECT_EQ(accel->textures[0]->uploads[0].w, 15);
+  EXPECT_EQ(atlas.Flush(), PM_SUCCESS);
+  EXPECT_EQ(accel->textures[0]->uploads.size(), 16);
+  atlas.max_dirty = 0;
+
+  /// items used in this frame are kept
+  EXPECT_EQ(atlas.Insert("new", glyph(15, 15, 200)), -1);
+  EXPECT_EQ(atlas.Evicted(), 0);
+
+  /// least recently used item goes first
+  atlas.NextFrame();
+  for(int i = 0; i < 32; ++i) if(i != 0){ EXPECT_TRUE(atlas.Touch(handles[i])); }
+  atlas.NextFrame();
+  int h = atlas.Insert("new", glyph(15, 15, 200));
+  ASSERT_GE(h, 0);
+  EXPECT_EQ(atlas.Evicted(), 1);
+  EXPECT_EQ(atlas.Get(handles[0]), nullptr);
+  EXPECT_FALSE(atlas.Touch(handles[0]));
+  EXPECT_NE(h, handles[0]);
+  EXPECT_EQ(atlas.Find("g0"), -1);
+  EXPECT_EQ(atlas.Size(), 32);
+  EXPECT_EQ(atlas.Flush(), PM_SUCCESS);
+  int page = atlas.PageOf(h);
+  auto & uploads = accel->textures[page]->uploads;
+  EXPECT_EQ(uploads.size(), 17);
+  EXPECT_EQ(uploads.back().w, 15);
+  EXPECT_EQ(uploads.back().h, 15);
+
+  /// larger item evicts several neighbours, removed items free space
+  atlas.NextFrame();
+  EXPECT_GE(atlas.Insert("wide", glyph(40, 15, 7)), 0);
+  EXPECT_GT(atlas.Evicted(), 1);
+  EXPECT_EQ(atlas.Remove(atlas.Find("wide")), PM_SUCCESS);
+  EXPECT_EQ(atlas.Find("wide"), -1);
+  EXPECT_EQ(atlas.Insert("big", glyph(80, 8, 1)), -1);
+}
+
+TEST(pmlib_pixel, resample) {
+  EXPECT_EQ(resample_filter_from_string("LANCZOS3"), resample_filter::LANCZOS3);
+  EXPECT_EQ(resample_filter_from_string("CUBIC"), resample_filter::NONE);
+
+  std::mt19937 rng(5);
+  auto random_image = [&](int w, int h, int format, int type){
+    auto img = std::make_shared<Image>(w, h, format, type);
+    size_t n = size_t(w) * h * image_channels(format);
+    for(size_t i = 0; i < n; ++i){
+      if(type == image_type::FLOAT) ((float*)img->data)[i] = std::uniform_real_distribution<float>(0, 1)(rng);
+      else ((uint8_t*)img->data)[i] = rng() % 256;
+    }
+    return img;
+  };
+
+  /// same size is an exact copy with every filter, colors of fully transparent pixels are not kept
+  auto src = random_image(13, 9, image_format::RGBA, image_type::UNSIGNED_CHAR);
+  for(int i = 0; i < 13 * 9; ++i) ((uint8_t*)src->data)[4 * i + 3] |= 1;
+  for(int filter : {resample_filter::BOX, resample_filter::BILINEAR, resample_filter::LANCZOS3}){
+    auto dst = std::make_shared<Image>(13, 9);
+    EXPECT_EQ(resample_image(ImageView(src), ImageView(dst), filter), PM_SUCCESS);
+    EXPECT_EQ(memcmp(dst->data, src->data, src->Bytes()), 0) << filter;
+  }
+
+  /// flat color stays the same when scaling up & down
+  auto flat = std::make_shared<Image>(21, 17);
+  for(int i = 0; i < 21 * 17; ++i) memcpy((uint8_t*)flat->data + 4 * i, std::vector<uint8_t>({200, 100, 50, 255}).data(), 4);
+  for(int filter : {resample_filter::BOX, resample_filter::BILINEAR, resample_filter::LANCZOS3}){
+    for(auto size : {std::pair<int, int>(5, 3), std::pair<int, int>(64, 40), std::pair<int, int>(1, 1)}){
+      auto dst = std::make_shared<Image>(size.first, size.second);
+      EXPECT_EQ(resample_image(ImageView(flat), ImageView(dst), filter), PM_SUCCESS);
+      for(int i = 0; i < dst->w * dst->h; ++i) EXPECT_EQ(memcmp((uint8_t*)dst->data + 4 * i, flat->data, 4), 0) << filter << " " << i;
+    }
+  }
+
+  /// box 2x downscale is the 2x2 average, bilinear 2x upscale of 2 pixels
+  Image quad(2, 2, image_format::RGB, image_type::FLOAT), one(1, 1, image_format::RGB, image_type::FLOAT);
+  for(int i = 0; i < 12; ++i) ((float*)quad.data)[i] = i;
+  EXPECT_EQ(resample_image(quad, one, resample_filter::BOX), PM_SUCCESS);
+  EXPECT_FLOAT_EQ(((float*)one.data)[0], 4.5f);
+  EXPECT_FLOAT_EQ(((float*)one.data)[2], 6.5f);
+  Image pair(2, 1, image_format::RGBA, image_type::FLOAT), line(4, 1, image_format::RGBA, image_type::FLOAT);
+  for(int i = 0; i < 8; ++i) ((float*)pair.data)[i] = i % 4 == 3 ? 1 : i / 4;
+  EXPECT_EQ(resample_image(pair, line, resample_filter::BILINEAR), PM_SUCCESS);
+  for(int x = 0; x < 4; ++x) EXPECT_FLOAT_EQ(((float*)line.data)[4 * x], std::vector<float>({0, 0.25, 0.75, 1})[x]) << x;
+
+  /// transparent pixel does not bleed its color into the opaque one
+  auto sprite = std::make_shared<Image>(2, 1), wide = std::make_shared<Image>(4, 1);
+  memcpy(sprite->data, std::vector<uint8_t>({255, 0, 0, 255,  0, 255, 0, 0}).data(), 8);
+  EXPECT_EQ(resample_image(ImageView(sprite), ImageView(wide), resample_filter::BILINEAR), PM_SUCCESS);
+  EXPECT_EQ(std::vector<uint8_t>((uint8_t*)wide->data, (uint8_t*)wide->data + 16),
+    std::vector<uint8_t>({255, 0, 0, 255,  255, 0, 0, 191,  255, 0, 0, 64,  0, 0, 0, 0}));
+
+  /// every simd level gives the scalar result
+  for(int type : {image_type::UNSIGNED_CHAR, image_type::FLOAT}){
+    auto big = random_image(67, 41, image_format::RGBA, type);
+    for(int filter : {resample_filter::BOX, resample_filter::BILINEAR, resample_filter::LANCZOS3}){
+      for(auto size : {std::pair<int, int>(23, 9), std::pair<int, int>(131, 97)}){
+        Image ref(size.first, size.second, image_format::RGBA, type), img(size.first, size.second, image_format::RGBA, type);
+        simd_set_level(simd_level::SCALAR);
+        EXPECT_EQ(resample_image(ImageView(big), ref, filter), PM_SUCCESS);
+        for_simd_levels([&](int level){
+          EXPECT_EQ(resample_image(ImageView(big), img, filter), PM_SUCCESS);
+          EXPECT_EQ(memcmp(img.data, ref.data, ImageView(ref).Bytes()), 0) << simd_level_name(level) << " " << filter << " " << type;
+        });
+      }
+    }
+  }
+
+  Image rgb8(4, 4, image_format::RGB), bgra(4, 4, image_format::BGRA);
+  EXPECT_EQ(resample_image(rgb8, rgb8), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(resample_image(ImageView(src), bgra), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(resample_image(ImageView(src), ImageView(flat), resample_filter::NONE), PM_ERROR_INCORRECT_ARGUMENTS);
+}
+
+#endif
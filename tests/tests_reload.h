@@ -0,0 +1,108 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_RELOAD_HH
+#define TEST_RELOAD_HH 1
+
+#include "pmgdlib_main.h"
+#include "tests_data.h"
+
+/// config with textures and drawers using them
+std::string reload_cfg(std::string t1_path, bool with_d2, bool with_t3){
+  std::string answer = R"(
+    <sys screen_width="64" screen_height="32"/>
+    <texture id="t1" image_path=")" + t1_path + R"("/>
+    <texture id="t2" image_path="t2.png"/>
+    <drawer id="d1" texture="t1"/>
+  )";
+  if(with_d2) answer += R"(<drawer id="d2" texture="t2"/>)";
+  if(with_t3) answer += R"(<texture id="t3" image_path="t3.png"/>)";
+  return answer;
+}
+
+TEST(pmlib_reload, reload) {
+  ProtoFixture fx;
+  auto accel = fx.accel;
+  Main main(reload_cfg("t1.png", true, false), fx.back);
+  main.verbose_lvl = verbose::SILENCE;
+  auto proto = [&main](std::string type, std::string id){ return main.Proto(NdKey({"default", type, id})); };
+  for(std::string id : {"t1", "t2"}) EXPECT_TRUE(proto("texture", id)->IsWarm()) << id;
+  for(std::string id : {"d1", "d2"}) EXPECT_TRUE(proto("drawer", id)->IsWarm()) << id;
+  EXPECT_EQ(accel->made.size(), 4);
+  std::map<std::string, std::shared_ptr<void>> objects;
+  for(std::string id : {"t1", "t2"}) objects[id] = proto("texture", id)->object;
+  for(std::string id : {"d1", "d2"}) objects[id] = proto("drawer", id)->object;
+
+  /// unchanged config builds nothing
+  EXPECT_EQ(main.Reload("default", reload_cfg("t1.png", true, false)), PM_SUCCESS);
+  EXPECT_EQ(accel->made.size(), 4);
+
+  /// modified texture is rebuilt with the drawer using it, the others are kept
+  EXPECT_EQ(main.Reload("default", reload_cfg("t1_new.png", true, false)), PM_SUCCESS);
+  EXPECT_EQ(accel->made.size(), 6);
+  EXPECT_NE(proto("texture", "t1")->object, objects["t1"]);
+  EXPECT_NE(proto("drawer", "d1")->object, objects["d1"]);
+  EXPECT_EQ(proto("texture", "t2")->object, objects["t2"]);
+  EXPECT_EQ(proto("drawer", "d2")->object, objects["d2"]);
+  EXPECT_EQ(proto("texture", "t1")->cfg_item->Attribute("image_path"), "t1_new.png");
+
+  /// removed object is cooled and dropped, added top level object is built
+  auto d2 = proto("drawer", "d2");
+  EXPECT_EQ(main.Reload("default", reload_cfg("t1_new.png", false, true)), PM_SUCCESS);
+  EXPECT_FALSE(d2->IsWarm());
+  EXPECT_EQ(proto("drawer", "d2"), nullptr);
+  ASSERT_NE(proto("texture", "t3"), nullptr);
+  EXPECT_TRUE(proto("texture", "t3")->IsWarm());
+  EXPECT_EQ(accel->made.size(), 7);
+  EXPECT_EQ(main.Get<Texture>("texture", "t3"), proto("texture", "t3")->object);
+
+  /// broken config keeps the old one
+  EXPECT_EQ(main.Reload("default", std::shared_ptr<Config>()), PM_ERROR);
+  EXPECT_NE(proto("texture", "t3"), nullptr);
+  EXPECT_EQ(main.Reload("default", R"({"texture": [{"id": "t1", "image_path": "t1_json.png"}], "drawer": )"), PM_ERROR);
+  EXPECT_EQ(proto("texture", "t1")->cfg_item->Attribute("image_path"), "t1_new.png");
+  EXPECT_NE(proto("texture", "t3"), nullptr);
+  EXPECT_TRUE(proto("texture", "t3")->IsWarm());
+  EXPECT_EQ(accel->made.size(), 7);
+}
+
+TEST(pmlib_reload, include_tree) {
+  /// change of an included file reloads the tree, items of the including file override included ones
+  auto dir = std::filesystem::temp_directory_path() / "pmgdlib_reload_test";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  auto write = [&dir](std::string name, std::string text){ std::ofstream(dir / name) << text; };
+  write("main.xml", R"(<include path="textures.xml"/> <texture id="t2" image_path="main.png"/>)");
+  write("textures.xml", R"(<texture id="t1" image_path="t1.png"/> <texture id="t2" image_path="t2.png"/>)");
+
+  ProtoFixture fx;
+  auto accel = fx.accel;
+  fx.back->txt_imp = std::make_shared<IoTxtMmap>();
+  Main main("<sys/>", fx.back);
+  main.verbose_lvl = verbose::SILENCE;
+  ASSERT_NE(main.AddCfgFile("level", (dir / "main.xml").string()), nullptr);
+  main.WatchCfg("level");
+  auto proto = [&main](std::string id){ return main.Proto(NdKey({"level", "texture", id})); };
+  ASSERT_NE(proto("t1"), nullptr);
+  ASSERT_NE(proto("t2"), nullptr);
+  EXPECT_EQ(proto("t2")->cfg_item->Attribute("image_path"), "main.png");
+  EXPECT_EQ(accel->made.size(), 2);
+  auto t1 = proto("t1")->object, t2 = proto("t2")->object;
+
+  /// overridden item is not touched by the reload
+  write("textures.xml", R"(<texture id="t1" image_path="t1_new.png"/> <texture id="t2" image_path="t2_new.png"/>)");
+  main.CheckReload();
+  EXPECT_EQ(proto("t1")->cfg_item->Attribute("image_path"), "t1_new.png");
+  EXPECT_NE(proto("t1")->object, t1);
+  EXPECT_EQ(proto("t2")->cfg_item->Attribute("image_path"), "main.png");
+  EXPECT_EQ(proto("t2")->object, t2);
+  EXPECT_EQ(accel->made.size(), 3);
+
+  /// missing include keeps the loaded tree
+  write("main.xml", R"(<include path="textures.xml"/> <include path="missing.xml"/>)");
+  main.CheckReload();
+  EXPECT_EQ(proto("t2")->cfg_item->Attribute("image_path"), "main.png");
+  EXPECT_EQ(accel->made.size(), 3);
+  std::filesystem::remove_all(dir);
+}
+
+#endif
@@ -0,0 +1,72 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_SCENES_HH
+#define TEST_SCENES_HH 1
+
+#include "pmgdlib_scenes.h"
+#include "tests_data.h"
+
+TEST(pmlib_scenes, scene_machine) {
+  ProtoFixture fx;
+  std::map<std::string, std::shared_ptr<ProtoObject>> objects;
+  auto add = [&](ConfigItem* father, std::string type, std::string id, std::map<std::string, std::string> attrs){
+    objects[id] = fx.Add(type, id, attrs, father);
+    return fx.items[id];
+  };
+
+  /// t1 is shared by both scenes
+  for(std::string id : {"t1", "t2", "t3"}) add(nullptr, "texture", id, {{"image_path", id + ".png"}});
+  ConfigItem* s1 = add(nullptr, "scene", "s1", {});
+  add(s1, "drawer", "d1", {{"texture", "t1"}});
+  add(s1, "drawer", "d2", {{"texture", "t2"}});
+  ConfigItem* s2 = add(nullptr, "scene", "s2", {});
+  add(s2, "drawer", "d3", {{"texture", "t3"}});
+  add(s2, "drawer", "d4", {{"texture", "t1"}});
+
+  auto cache = std::make_shared<ProtoCache>(std::make_shared<ProtoBuilder>(fx.back, fx.ndmap), std::vector<NdKey>{NdKey("default")});
+  SceneMachine sm(fx.ndmap, cache, {NdKey("default")});
+  sm.AddRule(SceneTransitionRule{"*", "*", true, true, 2});
+  std::vector<std::string> switches;
+  sm.on_switch = [&switches](const std::string & from, const std::string & to){ switches.push_back(from + "->" + to); };
+
+  EXPECT_EQ(sm.SceneObjects(objects["s1"]).size(), 5);
+
+  auto run = [&sm](std::function<bool()> until){
+    for(int i = 0; i < 1000 and not until(); ++i){
+      sm.Update();
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+  };
+
+  EXPECT_EQ(sm.Switch("s1"), PM_SUCCESS);
+  run([&sm](){ return sm.Active() == "s1"; });
+  EXPECT_EQ(sm.Active(), "s1");
+  EXPECT_NE(sm.ActiveScene(), nullptr);
+  for(std::string id : {"s1", "d1", "d2", "t1", "t2"}) EXPECT_TRUE(objects[id]->IsWarm()) << id;
+  EXPECT_FALSE(objects["t3"]->IsWarm());
+
+  /// prefetch in background, then switch in one frame
+  EXPECT_EQ(sm.Prefetch("s2"), PM_SUCCESS);
+  run([&sm](){ return sm.Progress("s2") == 1.f; });
+  EXPECT_EQ(sm.Progress("s2"), 1.f);
+  EXPECT_EQ(sm.Active(), "s1");
+  EXPECT_EQ(sm.Switch("s2"), PM_SUCCESS);
+  sm.Update();
+  EXPECT_EQ(sm.Active(), "s2");
+  EXPECT_EQ(switches, std::vector<std::string>({"->s1", "s1->s2"}));
+
+  /// objects of the previous scene are cooled except shared ones
+  for(std::string id : {"s2", "d3", "d4", "t1", "t3"}) EXPECT_TRUE(objects[id]->IsWarm()) << id;
+  for(std::string id : {"s1", "d1", "d2", "t2"}) EXPECT_FALSE(objects[id]->IsWarm()) << id;
+
+  EXPECT_TRUE(sm.InTransition());
+  sm.Update();
+  sm.Update();
+  EXPECT_FALSE(sm.InTransition());
+  EXPECT_EQ(sm.TransitionProgress(), 1.f);
+
+  sm.verbose_lvl = verbose::SILENCE;
+  EXPECT_EQ(sm.Switch("unknown"), PM_ERROR_404);
+}
+
+#endif
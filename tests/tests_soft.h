@@ -0,0 +1,151 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_SOFT_HH
+#define TEST_SOFT_HH 1
+
+#include "pmgdlib_soft.h"
+#include "pmgdlib_pixel.h"
+
+#include <random>
+
+/// pixel of RGBA8 image as vector
+std::vector<int> soft_pixel(std::shared_ptr<Image> img, int x, int y){
+  uint8_t * p = ImageView(img).Pixel(x, y);
+  return {p[0], p[1], p[2], p[3]};
+}
+
+std::shared_ptr<Image> soft_image(int w, int h, std::vector<uint8_t> pixels){
+  auto img = std::make_shared<Image>(w, h);
+  memcpy(img->data, pixels.data(), img->Bytes());
+  return img;
+}
+
+TEST(pmlib_soft, quads) {
+  /// full screen quad with 2 x 2 texture, v = 0 is the top row
+  auto tex = soft_image(2, 2, {255, 0, 0, 255,  0, 255, 0, 255,
+                               0, 0, 255, 255,  255, 255, 255, 128});
+  auto target = std::make_shared<Image>(8, 6);
+  soft_clear(ImageView(target), rgb(0.f, 0.f, 0.f, 1.f));
+  SoftQuad full = soft_quad(TextureDrawData(v2(0, 0), v2(1, 1)));
+  EXPECT_EQ(soft_draw_quads(ImageView(target), ImageView(tex), {full}), PM_SUCCESS);
+  EXPECT_EQ(soft_pixel(target, 0, 0), std::vector<int>({255, 0, 0, 255}));
+  EXPECT_EQ(soft_pixel(target, 7, 0), std::vector<int>({0, 255, 0, 255}));
+  EXPECT_EQ(soft_pixel(target, 0, 5), std::vector<int>({0, 0, 255, 255}));
+  /// 255 * 128 / 255 and 255 * (128 * 128 + 255 * 127) / 255 / 255
+  EXPECT_EQ(soft_pixel(target, 7, 5), std::vector<int>({128, 128, 128, 191}));
+
+  /// flip_x mirrors the texture, a quarter of the screen covers 4 x 3 pixels
+  TextureDrawData flipped(v2(-0.5, 0.5), v2(0.5, 0.5));
+  flipped.flip_x = true;
+  soft_clear(ImageView(target), rgb(0.f, 0.f, 0.f, 0.f));
+  EXPECT_EQ(soft_draw_quads(ImageView(target), ImageView(tex), {soft_quad(flipped)}), PM_SUCCESS);
+  EXPECT_EQ(soft_pixel(target, 0, 0), std::vector<int>({0, 255, 0, 255}));
+  EXPECT_EQ(soft_pixel(target, 3, 0), std::vector<int>({255, 0, 0, 255}));
+  EXPECT_EQ(soft_pixel(target, 4, 0), std::vector<int>({0, 0, 0, 0}));
+  EXPECT_EQ(soft_pixel(target, 0, 3), std::vector<int>({0, 0, 0, 0}));
+  int covered = 0;
+  for(int y = 0; y < 6; ++y) for(int x = 0; x < 8; ++x) covered += soft_pixel(target, x, y)[3] > 0;
+  EXPECT_EQ(covered, 12);
+
+  /// 90 degrees rotation of a square covers the same pixels
+  TextureDrawData rotated(v2(0, 0), v2(0.5, 0.5));
+  rotated.angle = 90;
+  auto square = std::make_shared<Image>(8, 8);
+  soft_clear(ImageView(square), rgb(0.f, 0.f, 0.f, 0.f));
+  EXPECT_EQ(soft_draw_quads(ImageView(square), ImageView(tex), {soft_quad(rotated)}), PM_SUCCESS);
+  covered = 0;
+  for(int y = 0; y < 8; ++y) for(int x = 0; x < 8; ++x) covered += soft_pixel(square, x, y)[3] > 0;
+  EXPECT_EQ(covered, 16);
+
+  Image wrong(2, 2, image_format::RGBA, image_type::FLOAT);
+  EXPECT_EQ(soft_draw_quads(wrong, ImageView(tex), {full}), PM_ERROR_INCORRECT_ARGUMENTS);
+}
+
+TEST(pmlib_soft, simd_and_tiles) {
+  /// random rotated & blended quads give the same result at every level and tile size
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uni(-1, 1);
+  auto tex = std::make_shared<Image>(13, 11);
+  for(int i = 0; i < tex->Bytes(); ++i) ((uint8_t*)tex->data)[i] = rng() % 256;
+  std::vector<SoftQuad> quads;
+  for(int i = 0; i < 40; ++i){
+    TextureDrawData data(v2(uni(rng), uni(rng)), v2(0.05 + 0.4 * std::fabs(uni(rng)), 0.05 + 0.4 * std::fabs(uni(rng))));
+    data.angle = 180 * uni(rng);
+    data.tpos = v2(0.3 * std::fabs(uni(rng)), 0.3 * std::fabs(uni(rng)));
+    data.tsize = v2(0.7, 0.7);
+    data.flip_y = i % 3 == 0;
+    quads.push_back(soft_quad(data));
+  }
+
+  auto render = [&](int tile){
+    auto target = std::make_shared<Image>(123, 77);
+    soft_clear(ImageView(target), rgb(0.2f, 0.4f, 0.6f, 1.f));
+    EXPECT_EQ(soft_draw_quads(ImageView(target), ImageView(tex), quads, tile), PM_SUCCESS);
+    return target;
+  };
+  simd_set_level(simd_level::SCALAR);
+  auto ref = render(1000);
+  for_simd_levels([&](int level){
+    for(int tile : {8, 32, 64}){
+      auto img = render(tile);
+      EXPECT_EQ(memcmp(img->data, ref->data, ref->Bytes()), 0) << simd_level_name(level) << " " << tile;
+    }
+  });
+}
+
+TEST(pmlib_soft, backend) {
+  SysOptions opts;
+  opts.screen_width = 32;
+  opts.screen_height = 16;
+  AccelFactorySoft accel;
+  EXPECT_EQ(accel.InitAccel(opts), PM_SUCCESS);
+  auto screen = accel.GetScreen();
+  EXPECT_EQ(soft_pixel(screen, 0, 0), std::vector<int>({0, 128, 128, 255}));
+
+  auto red = accel.MakeTexture(soft_image(1, 1, {255, 0, 0, 255}));
+  auto sheet = accel.MakeTexture(soft_image(2, 1, {255, 0, 0, 255,  0, 0, 255, 255}));
+  auto drawer = accel.MakeSimpleDrawer();
+
+  /// far quad is drawn first whatever the order of Add
+  TextureDrawData near(v2(0, 0, -0.5), v2(0.5, 0.5)), far(v2(0, 0, 0.5), v2(1, 1));
+  near.tsize = v2(0.5, 1);
+  far.tpos = v2(0.5, 0);
+  far.tsize = v2(0.5, 1);
+  unsigned int id_near = drawer->Add(&near);
+  drawer->Add(&far);
+  sheet->Bind();
+  drawer->Draw();
+  sheet->Unbind();
+  EXPECT_EQ(soft_pixel(screen, 16, 8), std::vector<int>({255, 0, 0, 255}));
+  EXPECT_EQ(soft_pixel(screen, 31, 15), std::vector<int>({0, 0, 255, 255}));
+
+  /// frame buffer target & its texture
+  auto fb = accel.MakeFrameBuffer(4, 4);
+  fb->SetClearColor(rgb(0.f, 0.f, 0.f, 0.f));
+  fb->Clear();
+  fb->Target();
+  drawer->Remove(id_near);
+  sheet->Bind();
+  drawer->Draw();
+  sheet->Unbind();
+  fb->Untarget();
+  auto fb_image = std::dynamic_pointer_cast<FrameBufferSoft>(fb)->GetImage();
+  EXPECT_EQ(soft_pixel(fb_image, 2, 2), std::vector<int>({0, 0, 255, 255}));
+
+  auto td = accel.MakeTextureDrawer();
+  td->texture = red.get();
+  td->data = TextureDrawData(v2(-0.75, 0.5), v2(0.25, 0.5));
+  td->Draw();
+  EXPECT_EQ(soft_pixel(screen, 1, 0), std::vector<int>({255, 0, 0, 255}));
+  EXPECT_EQ(soft_pixel(screen, 9, 0), std::vector<int>({0, 0, 255, 255}));
+
+  /// texture keeps its own pixels, Upload changes them
+  auto src = soft_image(2, 1, {1, 2, 3, 4, 5, 6, 7, 8});
+  auto tex = std::dynamic_pointer_cast<TextureSoft>(accel.MakeTexture(src));
+  ((uint8_t*)src->data)[0] = 100;
+  EXPECT_EQ(soft_pixel(tex->GetImage(), 0, 0)[0], 1);
+  EXPECT_EQ(tex->Upload(ImageView(soft_image(1, 1, {9, 9, 9, 9})), 1, 0), PM_SUCCESS);
+  EXPECT_EQ(soft_pixel(tex->GetImage(), 1, 0), std::vector<int>({9, 9, 9, 9}));
+}
+
+#endif
@@ -0,0 +1,47 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_TEMPLATE_HH
+#define TEST_TEMPLATE_HH 1
+
+#include "pmgdlib_template.h"
+#include "pmgdlib_config.h"
+
+TEST(pmlib_template, expand) {
+  TemplateProgram program;
+  EXPECT_EQ(program.Compile("<a x=\"${x * 32 + 16}\" name=\"${name}\" y=\"${-(y - 1) / 2}\" m=\"${7 % 3}\"/>"), PM_SUCCESS);
+  EXPECT_EQ(program.Expand({{"x", "2"}, {"name", "tile_1"}, {"y", "4"}}), "<a x=\"80\" name=\"tile_1\" y=\"-1.5\" m=\"1\"/>");
+
+  EXPECT_EQ(program.Compile("{% set w = 3 %}{% for i in 0..w %}<t i=\"${i}\" x=\"${i*w}\"/>{% endfor %}"), PM_SUCCESS);
+  EXPECT_EQ(program.Expand({}), "<t i=\"0\" x=\"0\"/><t i=\"1\" x=\"3\"/><t i=\"2\" x=\"6\"/>");
+
+  EXPECT_EQ(program.Compile("{% for i in 0..n step 2 %}{% for j in 0..2 %}${i}${j} {% endfor %}{% endfor %}"), PM_SUCCESS);
+  EXPECT_EQ(program.Expand({{"n", "5"}}), "00 01 20 21 40 41 ");
+
+  EXPECT_EQ(program.Compile("{% for i in 3..0 step -1 %}${i}{% endfor %}|{% for i in 0..0 %}${i}{% endfor %}"), PM_SUCCESS);
+  EXPECT_EQ(program.Expand({}), "321|");
+
+  program.verbose_lvl = verbose::SILENCE;
+  EXPECT_EQ(program.Compile("${1 + }"), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(program.Compile("${(1 + 2}"), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(program.Compile("{% for i in 0..2 %}"), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(program.Compile("{% endfor %}"), PM_ERROR_INCORRECT_ARGUMENTS);
+  EXPECT_EQ(program.Compile("${x"), PM_ERROR_INCORRECT_ARGUMENTS);
+}
+
+TEST(pmlib_template, cache) {
+  EXPECT_FALSE(is_template("<a x=\"1\"/>"));
+  EXPECT_TRUE(is_template("<a x=\"${1}\"/>"));
+
+  auto program_a = compile_template("<a x=\"${x}\"/>");
+  auto program_b = compile_template("<a x=\"${x}\"/>");
+  EXPECT_NE(program_a, nullptr);
+  EXPECT_EQ(program_a, program_b);
+  EXPECT_EQ(program_a->Expand({{"x", "5"}}), "<a x=\"5\"/>");
+
+  Config cfg;
+  cfg.SetTemplateVar("x", "7");
+  EXPECT_EQ(cfg.ProcessTemplate("<a x=\"${x + 1}\"/>"), "<a x=\"8\"/>");
+  EXPECT_EQ(cfg.ProcessTemplate("<a x=\"1\"/>"), "<a x=\"1\"/>");
+}
+
+#endif
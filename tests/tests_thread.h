@@ -0,0 +1,55 @@
+// P.~Mandrik, 2025, https://github.com/pmandrik/pmgdlib
+
+#ifndef TEST_THREAD_HH
+#define TEST_THREAD_HH 1
+
+#include <atomic>
+#include "pmgdlib_thread.h"
+
+TEST(pmlib_thread, thread_pool) {
+  ThreadPool pool(4);
+  EXPECT_EQ(pool.Size(), 4);
+
+  std::vector<std::future<int>> futures;
+  for(int i = 0; i < 100; i++)
+    futures.push_back(pool.Submit([i](){ return i*i; }));
+  for(int i = 0; i < 100; i++)
+    EXPECT_EQ(futures[i].get(), i*i);
+
+  std::atomic<int> counter = 0;
+  for(int i = 0; i < 100; i++)
+    pool.Submit([&counter](){ counter++; });
+  pool.Wait();
+  EXPECT_EQ(counter, 100);
+}
+
+TEST(pmlib_thread, parallel_for) {
+  std::vector<int> data(1000, 0);
+  parallel_for(thread_pool(), 0, data.size(), [&data](int i_start, int i_end){
+    for(int i = i_start; i < i_end; ++i) data[i] += i;
+  }, 64);
+  for(int i = 0; i < (int)data.size(); i++)
+    EXPECT_EQ(data[i], i);
+
+  /// from inside pool tasks, helpers queued behind the busy workers are not waited for
+  ThreadPool pool(1);
+  std::vector<int> nested(1000, 0);
+  auto task = pool.Submit([&](){
+    parallel_for(pool, 0, nested.size(), [&nested](int i_start, int i_end){
+      for(int i = i_start; i < i_end; ++i) nested[i] += i;
+    }, 64);
+  });
+  ASSERT_EQ(task.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  for(int i = 0; i < (int)nested.size(); i++) EXPECT_EQ(nested[i], i);
+
+  std::atomic<int> sum = 0;
+  std::vector<std::future<void>> tasks;
+  for(int t = 0; t < 2 * thread_pool().Size(); ++t)
+    tasks.push_back(thread_pool().Submit([&sum](){
+      parallel_for(thread_pool(), 0, 256, [&sum](int i_start, int i_end){ sum += i_end - i_start; }, 16);
+    }));
+  for(auto & t : tasks) ASSERT_EQ(t.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+  EXPECT_EQ(sum, 2 * thread_pool().Size() * 256);
+}
+
+#endif